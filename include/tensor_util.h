@@ -130,6 +130,18 @@ uint32cmp(
         );
 
 
+/**
+ * @brief A function for reading a monotonic wall-clock time.
+ *
+ * @return The current time in seconds, only the difference between two calls
+ * is meaningful.
+ *
+ */
+double
+get_wtime(
+        );
+
+
 
 #ifdef __CPLUSPLUS
 }
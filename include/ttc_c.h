@@ -31,6 +31,15 @@ typedef enum ttc_opt_status ttc_opt_status_e;
 /// @brief typedef for replacing enum ttc_opt_type
 typedef enum ttc_opt_type ttc_opt_type_e;
 
+/// @brief typedef for replacing enum ttc_residency
+typedef enum ttc_residency ttc_residency_e;
+
+/// @brief typedef for replacing enum ttc_store
+typedef enum ttc_store ttc_store_e;
+
+/// @brief typedef for replacing enum ttc_engine
+typedef enum ttc_engine ttc_engine_e;
+
 
 // typedef union
 /// @brief typedef for replacing union ttc_float
@@ -41,6 +50,9 @@ typedef union ttc_float ttc_float_u;
 /// @brief typedef for replacing struct ttc_param
 typedef struct ttc_param ttc_param_s;
 
+/// @brief typedef for replacing struct ttc_param64
+typedef struct ttc_param64 ttc_param64_s;
+
 /// @brief typedef for replacing struct ttc_plan
 typedef struct ttc_plan ttc_plan_s;
 
@@ -50,6 +62,15 @@ typedef struct ttc_opt ttc_opt_s;
 /// @brief typedef for replacing struct ttc_handler
 typedef struct ttc_handler ttc_handler_s;
 
+/// @brief typedef for replacing struct ttc_tune
+typedef struct ttc_tune ttc_tune_s;
+
+/// @brief typedef for replacing struct ttc_hw
+typedef struct ttc_hw ttc_hw_s;
+
+/// @brief typedef for replacing struct ttc_estimate
+typedef struct ttc_estimate ttc_estimate_s;
+
 
 /* ======== Enumeration definition ======== */
 
@@ -123,6 +144,70 @@ enum ttc_arch {
 };
 
 
+/**
+ * @brief Enumeration for the cache residency of the tensors when a
+ * transposition is called.
+ * @details Used for selecting the kernel variant of a plan with
+ * `ttc_param.residency`. The hot variant is compiled with `--hotA --hotB`
+ * and without streaming stores, the cold variant with streaming stores. The
+ * variants are compiled when they are used for the first time.
+ *
+ * @sa struct ttc_param, typedef struct ttc_param ttc_param_s
+ *
+ */
+enum ttc_residency {
+    TTC_RES_NONE    = 0,    ///< Use the plan created with handler's options.
+    TTC_RES_AUTO    = 1,    ///< Hot if the tensors fit in the last level cache.
+    TTC_RES_HOT     = 2,    ///< The input was just produced and is in cache.
+    TTC_RES_COLD    = 3     ///< The input is in main memory.
+};
+
+
+/**
+ * @brief Enumeration for the stores of the output when a transposition is
+ * called.
+ * @details Used for choosing between regular and streaming (non-temporal)
+ * stores with `ttc_param.store`. Streaming stores bypass the caches, which
+ * pays off if the output does not fit in the last level cache or is not
+ * read again soon. A kernel of TTC is compiled with or without
+ * `--use-streamingStores`, the kernel of the other kind is compiled when it
+ * is needed for the first time. The built-in engines decide per call.
+ *
+ * @sa struct ttc_param, typedef struct ttc_param ttc_param_s
+ *
+ */
+enum ttc_store {
+    TTC_STORE_AUTO      = 0,    ///< Stream if B exceeds the last level cache.
+    TTC_STORE_CACHED    = 1,    ///< B is read again soon, regular stores.
+    TTC_STORE_STREAM    = 2     ///< B is not read again soon, stream it.
+};
+
+
+/**
+ * @brief Enumeration for the engines executing a plan.
+ * @details Used for specifying `ttc_opt.engine`, and reported by
+ * ttc_estimate. With TTC_ENGINE_AUTO, the performance model chooses the
+ * engine of a new plan: a plain copy if the transposition is an identity
+ * copy, a kernel generated by TTC if the generation cost is amortized by
+ * the expected calls, otherwise the generic kernel of this library. A
+ * permutation scattering every dimension is run in two passes through a
+ * scratch tensor if their locality is much better. A plan of the generic
+ * kernel cut into square blocks times its first calls against the
+ * recursive kernel and keeps the faster one.
+ *
+ * @sa struct ttc_opt, ttc_estimate
+ *
+ */
+enum ttc_engine {
+    TTC_ENGINE_AUTO         = 0,    ///< Chosen by the performance model.
+    TTC_ENGINE_JIT          = 1,    ///< A kernel generated by TTC.
+    TTC_ENGINE_GENERIC      = 2,    ///< The generic kernel of this library.
+    TTC_ENGINE_COPY         = 3,    ///< A plain copy, only identity copies.
+    TTC_ENGINE_RECURSIVE    = 4,    ///< The recursive kernel of this library.
+    TTC_ENGINE_MULTIPASS    = 5     ///< The generic kernel in two passes.
+};
+
+
 /**
  * @brief Enumeration for definition different thread block size when
  * using CUDA architecture.
@@ -161,7 +246,8 @@ enum ttc_opt_status {
     TTC_NO_ALIGN        = 0x4,
     /**<
      * `--no-align`: Prevent using of aligned load/store instructions
-     * (use this if your arrays are not aligned).
+     * in the first kernel of a plan. The kernel of the other kind is
+     * compiled when a call needs it, so unaligned arrays are always safe.
      */
 
     TTC_NO_VEC          = 0x8,
@@ -260,12 +346,55 @@ enum ttc_opt_type {
      * @sa enum ttc_thread_blk, typedef enum ttc_thread_blk ttc_thread_blk_e
      */
 
-    TTC_OPT_STATUS
+    TTC_OPT_STATUS,
     /**<
      * Other options without value. The `value` is set by bitwise OR on
      * the values in ttc_opt_status_e.
      * @sa enum ttc_opt_status, typedef enum ttc_opt_status ttc_opt_status_e
      */
+
+    TTC_OPT_TIME_BUDGET,
+    /**<
+     * Wall-clock budget in milliseconds for the implementation search of a
+     * new plan. Default: 0 (no budget). The related `value` must be an
+     * `uint32_t` type object, `length` will be omitted.
+     * @sa struct ttc_opt
+     */
+
+    TTC_OPT_TUNE_DB,
+    /**<
+     * Path of the tuning database written by ttc_autotune. Default: the
+     * environment variable `TTC_TUNE_DB`, or
+     * `ttc_transpositions/ttc_tuning.csv` if it is not set. The records in
+     * the file are loaded into the handler when it is set. The `value` must
+     * be a pointer pointing to the first character in a string, the `length`
+     * is the length of this string.
+     * @sa ttc_autotune, struct ttc_tune
+     */
+
+    TTC_OPT_RETUNE,
+    /**<
+     * Threshold in percent for re-tuning plans in the background. Default: 0
+     * (disabled). The related `value` must be an `uint32_t` type object,
+     * `length` will be omitted.
+     * @sa struct ttc_opt
+     */
+
+    TTC_OPT_ENGINE,
+    /**<
+     * The engine of new plans. Default: TTC_ENGINE_AUTO. The `value` must be
+     * a pointer pointing to a ttc_engine_e object, the `length` will be
+     * omitted.
+     * @sa enum ttc_engine, typedef enum ttc_engine ttc_engine_e
+     */
+
+    TTC_OPT_GRID
+    /**<
+     * Edge in elements of the tiles of new plans of TTC. Default: 0 (a
+     * kernel per size). The related `value` must be an `uint32_t` type
+     * object, `length` will be omitted.
+     * @sa struct ttc_opt
+     */
 };
 
 
@@ -384,6 +513,79 @@ struct ttc_param {
     /**<
      * The dimension of the tensor to be transposed.
      */
+
+    // Non-signature members added later, kept last so that the members
+    // above keep their offsets
+    ttc_residency_e residency;
+    /**<
+     * The cache residency hint of this call, it selects the kernel variant of
+     * the plan. Default: TTC_RES_NONE.
+     * @sa enum ttc_residency
+     */
+
+    ttc_store_e     store;
+    /**<
+     * The store hint of this call, it selects streaming stores for the
+     * output. It is used if `residency` is TTC_RES_NONE, the residency
+     * variants choose their stores themselves. Default: TTC_STORE_AUTO.
+     * @sa enum ttc_store
+     */
+};
+
+
+/**
+ * @brief Struct for the parameters of a transposition with 64-bit sizes.
+ *
+ * @details The members have the meaning of the ones of struct ttc_param, but
+ * `size`, `lda` and `ldb` are 64-bit arrays, for tensors of more than 2^31
+ * elements or with larger leading dimensions. It is only used by
+ * ttc_transpose64.
+ *
+ * @sa struct ttc_param, ttc_transpose64
+ *
+ */
+struct ttc_param64 {
+    ttc_float_u     alpha;
+    ///< The alpha in the general form formula.
+
+    ttc_float_u     beta;
+    ///< The beta in the general form formula.
+
+    int64_t         *lda;
+    /**<
+     * Leading dimension of each dimension of the input tensor. It must be
+     * either an empty pointer, or `int64_t` type array whose length is `dim`.
+     */
+
+    int64_t         *ldb;
+    /**<
+     * Leading dimension of each dimension of the output tensor. It must be
+     * either an empty pointer, or `int64_t` type array whose length is `dim`.
+     */
+
+    ttc_datatype_e  datatype;
+    ///< The data type.
+
+    uint32_t        *perm;
+    ///< The permutation, a `uint32_t` type array whose length is `dim`.
+
+    uint64_t        *size;
+    /**<
+     * The size in each dimension of the origin tensor, a `uint64_t` type
+     * array whose length is `dim`.
+     */
+
+    uint32_t        *loop_perm;
+    ///< The loop order, either an empty pointer or an array of length `dim`.
+
+    uint32_t        dim;
+    ///< The dimension of the tensor to be transposed.
+
+    ttc_residency_e residency;
+    ///< The cache residency hint of this call.
+
+    ttc_store_e     store;
+    ///< The store hint of this call.
 };
 
 
@@ -425,10 +627,80 @@ struct ttc_plan {
         const int32_t   *lda,
         const int32_t   *ldb,
         const int32_t   *size,
-        int32_t         total_size
+        int64_t         total_size
         );
     ///< A function pointer pointing to the CUDA transposition algorithms.
 
+    uint64_t    num_calls;
+    ///< The number of executions of the plan, updated atomically.
+
+    double      exec_time;
+    ///< The accumulated execution time in seconds, updated atomically.
+
+    void        *retune;
+    /**< The background re-tuning job of the plan, a null pointer if none. A
+     * job is claimed with a compare-and-swap before its thread starts.
+     */
+
+    ttc_plan_s  *hot_plan;
+    ///< The variant for hot cache, created on first use of TTC_RES_HOT.
+
+    ttc_plan_s  *cold_plan;
+    ///< The variant for cold cache, created on first use of TTC_RES_COLD.
+
+    ttc_plan_s  *store_plan;
+    /**< The variant with the other kind of stores (TTC_USE_STM_STORE in
+     * `status`), created on first use.
+     * @sa enum ttc_store
+     */
+
+    ttc_plan_s  *align_plan;
+    /**< The variant with the other kind of loads and stores (TTC_NO_ALIGN in
+     * `status`), created on first use by a call of the other alignment.
+     */
+
+    uint32_t    status;
+    /**< The bits of ttc_opt_status_e `fn` was compiled with.
+     * @sa enum ttc_opt_status, typedef enum ttc_opt_status ttc_opt_status_e
+     */
+
+    ttc_engine_e engine;
+    /**< The engine executing the plan. Only TTC_ENGINE_JIT plans have `fn`,
+     * the others run on `param`.
+     * @sa enum ttc_engine
+     */
+
+    uint32_t    num_probes;
+    /**< The number of calls left for timing TTC_ENGINE_GENERIC against
+     * TTC_ENGINE_RECURSIVE. The calls alternate between both engines, then
+     * `engine` is set to the faster one. It is updated atomically, as are
+     * `probe_time` and `engine`, so that a plan can be executed by several
+     * threads at once.
+     */
+
+    double      probe_time[2];
+    /**< The best time in seconds of TTC_ENGINE_GENERIC and
+     * TTC_ENGINE_RECURSIVE during the probe.
+     */
+
+    void        *scratch;
+    /**< The scratch tensor of a TTC_ENGINE_MULTIPASS plan, allocated at the
+     * first call. A call takes it for its duration, a concurrent call
+     * allocates its own and frees it unless the plan has none.
+     */
+
+    uint32_t    *body_size;
+    /**< The sizes of the aligned main body transposed by `fn`, the remainder
+     * slabs are transposed by the generic kernel. A null pointer if `fn`
+     * transposes the whole tensor.
+     */
+
+    uint32_t    *tile;
+    /**< The sizes of a tile of a grid plan (see ttc_opt::grid), `fn` is
+     * called on every tile of `body_size`. A null pointer if `fn` transposes
+     * the body at once.
+     */
+
     ttc_plan_s  *next;
     ///< Next pointer for linked list.
 };
@@ -507,6 +779,208 @@ struct ttc_opt {
     /**< Other options without value. It is set by bitwise OR.
      * @sa enum ttc_opt_status, typedef enum ttc_opt_status ttc_opt_status_e
      */
+
+    char                *tune_db;
+    /**< Path of the tuning database. If it is a null pointer, the default
+     * path `ttc_transpositions/ttc_tuning.csv` is used.
+     * @sa ttc_autotune
+     */
+
+    uint32_t            time_budget;
+    /**< Wall-clock budget in milliseconds for the implementation search,
+     * 0 means no budget. With a budget, the search is run in stages with an
+     * increasing `--maxImplementations=` (1, 4, 16, ...; bounded by
+     * `max_impl` if it is set), so that the candidates TTC ranks as the most
+     * promising are measured first. A stage that would exceed the budget is
+     * stopped, and the best kernel of the last finished stage is used. The
+     * first stage always runs to the end, so that a plan can be created.
+     */
+
+    uint32_t            retune;
+    /**< Threshold in percent for re-tuning, 0 disables it. When the observed
+     * bandwidth of a plan (see ttc_plan::num_calls and ttc_plan::exec_time)
+     * drops below this percentage of the best bandwidth of the comparable
+     * plans (same data type and dimension) or tuning records, the plan is
+     * tuned once in a background thread on scratch buffers. A faster kernel
+     * replaces the plan's kernel atomically, the calls in flight still finish
+     * with the old one.
+     */
+
+    ttc_engine_e        engine;
+    /**< The engine of new plans. TTC_ENGINE_COPY is only used for identity
+     * copies, other transpositions fall back to TTC_ENGINE_GENERIC.
+     * Plans created from tuning records and plans of the CUDA architecture
+     * always use TTC_ENGINE_JIT.
+     * @sa enum ttc_engine, typedef enum ttc_engine ttc_engine_e
+     */
+
+    uint32_t            grid;
+    /**< Edge in elements of the tiles of new plans of TTC, 0 disables the
+     * tiling. With tiles, TTC generates a single-threaded kernel of a tile
+     * instead of a kernel of the size, and the plan calls it on a parallel
+     * grid of tiles with the extents of the tensors as `lda` and `ldb`. A
+     * tile spans `grid` elements (or the largest power of two of the size
+     * below it) along the input dimensions 0 and `perm[0]`, and the other
+     * dimensions up to TTC_GRID_ELEMS elements in total, so that a
+     * permutation only has a few tile kernels whatever the sizes are. The
+     * plans of the handler share a tile kernel, and the edge tiles are
+     * transposed by the generic kernel. Tuning records of the size are still
+     * preferred.
+     */
+};
+
+
+/**
+ * @brief Struct for a tuning record.
+ *
+ * @details A tuning record stores the best known TTC configuration of one
+ * signature (`datatype`, `perm` and `size`, see also struct ttc_param). The
+ * records are created by ttc_autotune, saved in a tuning database (a CSV
+ * file, one record per line) and consulted by ttc_plan when a new plan is
+ * created. A line of the database looks like:
+ *
+ * @code
+ * # datatype,perm,size,loop_perm,num_threads,blocking,pref_dist,status,
+ * # bandwidth,max_impl
+ * 1,0:2:1,256:128:64,-,8,16x16,5,32,21.5,1
+ * @endcode
+ *
+ * where `-` means the value is chosen by TTC. The last column is optional and
+ * defaults to 1. When several records of a signature are loaded, the one with
+ * the highest bandwidth is kept. The database is loaded from the path in the
+ * environment variable `TTC_TUNE_DB` if it is set, otherwise from the default
+ * path.
+ *
+ * @sa ttc_autotune, struct ttc_handler, typedef struct ttc_handler
+ * ttc_handler_s
+ *
+ */
+struct ttc_tune {
+    ttc_datatype_e  datatype;
+    ///< The data type of the signature.
+
+    uint32_t        dim;
+    ///< The dimension of the signature.
+
+    uint32_t        *perm;
+    ///< The permutation of the signature, its length is `dim`.
+
+    uint32_t        *size;
+    ///< The size of the signature, its length is `dim`.
+
+    uint32_t        *loop_perm;
+    ///< The loop order, a null pointer means it is chosen by TTC.
+
+    uint32_t        num_threads;
+    ///< The number of threads, 0 means the handler's option is used.
+
+    uint32_t        blocking[2];
+    ///< The blocking, 0x0 means it is chosen by TTC.
+
+    int32_t         pref_dist;
+    ///< The prefetch distance, a negative value means it is chosen by TTC.
+
+    uint32_t        status;
+    ///< The tuned bits of ttc_opt_status_e, i.e. TTC_USE_STM_STORE.
+
+    uint32_t        max_impl;
+    ///< The number of implementations searched by TTC, 0 means all.
+
+    double          bandwidth;
+    ///< The measured bandwidth in GB/s.
+
+    ttc_tune_s      *next;
+    ///< Next pointer for linked list.
+};
+
+
+/**
+ * @brief Struct for the detected hardware properties.
+ *
+ * @details It is filled by ttc_init and used by the heuristics of the
+ * library. The bandwidth curves are filled by ttc_calibrate, or loaded by
+ * ttc_init from the calibration file of the CPU model if it exists. All the
+ * bandwidths are in GB/s.
+ *
+ * @sa struct ttc_handler, typedef struct ttc_handler ttc_handler_s,
+ * ttc_calibrate
+ *
+ */
+struct ttc_hw {
+    uint64_t    l1_size;
+    ///< The size of the level 1 data cache in bytes.
+
+    uint64_t    l2_size;
+    ///< The size of the level 2 cache in bytes.
+
+    uint64_t    llc_size;
+    ///< The size of the last level cache in bytes.
+
+    uint32_t    num_cores;
+    ///< The number of online logical cores.
+
+    double      bandwidth;
+    /**< The memory bandwidth of a copy by one thread, counting both the read
+     * and the written bytes. It is measured when it is needed for the first
+     * time if the machine is not calibrated, 0 means not measured yet.
+     */
+
+    uint32_t    num_points;
+    ///< The number of points of the bandwidth curves, 0 if not calibrated.
+
+    uint32_t    *threads;
+    ///< The thread numbers of the points, in increasing order.
+
+    double      *read_bw;
+    ///< The read bandwidth of every point.
+
+    double      *write_bw;
+    ///< The write bandwidth of every point.
+
+    double      *copy_bw;
+    ///< The copy bandwidth of every point, counting read and written bytes.
+
+    uint32_t    num_nodes;
+    ///< The number of NUMA nodes.
+
+    double      *node_bw;
+    /**< The copy bandwidth of every NUMA node with all its cores, a null
+     * pointer if not calibrated.
+     */
+};
+
+
+/**
+ * @brief Struct for the predicted cost of a transposition.
+ *
+ * @details It is filled by ttc_estimate without executing the
+ * transposition.
+ *
+ * @sa ttc_estimate
+ *
+ */
+struct ttc_estimate {
+    ttc_engine_e    engine;
+    ///< The engine the handler uses for the transposition.
+
+    double          bytes;
+    /**< The bytes moved from and to memory, the output is counted twice if
+     * `beta` is not zero.
+     */
+
+    double          time;
+    ///< The predicted time of one call in seconds.
+
+    double          setup;
+    /**< The predicted one-time cost in seconds before the first call, i.e.
+     * the kernel generation of TTC_ENGINE_JIT. It is 0 if the plan exists.
+     */
+
+    double          bandwidth;
+    /**< The effective bandwidth in GB/s, i.e. the bytes of the transposition
+     * itself (without the scratch tensor of TTC_ENGINE_MULTIPASS) over
+     * `time`. It is measured if the plan exists and has been executed.
+     */
 };
 
 
@@ -527,6 +1001,12 @@ struct ttc_handler {
 
     ttc_plan_s  *plans;
     ///< A list of plans that used for performing transpositions.
+
+    ttc_tune_s  *tunes;
+    ///< A list of tuning records consulted when creating new plans.
+
+    ttc_hw_s    hw;
+    ///< The hardware properties of the machine.
 };
 
 
@@ -569,7 +1049,8 @@ ttc_release(
  * @brief A function for generating a default ttc_param_s object.
  *
  * @details It will generate a ttc_param_s object, whose value is:
- * { .alpha.s = 1.0, .beta.s = 0.0, .lda = NULL, .ldb = NULL, .perm = NULL,
+ * { .alpha.s = 1.0, .beta.s = 0.0, .lda = NULL, .ldb = NULL,
+ *  .residency = TTC_RES_NONE, .store = TTC_STORE_AUTO, .perm = NULL,
  *  .size = NULL, .loop_perm = NULL, .dim = 0 }
  *
  * @sa struct ttc_param, typedef struct ttc_param ttc_param_s
@@ -616,6 +1097,14 @@ ttc_set_opt(
  * If so, then executes the plan directly. If not, it will create a new plan and
  * save it in the handler.
  *
+ * The input and result may overlap (except with CUDA). If both tensors are
+ * dense, have the same precision and `result` starts a whole number of
+ * elements away from `input` (or at `input`), the transposition runs within
+ * their memory without a plan, with an auxiliary bitmap of one bit per
+ * element of both tensors (see ttc_engine_inplace). Other overlapping tensors
+ * are transposed from a temporary copy of the input, which needs as much
+ * memory as the input.
+ *
  * @param[in,out]   handler A pointer pointing to a TTC handler.
  * @param[in]       param   A parameter describing the transposition. Stored in
  * host memory when using CUDA.
@@ -642,6 +1131,277 @@ ttc_transpose(
         const void          *input,
         void                *result
         );
+
+
+/**
+ * @brief A function for executing a transposition with 64-bit sizes.
+ *
+ * @details If every size fits in `uint32_t` and every leading dimension in
+ * `int32_t`, the parameters are narrowed and passed to ttc_transpose, so the
+ * call uses the plans of the handler. Otherwise the kernels of TTC cannot
+ * address the tensors (their leading dimensions are `int`), and the
+ * transposition runs on the generic engine of the library, which indexes
+ * with 64-bit strides. Overlapping tensors are transposed from a temporary
+ * copy of the input in that case. Tensors of more than 2^31 elements given to
+ * ttc_transpose use the built-in engines for the same reason.
+ *
+ * @param[in,out]   handler A pointer pointing to a TTC handler.
+ * @param[in]       param   A parameter describing the transposition.
+ * @param[in]       input   A pointer pointing to the input tensor.
+ * @param[out]      result  A pointer pointing to a piece of memory for storing
+ * result.
+ *
+ * @return The status, -1 if the function parameters are not correct (e.g.
+ * `param` is null, or a wide leading dimension is smaller than its size), the
+ * `errno` if some internal error happens, or 0 if succeed.
+ *
+ * @sa struct ttc_param64, ttc_transpose
+ *
+ */
+int32_t
+ttc_transpose64(
+        ttc_handler_s           *handler,
+        const ttc_param64_s     *param,
+        const void              *input,
+        void                    *result
+        );
+
+
+/**
+ * @brief A function for tuning the plan of a transposition.
+ *
+ * @details It creates candidate plans with different TTC configurations:
+ * streaming stores, blockings, prefetch distances, loop orders and thread
+ * numbers are swept one after another, each keeping the best value found so
+ * far. Every candidate is timed on the given buffers, both with hot cache
+ * and after flushing the cache. The winner replaces the handler's plan of
+ * this signature, and its configuration is appended to the tuning database
+ * (see TTC_OPT_TUNE_DB), so that ttc_plan creates the same kernel directly
+ * in later runs.
+ *
+ * @warning Tuning runs the transposition many times, the content of
+ * `result` is undefined afterwards.
+ *
+ * @param[in,out]   handler A pointer pointing to a TTC handler.
+ * @param[in]       param   A parameter describing the transposition.
+ * @param[in]       input   A pointer pointing to the input tensor.
+ * @param[out]      result  A pointer pointing to the result tensor.
+ *
+ * @return The status, if the function parameter are not correct, then it will
+ * return -1. If no candidate can be created, it will return non-zero value.
+ * If everything goes well, the return value will be 0.
+ *
+ * @sa struct ttc_tune, ttc_transpose
+ *
+ */
+int32_t
+ttc_autotune(
+        ttc_handler_s       *handler,
+        const ttc_param_s   *param,
+        const void          *input,
+        void                *result
+        );
+
+
+/**
+ * @brief A function for predicting the cost of a transposition.
+ *
+ * @details The transposition is not executed and no plan is created. The
+ * prediction is based on the memory bandwidth of the machine (measured once
+ * per handler, see struct ttc_hw) and on the locality of the permutation:
+ * the contiguous runs of the input and output tensors are compared with the
+ * cache line size, and each engine is given an efficiency. If a plan of the
+ * signature exists and has been executed, its observed mean time is used
+ * instead. The library uses the same model for choosing the engine of new
+ * plans (see TTC_OPT_ENGINE).
+ *
+ * @param[in,out]   handler     A pointer pointing to a TTC handler.
+ * @param[in]       param       A parameter describing the transposition.
+ * @param[out]      estimate    A pointer pointing to the prediction.
+ *
+ * @return The status, if the function parameter are not correct, then it will
+ * return -1. If everything goes well, the return value will be 0.
+ *
+ * @sa struct ttc_estimate, enum ttc_engine, ttc_transpose
+ *
+ */
+int32_t
+ttc_estimate(
+        ttc_handler_s       *handler,
+        const ttc_param_s   *param,
+        ttc_estimate_s      *estimate
+        );
+
+
+/**
+ * @brief A function for suggesting padded leading dimensions.
+ *
+ * @details Tensors with power-of-two extents, e.g. 256 x 128 x 64 floats,
+ * have strides that are multiples of 1 KiB. The rows of a block at such a
+ * stride fall into a few cache sets and evict each other, which can halve
+ * the bandwidth of a transposition. The built-in engines stage such blocks
+ * through a padded buffer, but a padded allocation avoids the conflicts for
+ * every engine and for the kernels of TTC. Each leading dimension setting a
+ * conflicting stride is grown by a cache line (dimension 0) or an element
+ * (the others); the last one is the size. The result can be allocated and
+ * passed as `lda`/`ldb` of the transposition:
+ *
+ * @code{.c}
+ * int32_t ldb[3];
+ * ttc_suggest_ld(&param, NULL, ldb);
+ * float *B = malloc(sizeof(float) * ldb[0] * ldb[1] * ldb[2]);
+ * param.ldb = ldb;
+ * @endcode
+ *
+ * @param[in]   param   A parameter describing the transposition, only the
+ * `datatype`, `perm`, `size` and `dim` are used.
+ * @param[out]  lda     The leading dimensions of the input, an array of `dim`
+ * elements, or a null pointer if not needed.
+ * @param[out]  ldb     The leading dimensions of the output in the output
+ * order, an array of `dim` elements, or a null pointer if not needed.
+ *
+ * @return The status, if the function parameter are not correct, then it will
+ * return -1. If everything goes well, the return value will be 0.
+ *
+ * @sa struct ttc_param
+ *
+ */
+int32_t
+ttc_suggest_ld(
+        const ttc_param_s   *param,
+        int32_t             *lda,
+        int32_t             *ldb
+        );
+
+
+/**
+ * @brief A function for measuring the memory bandwidth of the machine.
+ *
+ * @details Short STREAM-like kernels (read, write and copy of `double`
+ * arrays larger than the last level cache) are run with 1, 2, 4, ... and all
+ * the cores, every thread pinned to its own core and touching its own part
+ * of the arrays first. The copy kernel is also run on every NUMA node with
+ * the cores of the node. The results are stored in handler's struct ttc_hw
+ * and saved to `ttc_transpositions/ttc_hw_<cpu model>.txt`, which is loaded
+ * by ttc_init on later runs. Setting the environment variable
+ * `TTC_CALIBRATE` makes ttc_init calibrate if no file of the CPU model
+ * exists.
+ *
+ * The curves are used by the heuristics of the library, e.g. the bandwidth
+ * in the performance model (ttc_estimate) and the thread numbers tried by
+ * the tuning (the fewest threads reaching 90% of the best copy bandwidth).
+ *
+ * @param[in,out]   handler A pointer pointing to a TTC handler.
+ *
+ * @return The status, if the function parameter are not correct, then it will
+ * return -1. If some internal error happens (e.g. cannot allocate memory), the
+ * return value will be the `errno`. If everything goes well, the return value
+ * will be 0.
+ *
+ * @sa struct ttc_hw
+ *
+ */
+int32_t
+ttc_calibrate(
+        ttc_handler_s   *handler
+        );
+
+
+/**
+ * @brief A function for exporting kernels into a static archive.
+ *
+ * @details For every parameter in `params`, TTC is executed and the generated
+ * kernel is compiled into an object file instead of a shared library. All the
+ * objects, together with a registration table, are archived into
+ * `lib<name>.a`, and a header `<name>.h` declaring the registration function
+ * is written to the current directory:
+ *
+ * @code{.c}
+ * int32_t <name>_register(ttc_handler_s *handler);
+ * @endcode
+ *
+ * A program linked against `ttc_c_static` and `lib<name>.a` (the kernels use
+ * OpenMP, so it should be linked with e.g. `-fopenmp`) calls the registration
+ * function after ttc_init, then every exported signature is resolved by
+ * ttc_transpose without forking TTC, compiling or calling `dlopen`.
+ *
+ * Only the C++ (non-CUDA) architectures are supported.
+ *
+ * @param[in]   handler A pointer pointing to a TTC handler, its options are
+ * used for running TTC and compiling.
+ * @param[in]   params  An array of parameters describing the kernels.
+ * @param[in]   count   The length of `params`.
+ * @param[in]   name    The archive name, it must be a valid C identifier since
+ * it prefixes the exported symbols, and at most 64 characters long.
+ *
+ * @return The status, if the function parameter are not correct, then it will
+ * return -1. If some internal error happens (e.g. TTC fails), the return value
+ * will be non-zero. If everything goes well, the return value will be 0.
+ *
+ * @sa ttc_register_kernel
+ *
+ */
+int32_t
+ttc_export_static(
+        ttc_handler_s       *handler,
+        const ttc_param_s   *params,
+        uint32_t            count,
+        const char          *name
+        );
+
+
+/**
+ * @brief A function for registering a statically linked kernel as a plan.
+ *
+ * @details It is called by the registration function generated by
+ * ttc_export_static, the parameters are the flattened members of struct
+ * ttc_param, so that the generated table does not depend on the layout of
+ * the structs in this header. If a plan with the same signature already
+ * exists in the handler, it will be kept and the kernel is ignored.
+ *
+ * @param[in,out]   handler     A pointer pointing to a TTC handler.
+ * @param[in]       datatype    The data type of the kernel.
+ * @param[in]       dim         The dimension of the tensor.
+ * @param[in]       perm        The permutation, its length is `dim`.
+ * @param[in]       size        The size of the input tensor, its length is
+ * `dim`.
+ * @param[in]       loop_perm   The loop order, it could be a null pointer.
+ * @param[in]       lda         The leading dimensions of the input tensor, it
+ * could be a null pointer.
+ * @param[in]       ldb         The leading dimensions of the output tensor, it
+ * could be a null pointer.
+ * @param[in]       alpha       The alpha the kernel is generated with.
+ * @param[in]       beta        The beta the kernel is generated with.
+ * @param[in]       fn          The kernel.
+ *
+ * @return The status, if the function parameter are not correct or the plan
+ * cannot be allocated, then it will return -1. If everything goes well, the
+ * return value will be 0.
+ *
+ * @sa ttc_export_static
+ *
+ */
+int32_t
+ttc_register_kernel(
+        ttc_handler_s   *handler,
+        ttc_datatype_e  datatype,
+        uint32_t        dim,
+        const uint32_t  *perm,
+        const uint32_t  *size,
+        const uint32_t  *loop_perm,
+        const int32_t   *lda,
+        const int32_t   *ldb,
+        double          alpha,
+        double          beta,
+        int32_t         (*fn)(
+            const void      *input,
+            void            *result,
+            const void      *alpha,
+            const void      *beta,
+            const int32_t   *lda,
+            const int32_t   *ldb
+            )
+        );
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,525 @@
+/**
+ * @file ttc_c_engine.h
+ * @brief The built-in transposition engines for TTC C APIs' internal usage.
+ *
+ */
+#pragma once
+
+
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "ttc_c.h"
+
+
+#ifdef __CPLUSPLUS
+extern "C" {
+#endif
+
+
+
+/* ======== Macro ======== */
+
+#define TTC_ENGINE_MAX_DIM      32
+
+#define TTC_ENGINE_BLOCK        64
+#define TTC_ENGINE_TILE         16
+#define TTC_ENGINE_ROW          8192
+#define TTC_ENGINE_CHUNK        (1 << 20)
+#define TTC_ENGINE_PAR_MIN      32768
+#define TTC_ENGINE_STREAM_ROW   65536
+#define TTC_ENGINE_STREAM_MIN   1024
+#define TTC_ENGINE_STREAM_BUF   1024
+#define TTC_ENGINE_LEAF         131072
+#define TTC_ENGINE_TASK         65536
+#define TTC_ENGINE_MAX_TEAM     1024
+#define TTC_ENGINE_SWAP         32
+#define TTC_ENGINE_DOMAIN_ENV   "TTC_DOMAINS"
+
+#define TTC_ENGINE_LINE         64
+#define TTC_ENGINE_CONFLICT     1024
+#define TTC_ENGINE_STAGE_BUF    \
+    (TTC_ENGINE_BLOCK * (TTC_ENGINE_BLOCK * 16 + TTC_ENGINE_LINE))
+#define TTC_ENGINE_THP_MODE     "/sys/kernel/mm/transparent_hugepage/enabled"
+#define TTC_ENGINE_THP_SIZE     \
+    "/sys/kernel/mm/transparent_hugepage/hpage_pmd_size"
+#define TTC_ENGINE_PAGE_COST    4.0
+#define TTC_ENGINE_ITEM_COST    2.0
+#define TTC_ENGINE_SPLIT_GAIN   0.5
+
+
+
+/* ======== Struct ======== */
+
+/**
+ * @brief Struct for a transposition split into two passes.
+ *
+ * @details The first pass transposes the input into a dense scratch tensor
+ * of the input precision, with `alpha` 1 and `beta` 0, the second pass
+ * transposes the scratch tensor into the result with the `alpha`, `beta`
+ * and `ldb` of the transposition. The parameters of the passes point into
+ * `perm` and `size`, so the struct must not be copied.
+ *
+ */
+typedef struct ttc_engine_split {
+    ttc_param_s pass[2];
+    uint32_t    perm[2][TTC_ENGINE_MAX_DIM];
+    uint32_t    size[2][TTC_ENGINE_MAX_DIM];
+    double      cost;
+    double      cost_split;
+} ttc_engine_split_s;
+
+
+
+/* ======== Function declaration ======== */
+
+/**
+ * @brief Function for checking if a transposition is a plain copy.
+ *
+ * @details A transposition is a plain copy if the input and output have the
+ * same data type, `alpha` is 1, `beta` is 0, and both tensors are one
+ * contiguous run in the same order, i.e. the permutation is the identity up
+ * to dimensions of size 1 and the leading dimensions (if any) add no
+ * padding.
+ *
+ * @param[in]   param   A parameter describing the transposition, the `alpha`
+ * and `beta` are read as stored in a plan.
+ *
+ * @return Whether TTC_ENGINE_COPY can execute the transposition.
+ *
+ */
+bool
+ttc_engine_is_copy(
+        const ttc_param_s   *param
+        );
+
+
+/**
+ * @brief Function for checking if a transposition is a batch of rows.
+ *
+ * @details Ignoring the dimensions of size 1, the input and output have
+ * their smallest stride along the same dimension, i.e. `perm[0]` is 0 up to
+ * dimensions of size 1. This includes every identity permutation, which is a
+ * scaled copy `B = alpha * A + beta * B`. Such a transposition is a batch of
+ * strided row copies and needs no tiling.
+ *
+ * @param[in]   param   A parameter describing the transposition.
+ *
+ * @return Whether the generic kernel executes the transposition as rows.
+ *
+ */
+bool
+ttc_engine_is_rows(
+        const ttc_param_s   *param
+        );
+
+
+/**
+ * @brief Function for checking if a transposition is skinny.
+ *
+ * @details Ignoring the dimensions of size 1 and merging the contiguous
+ * ones, the plane of the output dimension 0 and the input dimension 0 has a
+ * side of at most TTC_MICRO_SKINNY elements and a side of at least
+ * TTC_ENGINE_BLOCK elements, e.g. the transpose of a 10^7 x 3 matrix, or of
+ * a 4 x 2 x 10^6 tensor with the permutation `{ 2, 0, 1 }`. Such a
+ * transposition is cut only along the long side and executed by the skinny
+ * kernels, which approach the bandwidth of a copy.
+ *
+ * @param[in]   param   A parameter describing the transposition.
+ *
+ * @return Whether the generic kernel executes the transposition as skinny
+ * blocks.
+ *
+ */
+bool
+ttc_engine_is_skinny(
+        const ttc_param_s   *param
+        );
+
+
+/**
+ * @brief Function for checking if a transposition is cut into square blocks.
+ *
+ * @details The generic kernel cuts a transposition into square blocks if it
+ * is neither a batch of rows nor skinny, i.e. if the input and output run
+ * along different dimensions and the plane of these dimensions has no short
+ * side. Only such transpositions have a choice between
+ * TTC_ENGINE_GENERIC and TTC_ENGINE_RECURSIVE.
+ *
+ * @param[in]   param   A parameter describing the transposition.
+ *
+ * @return Whether the generic kernel executes the transposition as square
+ * blocks.
+ *
+ */
+bool
+ttc_engine_is_blocked(
+        const ttc_param_s   *param
+        );
+
+
+/**
+ * @brief Function for splitting a transposition into two passes.
+ *
+ * @details A permutation which scatters every dimension, typically of a
+ * high-rank tensor with short dimensions, leaves the generic kernel a plane
+ * of short runs whose neighbours are far apart: most loads and stores touch
+ * a new cache line and a new page. Such a transposition may be cheaper in
+ * two passes through a scratch tensor. The scratch tensor starts with the
+ * leading input dimensions, followed by the leading output dimensions and
+ * the others in the output order, so that the first pass moves whole rows
+ * of the input and the second pass is a plane of long runs on both sides.
+ * Every split of the leading dimensions into such groups of at most
+ * TTC_ENGINE_ROW elements is rated by its locality cost: the cache lines of
+ * TTC_ENGINE_LINE bytes and the pages (weighted by TTC_ENGINE_PAGE_COST)
+ * touched per element, plus the overhead of locating the work items
+ * (TTC_ENGINE_ITEM_COST per dimension and item). The pages are the
+ * transparent huge pages if the kernel always uses them, the base pages
+ * otherwise. The cheapest split is taken if it costs less than
+ * TTC_ENGINE_SPLIT_GAIN of the single pass. Only transpositions cut into
+ * square blocks (see ttc_engine_is_blocked) are split.
+ *
+ * @param[in]   param   A parameter describing the transposition.
+ * @param[out]  split   The passes, `cost` is the locality cost of the single
+ * pass and `cost_split` of the chosen passes, in cache lines per element.
+ *
+ * @return 0 if the passes are cheaper, 1 if the single pass is, or -1 if the
+ * parameter is not supported.
+ *
+ */
+int32_t
+ttc_engine_split(
+        const ttc_param_s   *param,
+        ttc_engine_split_s  *split
+        );
+
+
+/**
+ * @brief Function for checking if a transposition is split into passes.
+ *
+ * @param[in]   param   A parameter describing the transposition.
+ *
+ * @return Whether ttc_engine_split splits the transposition.
+ *
+ */
+bool
+ttc_engine_is_multipass(
+        const ttc_param_s   *param
+        );
+
+
+/**
+ * @brief Function for getting the scratch size of a multi-pass
+ * transposition.
+ *
+ * @param[in]   param   A parameter describing the transposition.
+ *
+ * @return The bytes of the scratch tensor of ttc_engine_multipass, or 0 if
+ * the transposition is not split.
+ *
+ */
+size_t
+ttc_engine_scratch(
+        const ttc_param_s   *param
+        );
+
+
+/**
+ * @brief Function for executing a transposition in passes.
+ *
+ * @details Both passes of ttc_engine_split are executed by
+ * ttc_engine_generic, a transposition which is not split is executed
+ * directly. The supported parameters are the same as for
+ * ttc_engine_generic.
+ *
+ * @param[in]   param   A parameter describing the transposition, the `alpha`
+ * and `beta` are read as stored in a plan.
+ * @param[in]   scratch A buffer of ttc_engine_scratch bytes.
+ * @param[in]   input   A pointer pointing to the input tensor.
+ * @param[out]  result  A pointer pointing to the result tensor.
+ *
+ * @return The status, return 0 if succeed, or -1 if the parameter is not
+ * supported.
+ *
+ */
+int32_t
+ttc_engine_multipass(
+        const ttc_param_s   *param,
+        void                *scratch,
+        const void          *input,
+        void                *result
+        );
+
+
+/**
+ * @brief Function for executing a transposition with the generic kernel.
+ *
+ * @details The plane of the output dimension 0 and the input dimension 0 is
+ * cut into blocks of TTC_ENGINE_BLOCK x TTC_ENGINE_BLOCK elements for the L2
+ * cache, which are transposed in tiles of TTC_ENGINE_TILE x TTC_ENGINE_TILE
+ * elements for the L1 cache, or by the SIMD micro-kernels of ttc_micro_select
+ * if the CPU supports them. A plane with a short side (see
+ * ttc_engine_is_skinny) is cut into blocks of the whole short side and
+ * TTC_ENGINE_ROW elements of the long side instead, which are executed by
+ * the skinny kernels of ttc_micro_skinny if the CPU supports them. If the
+ * permutation keeps dimension 0, rows of TTC_ENGINE_ROW elements are scaled
+ * instead, with non-temporal stores if the rows are contiguous, at least
+ * TTC_ENGINE_STREAM_ROW bytes long and `beta` is 0. The blocks are shared by
+ * the OpenMP threads if the tensor has at least TTC_ENGINE_PAR_MIN elements
+ * and the library is built with OpenMP. All the data types, `alpha`, `beta` and
+ * the leading dimensions are supported, `ldb` is given in the order of the
+ * output dimensions.
+ *
+ * @param[in]   param   A parameter describing the transposition, the `alpha`
+ * and `beta` are read as stored in a plan.
+ * @param[in]   input   A pointer pointing to the input tensor.
+ * @param[out]  result  A pointer pointing to the result tensor.
+ *
+ * @return The status, return 0 if succeed, or -1 if the parameter is not
+ * supported (e.g. `dim` is larger than TTC_ENGINE_MAX_DIM).
+ *
+ */
+int32_t
+ttc_engine_generic(
+        const ttc_param_s   *param,
+        const void          *input,
+        void                *result
+        );
+
+
+/**
+ * @brief Function for executing a transposition with the recursive kernel.
+ *
+ * @details The tensor is transposed by divide and conquer, without a fixed
+ * blocking: the longest dimension is halved until a sub-problem moves at
+ * most TTC_ENGINE_LEAF bytes, which is then transposed plane by plane with
+ * the same kernels as ttc_engine_generic. The sub-problems fit every level
+ * of the cache at some depth of the recursion, whatever the sizes are, e.g.
+ * prime sizes or sizes just above a power of two. The halves of sub-problems
+ * larger than TTC_ENGINE_TASK elements are OpenMP tasks if the tensor has
+ * at least TTC_ENGINE_PAR_MIN elements. The supported parameters are the
+ * same as for ttc_engine_generic.
+ *
+ * @param[in]   param   A parameter describing the transposition, the `alpha`
+ * and `beta` are read as stored in a plan.
+ * @param[in]   input   A pointer pointing to the input tensor.
+ * @param[out]  result  A pointer pointing to the result tensor.
+ *
+ * @return The status, return 0 if succeed, or -1 if the parameter is not
+ * supported.
+ *
+ */
+int32_t
+ttc_engine_recursive(
+        const ttc_param_s   *param,
+        const void          *input,
+        void                *result
+        );
+
+
+/**
+ * @brief Function for executing a plain copy.
+ *
+ * @details Copies larger than TTC_ENGINE_CHUNK bytes are split into chunks
+ * shared by the OpenMP threads.
+ *
+ * @param[in]   param   A parameter for which ttc_engine_is_copy is true.
+ * @param[in]   input   A pointer pointing to the input tensor.
+ * @param[out]  result  A pointer pointing to the result tensor.
+ *
+ * @return The status, return 0 if succeed, otherwise -1.
+ *
+ */
+int32_t
+ttc_engine_copy(
+        const ttc_param_s   *param,
+        const void          *input,
+        void                *result
+        );
+
+
+/**
+ * @brief Function for getting the share of a thread of the OpenMP team.
+ *
+ * @details It must be called by every thread of the team (or outside of a
+ * parallel region). The threads of a last level cache domain (see
+ * ttc_hw_domain) get one contiguous range of the items together, the
+ * domains follow each other in their order and their ranges are
+ * proportional to their threads. Neighbouring items, and the lines of A and
+ * B at their edges, are therefore not split across the dies of a chiplet
+ * CPU. Inside a domain the threads split the range in their order. With a
+ * single domain, an unknown domain, more than TTC_ENGINE_MAX_TEAM threads
+ * or the environment variable TTC_DOMAINS set to `0`, the items are split
+ * statically in thread order, like `schedule(static)`. The domains are
+ * taken from the CPUs the threads run on, so they are stable only if the
+ * threads are bound, e.g. with `OMP_PROC_BIND`.
+ *
+ * @param[in]   num_items   The number of items.
+ * @param[out]  domains     A scratch array of TTC_ENGINE_MAX_TEAM elements
+ * shared by the team.
+ * @param[out]  begin       The first item of the thread.
+ * @param[out]  end         The item after the last one of the thread.
+ *
+ */
+void
+ttc_engine_share(
+        int64_t     num_items,
+        int32_t     *domains,
+        int64_t     *begin,
+        int64_t     *end
+        );
+
+
+/**
+ * @brief Function for getting the bytes spanned by a tensor of a
+ * transposition.
+ *
+ * @param[in]   param   A parameter describing the transposition.
+ * @param[in]   output  Whether the output tensor (with `ldb`) is measured,
+ * otherwise the input tensor (with `lda`).
+ *
+ * @return The bytes from the first to the end of the last element, 0 if a
+ * size is 0 or the parameter is not well initialized.
+ *
+ */
+size_t
+ttc_engine_extent(
+        const ttc_param_s   *param,
+        bool                output
+        );
+
+
+/**
+ * @brief Function for checking if the tensors of a call overlap.
+ *
+ * @param[in]   param   A parameter describing the transposition.
+ * @param[in]   input   A pointer pointing to the input tensor.
+ * @param[in]   result  A pointer pointing to the result tensor.
+ *
+ * @return Whether the bytes spanned by both tensors (see ttc_engine_extent)
+ * share an address.
+ *
+ */
+bool
+ttc_engine_overlap(
+        const ttc_param_s   *param,
+        const void          *input,
+        const void          *result
+        );
+
+
+/**
+ * @brief Function for checking if a transposition can run in place.
+ *
+ * @param[in]   param   A parameter describing the transposition.
+ * @param[in]   input   A pointer pointing to the input tensor.
+ * @param[in]   result  A pointer pointing to the result tensor.
+ *
+ * @return Whether the input and output have the same precision, are both
+ * dense, i.e. `lda` and `ldb` are the sizes (or null), and `result` starts a
+ * whole number of elements away from `input` (or at `input`).
+ *
+ */
+bool
+ttc_engine_is_inplace(
+        const ttc_param_s   *param,
+        const void          *input,
+        const void          *result
+        );
+
+
+/**
+ * @brief Function for executing a transposition within the memory of its
+ * input.
+ *
+ * @details A transposition onto itself swapping two dimensions of the same
+ * size (e.g. a square matrix, or a stack of them) exchanges pairs of tiles of
+ * TTC_ENGINE_SWAP x TTC_ENGINE_SWAP elements in parallel, without auxiliary
+ * memory. A shifted copy is a `memmove`. Otherwise each position of the
+ * result takes the element of its source position, before that position is
+ * overwritten. The positions of the result outside of the input start
+ * chains, which follow the sources until a position outside of the result.
+ * The remaining positions form cycles, whose elements are moved one after
+ * another with a single element held aside.
+ *
+ * The OpenMP threads share the positions, first the chain heads, then the
+ * cycles. A position moves its cycle if it is the smallest one of the
+ * cycle, which it checks by following the cycle until a smaller position. A
+ * bitmap marks the moved positions, so that the other positions of a moved
+ * cycle are skipped. The auxiliary memory is the bitmap, `(N + S) / 8` bytes
+ * for N elements shifted by S elements, e.g. 1/32 of a single precision
+ * tensor moved onto itself. A shift of a few elements gives a few long
+ * chains, which only a few threads move. The elements are visited in the
+ * order of the chains and cycles, so it is slower than an out-of-place
+ * transposition.
+ *
+ * @param[in]       param   A parameter for which ttc_engine_is_inplace is
+ * true, the `alpha` and `beta` are read as stored in a plan.
+ * @param[in,out]   input   A pointer pointing to the input tensor, which is
+ * overwritten where the result overlaps it.
+ * @param[out]      result  A pointer pointing to the result tensor.
+ *
+ * @return The status, return 0 if succeed, -1 if the parameter is not
+ * supported or the bitmap cannot be allocated.
+ *
+ */
+int32_t
+ttc_engine_inplace(
+        const ttc_param_s   *param,
+        void                *input,
+        void                *result
+        );
+
+
+/**
+ * @brief Function for checking if a tensor of a transposition has more than
+ * 2^31 - 1 elements.
+ *
+ * @details The kernels of TTC (and the CUDA wrapper around them) address the
+ * tensors with `int` offsets, so such transpositions must run on the
+ * built-in engines.
+ *
+ * @param[in]   param   A parameter describing the transposition.
+ *
+ * @return Whether the input or output spans more elements than `INT32_MAX`,
+ * counting the padding of `lda` and `ldb`.
+ *
+ */
+bool
+ttc_engine_is_large(
+        const ttc_param_s   *param
+        );
+
+
+/**
+ * @brief Function for executing a transposition with 64-bit sizes.
+ *
+ * @details The layout is built from the 64-bit sizes and leading dimensions
+ * and executed like ttc_engine_generic, every index and stride is 64-bit. If
+ * the tensors overlap, they are moved like in ttc_engine_inplace, or a copy
+ * of the input is transposed if they are padded, differ in precision or are
+ * shifted by a part of an element.
+ *
+ * @param[in]   param   A parameter describing the transposition, the `alpha`
+ * and `beta` are read as stored in a plan.
+ * @param[in]   input   A pointer pointing to the input tensor.
+ * @param[out]  result  A pointer pointing to the result tensor.
+ *
+ * @return The status, return 0 if succeed, -1 if the parameter is not
+ * supported (e.g. a tensor spans more bytes than `SIZE_MAX`) or the bitmap
+ * or the copy cannot be allocated.
+ *
+ */
+int32_t
+ttc_engine_wide(
+        const ttc_param64_s *param,
+        const void          *input,
+        void                *result
+        );
+
+
+#ifdef __CPLUSPLUS
+}
+#endif
@@ -0,0 +1,243 @@
+/**
+ * @file ttc_c_hw.h
+ * @brief The hardware detection for TTC C APIs' internal usage.
+ *
+ */
+#pragma once
+
+
+
+#include <stdint.h>
+
+#include "ttc_c.h"
+
+
+#ifdef __CPLUSPLUS
+extern "C" {
+#endif
+
+
+
+/* ======== Macro ======== */
+
+#define TTC_HW_CACHE_MAX_INDEX  16
+#define TTC_HW_CPU_CACHE_DIR    "/sys/devices/system/cpu/cpu%u/cache/index%u/"
+#define TTC_HW_MAX_CPUS         4096
+#define TTC_HW_LLC_DEFAULT      (8 * 1024 * 1024)
+
+#define TTC_HW_BW_MIN_SIZE      (32 * 1024 * 1024)
+#define TTC_HW_BW_MAX_SIZE      (256 * 1024 * 1024)
+#define TTC_HW_BW_REPEAT        4
+#define TTC_HW_BW_DEFAULT       10.0
+
+#define TTC_HW_NODE_DIR         "/sys/devices/system/node/node%u/"
+#define TTC_HW_MAX_NODES        64
+#define TTC_HW_CPUINFO          "/proc/cpuinfo"
+#define TTC_HW_CPU_MODEL        "model name"
+#define TTC_HW_CALIB_FMT        "ttc_transpositions/ttc_hw_%s.txt"
+#define TTC_HW_CALIB_HEADER     "# cache,<l1>,<l2>,<llc>\n" \
+                                "# threads,<n>,<read>,<write>,<copy>\n" \
+                                "# node,<id>,<copy>\n"
+#define TTC_HW_CALIB_ENV        "TTC_CALIBRATE"
+#define TTC_HW_CALIB_REPEAT     3
+#define TTC_HW_SATURATION       0.9
+
+
+
+/* ======== Function declaration ======== */
+
+/**
+ * @brief Function for detecting the hardware properties.
+ *
+ * @details The cache sizes, the cores and the NUMA nodes are read from sysfs,
+ * default values are used if they are not available. The calibration file
+ * of the CPU model is loaded if it exists.
+ *
+ * @param[out]  hw  A pointer pointing to the ttc_hw_s object to be filled.
+ *
+ * @return The status, return 0 if the properties are detected, otherwise
+ * -1 and the default values are set.
+ *
+ */
+int32_t
+ttc_hw_detect(
+        ttc_hw_s    *hw
+        );
+
+
+/**
+ * @brief Function for getting the memory bandwidth, it is measured on the
+ * first call.
+ *
+ * @details Two buffers of twice the last level cache size (bounded by
+ * TTC_HW_BW_MIN_SIZE and TTC_HW_BW_MAX_SIZE) are copied TTC_HW_BW_REPEAT
+ * times with `memcpy`, the fastest copy is kept. TTC_HW_BW_DEFAULT is used
+ * if the buffers cannot be allocated.
+ *
+ * @param[in,out]   hw  A pointer pointing to the detected hardware.
+ *
+ * @return The bandwidth in GB/s, counting the read and written bytes.
+ *
+ */
+double
+ttc_hw_bandwidth(
+        ttc_hw_s    *hw
+        );
+
+
+/**
+ * @brief Function for releasing the bandwidth curves of a ttc_hw_s object.
+ *
+ * @param[in,out]   hw  A pointer pointing to the hardware properties.
+ *
+ */
+void
+ttc_hw_release(
+        ttc_hw_s    *hw
+        );
+
+
+/**
+ * @brief Function for measuring the bandwidth curves.
+ *
+ * @param[in,out]   hw  A pointer pointing to the detected hardware, the
+ * previous curves are released.
+ *
+ * @return The status, return 0 if succeed, otherwise the `errno` or -1.
+ *
+ * @sa ttc_calibrate
+ *
+ */
+int32_t
+ttc_hw_calibrate(
+        ttc_hw_s    *hw
+        );
+
+
+/**
+ * @brief Function for loading the calibration file of the CPU model.
+ *
+ * @param[in,out]   hw  A pointer pointing to the detected hardware.
+ *
+ * @return The status, return 0 if the file is loaded, otherwise non-zero
+ * value.
+ *
+ */
+int32_t
+ttc_hw_load(
+        ttc_hw_s    *hw
+        );
+
+
+/**
+ * @brief Function for saving the calibration file of the CPU model.
+ *
+ * @param[in]   hw  A pointer pointing to the calibrated hardware.
+ *
+ * @return The status, return 0 if succeed, otherwise non-zero value.
+ *
+ */
+int32_t
+ttc_hw_save(
+        const ttc_hw_s  *hw
+        );
+
+
+/**
+ * @brief Function for getting the copy bandwidth of a number of threads.
+ *
+ * @details The point with the most threads not exceeding `threads` is used.
+ * Without calibration, the bandwidth of one thread (see ttc_hw_bandwidth)
+ * is returned, or TTC_HW_BW_DEFAULT if it is not measured yet.
+ *
+ * @param[in]   hw      A pointer pointing to the detected hardware.
+ * @param[in]   threads The number of threads, 0 means all the cores.
+ *
+ * @return The bandwidth in GB/s, counting the read and written bytes.
+ *
+ */
+double
+ttc_hw_copy_bandwidth(
+        const ttc_hw_s  *hw,
+        uint32_t        threads
+        );
+
+
+/**
+ * @brief Function for getting the number of threads saturating the memory.
+ *
+ * @param[in]   hw  A pointer pointing to the detected hardware.
+ *
+ * @return The fewest threads reaching TTC_HW_SATURATION of the best copy
+ * bandwidth, or half of the cores if the machine is not calibrated.
+ *
+ */
+uint32_t
+ttc_hw_threads(
+        const ttc_hw_s  *hw
+        );
+
+
+/**
+ * @brief Function for resolving the cache residency of a call.
+ *
+ * @details TTC_RES_AUTO is resolved to TTC_RES_HOT if the input and output
+ * tensors fit in the last level cache together, otherwise TTC_RES_COLD. The
+ * other values are returned as they are.
+ *
+ * @param[in]   hw      A pointer pointing to the detected hardware.
+ * @param[in]   param   A parameter describing the transposition.
+ *
+ * @return The resolved residency.
+ *
+ */
+ttc_residency_e
+ttc_hw_residency(
+        const ttc_hw_s      *hw,
+        const ttc_param_s   *param
+        );
+
+
+/**
+ * @brief Function for resolving the store hint of a call.
+ *
+ * @details TTC_STORE_AUTO is resolved to TTC_STORE_STREAM if the output
+ * tensor, with the padding of `ldb`, exceeds the last level cache, otherwise
+ * TTC_STORE_CACHED. The other values are returned as they are.
+ *
+ * @param[in]   hw      A pointer pointing to the detected hardware.
+ * @param[in]   param   A parameter describing the transposition.
+ *
+ * @return The resolved hint.
+ *
+ */
+ttc_store_e
+ttc_hw_store(
+        const ttc_hw_s      *hw,
+        const ttc_param_s   *param
+        );
+
+
+/**
+ * @brief Function for getting the last level cache domain of a CPU.
+ *
+ * @details A domain is a group of cores sharing a last level cache, e.g. a
+ * core complex of a chiplet CPU. It is named by the first CPU in the
+ * `shared_cpu_list` of the cache in sysfs, so the domains of a socket are
+ * ordered like their cores. The value is read at the first call for the
+ * CPU and reused, it is safe to call from any thread.
+ *
+ * @param[in]   cpu The CPU number, e.g. from `sched_getcpu`.
+ *
+ * @return The domain, or -1 if it is unknown.
+ *
+ */
+int32_t
+ttc_hw_domain(
+        uint32_t    cpu
+        );
+
+
+#ifdef __CPLUSPLUS
+}
+#endif
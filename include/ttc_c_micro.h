@@ -0,0 +1,128 @@
+/**
+ * @file ttc_c_micro.h
+ * @brief The SIMD micro-kernels for TTC C APIs' internal usage.
+ *
+ */
+#pragma once
+
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ttc_c.h"
+
+
+#ifdef __CPLUSPLUS
+extern "C" {
+#endif
+
+
+
+/* ======== Macro ======== */
+
+#define TTC_MICRO_ENV           "TTC_SIMD"
+#define TTC_MICRO_SKINNY        8
+
+
+
+/* ======== Enumeration ======== */
+
+/**
+ * @brief Enumerator for the instruction sets of the micro-kernels.
+ *
+ */
+typedef enum ttc_micro_isa {
+    TTC_MICRO_NONE      = 0,    ///< No micro-kernel, scalar code only.
+    TTC_MICRO_AVX2      = 1,    ///< AVX2 with FMA, 8x8 floats per tile.
+    TTC_MICRO_AVX512    = 2     ///< AVX-512F, 16x16 floats per tile.
+} ttc_micro_isa_e;
+
+
+
+/* ======== Type definition ======== */
+
+/**
+ * @brief Type of a micro-kernel.
+ *
+ * @details A micro-kernel computes `B = alpha * A^T + beta * B` of an `m` x
+ * `n` column-major matrix A, i.e. `B[j + i * ldb] = alpha * A[i + j * lda] +
+ * beta * B[j + i * ldb]` for `i < m` and `j < n`. The leading dimensions are
+ * counted in elements of the data type, a complex number is one element. The
+ * matrices are cut into register tiles, the tiles at the edges are read and
+ * written with masks. B is not read if `beta` is 0.
+ *
+ */
+typedef void (*ttc_micro_fn)(
+        const void  *input,
+        uint64_t    lda,
+        void        *result,
+        uint64_t    ldb,
+        uint64_t    m,
+        uint64_t    n,
+        double      alpha,
+        double      beta
+        );
+
+
+
+/* ======== Function declaration ======== */
+
+/**
+ * @brief Function for getting the instruction set of the micro-kernels.
+ *
+ * @details The best instruction set supported by the CPU is used, capped by
+ * the environment variable TTC_SIMD (`none`, `avx2` or `avx512`) if it is
+ * set. The result is detected at the first call and reused. Only x86 builds
+ * with GCC compatible compilers have micro-kernels.
+ *
+ * @return The instruction set.
+ *
+ */
+ttc_micro_isa_e
+ttc_micro_isa(
+        );
+
+
+/**
+ * @brief Function for choosing the micro-kernel of a data type.
+ *
+ * @param[in]   datatype    The data type, the input and output must have the
+ * same precision.
+ *
+ * @return The micro-kernel for ttc_micro_isa, or NULL if there is none.
+ *
+ */
+ttc_micro_fn
+ttc_micro_select(
+        ttc_datatype_e  datatype
+        );
+
+
+
+/**
+ * @brief Function for choosing the skinny kernel of a data type.
+ *
+ * @details A skinny kernel computes the same as a micro-kernel, but for a
+ * matrix with a side of at most TTC_MICRO_SKINNY elements, e.g. 3 x 10^6. It
+ * runs along the long side with vector loads and stores that interleave the
+ * short side, where the register tiles of ttc_micro_select would be mostly
+ * masked. Larger matrices are still correct but slower than the
+ * micro-kernels.
+ *
+ * @param[in]   datatype    The data type, the input and output must have the
+ * same precision.
+ *
+ * @return The skinny kernel, or NULL if the CPU has no AVX2 (or TTC_SIMD is
+ * `none`).
+ *
+ */
+ttc_micro_fn
+ttc_micro_skinny(
+        ttc_datatype_e  datatype
+        );
+
+
+#ifdef __CPLUSPLUS
+}
+#endif
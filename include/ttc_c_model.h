@@ -0,0 +1,113 @@
+/**
+ * @file ttc_c_model.h
+ * @brief The performance model for TTC C APIs' internal usage.
+ *
+ */
+#pragma once
+
+
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ttc_c.h"
+
+
+#ifdef __CPLUSPLUS
+extern "C" {
+#endif
+
+
+
+/* ======== Macro ======== */
+
+#define TTC_MODEL_LINE_SIZE     64
+
+#define TTC_MODEL_JIT_EFF       0.9
+#define TTC_MODEL_GENERIC_EFF   0.6
+#define TTC_MODEL_MICRO_EFF     0.8
+#define TTC_MODEL_ROW_EFF       0.9
+#define TTC_MODEL_SKINNY_EFF    0.8
+#define TTC_MODEL_COPY_EFF      1.0
+
+#define TTC_MODEL_JIT_SETUP     2.0
+#define TTC_MODEL_JIT_CALLS     1000
+#define TTC_MODEL_PROBE_CALLS   4
+
+
+
+/* ======== Function declaration ======== */
+
+/**
+ * @brief Function for predicting the cost of a transposition on an engine.
+ *
+ * @details The time is the input bytes divided by the efficiency of the
+ * contiguous input runs, plus the output bytes divided by the efficiency of
+ * the contiguous output runs, over the measured bandwidth times the
+ * efficiency of the engine (TTC_MODEL_*_EFF; for the generic engine
+ * TTC_MODEL_ROW_EFF if it copies rows, TTC_MODEL_MICRO_EFF if it transposes
+ * with SIMD micro-kernels). The bandwidth is the copy bandwidth of the
+ * threads of the options for TTC_ENGINE_JIT, and of all the cores for the
+ * built-in engines if the library is built with OpenMP (one thread
+ * otherwise). The efficiency of a run is its length in bytes over
+ * TTC_MODEL_LINE_SIZE, at most 1. TTC_ENGINE_JIT has a setup cost of
+ * TTC_MODEL_JIT_SETUP seconds, or the search budget if it is set in the
+ * options. TTC_ENGINE_MULTIPASS is the sum of its passes on the generic
+ * engine (see ttc_engine_split). The effective bandwidth counts the bytes of
+ * the transposition itself.
+ *
+ * @param[in]   hw          A pointer pointing to the measured hardware.
+ * @param[in]   options     A pointer pointing to the handler's options.
+ * @param[in]   param       A parameter describing the transposition.
+ * @param[in]   engine      The engine, it must not be TTC_ENGINE_AUTO.
+ * @param[out]  estimate    A pointer pointing to the prediction.
+ *
+ */
+void
+ttc_model_predict(
+        const ttc_hw_s      *hw,
+        const ttc_opt_s     *options,
+        const ttc_param_s   *param,
+        ttc_engine_e        engine,
+        ttc_estimate_s      *estimate
+        );
+
+
+/**
+ * @brief Function for choosing the engine of a new plan.
+ *
+ * @details The option TTC_OPT_ENGINE is followed unless it is
+ * TTC_ENGINE_AUTO. Otherwise an identity copy uses TTC_ENGINE_COPY, any
+ * other batch of rows (see ttc_engine_is_rows, e.g. `perm[0]` is 0) or
+ * skinny transposition (see ttc_engine_is_skinny) uses TTC_ENGINE_GENERIC, a
+ * signature with a tuning record or the CUDA architecture uses
+ * TTC_ENGINE_JIT, a permutation split by ttc_engine_split uses
+ * TTC_ENGINE_MULTIPASS, and the remaining ones use TTC_ENGINE_JIT only if
+ * the time saved over TTC_MODEL_JIT_CALLS calls exceeds its setup cost. An
+ * explicit TTC_ENGINE_MULTIPASS falls back to TTC_ENGINE_GENERIC if the
+ * permutation is not split. Batches of
+ * rows and skinny transpositions never use TTC unless TTC_ENGINE_JIT is set
+ * explicitly. TTC_ENGINE_RECURSIVE is only chosen explicitly, but ttc_plan
+ * lets an automatic TTC_ENGINE_GENERIC plan of more than TTC_SMALL_BYTES,
+ * which is cut into square blocks (see ttc_engine_is_blocked), time its
+ * first TTC_MODEL_PROBE_CALLS calls against it.
+ *
+ * @param[in,out]   handler A pointer pointing to a TTC handler, the bandwidth
+ * is measured if it is not yet.
+ * @param[in]       param   A parameter describing the transposition.
+ * @param[out]      chosen  The prediction of the chosen engine, or NULL.
+ *
+ * @return The chosen engine.
+ *
+ */
+ttc_engine_e
+ttc_model_select(
+        ttc_handler_s       *handler,
+        const ttc_param_s   *param,
+        ttc_estimate_s      *chosen
+        );
+
+
+#ifdef __CPLUSPLUS
+}
+#endif
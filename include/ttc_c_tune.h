@@ -0,0 +1,374 @@
+/**
+ * @file ttc_c_tune.h
+ * @brief The tuning utilities for TTC C APIs' internal usage.
+ *
+ */
+#pragma once
+
+
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "ttc_c.h"
+
+
+#ifdef __CPLUSPLUS
+extern "C" {
+#endif
+
+
+
+/* ======== Macro ======== */
+
+#define TTC_TUNE_DB_DEFAULT     "ttc_transpositions/ttc_tuning.csv"
+#define TTC_TUNE_DB_HEADER      "# datatype,perm,size,loop_perm,num_threads," \
+                                "blocking,pref_dist,status,bandwidth," \
+                                "max_impl\n"
+#define TTC_TUNE_DB_NONE        "-"
+#define TTC_TUNE_DB_ENV         "TTC_TUNE_DB"
+
+#define TTC_TUNE_STATUS_MASK    TTC_USE_STM_STORE
+
+#define TTC_TUNE_FLUSH_SIZE     (64 * 1024 * 1024)
+#define TTC_TUNE_REPEAT         5
+
+#define TTC_TUNE_NEAR_MAX       1.0
+#define TTC_TUNE_NEAR_GAIN      0.1
+
+#define TTC_RETUNE_MIN_CALLS    16
+#define TTC_RETUNE_MIN_GAIN     0.9
+
+
+
+/* ======== Typedef ======== */
+
+/// @brief typedef for replacing struct ttc_retune
+typedef struct ttc_retune ttc_retune_s;
+
+
+
+/* ======== Struct definition ======== */
+
+/**
+ * @brief Struct for a background re-tuning job of a plan.
+ *
+ * @details The job is stored in ttc_plan::retune. Its thread searches a
+ * configuration on scratch buffers, and replaces ttc_plan::fn if the new
+ * kernel is faster than TTC_RETUNE_MIN_GAIN times the old one. The library of
+ * the new kernel is owned by the job, the one of the old kernel stays with
+ * the plan, so that calls in flight can finish.
+ *
+ * @sa ttc_retune_check, ttc_retune_release
+ *
+ */
+struct ttc_retune {
+    pthread_t   thread;
+    ///< The re-tuning thread.
+
+    ttc_opt_s   options;
+    /**<
+     * The handler's options when the job was started, with the status of the
+     * plan, see ttc_retune_options.
+     */
+
+    uint32_t    mask;
+    ///< The status bits the search may change.
+
+    const ttc_hw_s *hw;
+    ///< The handler's hardware properties, the handler waits for the job.
+
+    ttc_plan_s  *plan;
+    ///< The re-tuned plan.
+
+    void        *dlhandler;
+    ///< The library of the new kernel, a null pointer if it is not replaced.
+};
+
+
+
+/* ======== Function declaration ======== */
+
+/**
+ * @brief Function for loading a tuning database into a handler.
+ *
+ * @details Every line of the file is parsed into a ttc_tune_s object and
+ * inserted with ttc_tune_insert. Lines starting with `#` and malformed lines
+ * are skipped.
+ *
+ * @param[in,out]   handler A pointer pointing to a TTC handler.
+ * @param[in]       path    The path of the database.
+ *
+ * @return The number of loaded records, or -1 if the file cannot be opened.
+ *
+ * @sa struct ttc_tune, ttc_tune_save
+ *
+ */
+int32_t
+ttc_tune_load(
+        ttc_handler_s   *handler,
+        const char      *path
+        );
+
+
+/**
+ * @brief Function for appending a tuning record to a tuning database.
+ *
+ * @param[in]   path    The path of the database, it will be created with a
+ * header line if it does not exist.
+ * @param[in]   tune    The record to be saved.
+ *
+ * @return The status, return 0 if succeed, otherwise non-zero value.
+ *
+ * @sa struct ttc_tune, ttc_tune_load
+ *
+ */
+int32_t
+ttc_tune_save(
+        const char          *path,
+        const ttc_tune_s    *tune
+        );
+
+
+/**
+ * @brief Function for inserting a copy of a tuning record into a handler.
+ *
+ * @details If a record of the same signature exists, it is overwritten when
+ * `replace` is set or the new record has a higher bandwidth.
+ *
+ * @param[in,out]   handler A pointer pointing to a TTC handler.
+ * @param[in]       tune    The record to be inserted.
+ * @param[in]       replace Whether an existing record is always replaced.
+ *
+ * @return The status, return 0 if succeed, otherwise the `errno`.
+ *
+ */
+int32_t
+ttc_tune_insert(
+        ttc_handler_s       *handler,
+        const ttc_tune_s    *tune,
+        bool                replace
+        );
+
+
+/**
+ * @brief Function for looking up the tuning record of a signature.
+ *
+ * @param[in]   handler A pointer pointing to a TTC handler.
+ * @param[in]   param   A parameter describing the transposition.
+ *
+ * @return The pointer pointing to the record, or NULL if there is none.
+ *
+ */
+ttc_tune_s *
+ttc_tune_lookup(
+        const ttc_handler_s *handler,
+        const ttc_param_s   *param
+        );
+
+
+/**
+ * @brief Function for finding a tuning record to transfer to a signature
+ * without a record.
+ *
+ * @details The nearest record with the same data type, dimension and
+ * permutation is chosen, the distance of two sizes is the sum of
+ * `|log(size_a[i] / size_b[i])|`. Records farther than TTC_TUNE_NEAR_MAX are
+ * ignored. The record is only returned if a full search is not expected to
+ * pay off: a full search is assumed to gain TTC_TUNE_NEAR_GAIN times the
+ * distance (at most 1) of the predicted time on each of TTC_MODEL_JIT_CALLS
+ * calls, which is compared with its setup cost (see ttc_model_predict).
+ *
+ * @param[in]   handler A pointer pointing to a TTC handler.
+ * @param[in]   param   A parameter describing the transposition.
+ *
+ * @return The pointer pointing to the record, or NULL if a full search
+ * should be run.
+ *
+ * @sa ttc_tune_lookup, ttc_tune_create_plan
+ *
+ */
+ttc_tune_s *
+ttc_tune_transfer(
+        const ttc_handler_s *handler,
+        const ttc_param_s   *param
+        );
+
+
+/**
+ * @brief Function for creating a plan with the configuration of a record.
+ *
+ * @details The handler's options are overridden by the record, and TTC
+ * searches at most ttc_tune::max_impl implementations. The record is of the
+ * size, so the plan is not tiled (see ttc_opt::grid). The plan keeps the
+ * signature of `param`, so that it is found by ttc_lookup_plan.
+ *
+ * @param[in]   options A pointer pointing to the ttc_opt_s object in the
+ * ttc_handler_s object.
+ * @param[in]   param   A parameter describing the transposition.
+ * @param[in]   tune    The record describing the configuration.
+ *
+ * @return The pointer pointing to the plan. If some errors happen, it will
+ * return a null pointer.
+ *
+ * @sa ttc_create_plan
+ *
+ */
+ttc_plan_s *
+ttc_tune_create_plan(
+        const ttc_opt_s     *options,
+        const ttc_param_s   *param,
+        const ttc_tune_s    *tune
+        );
+
+
+/**
+ * @brief Function for releasing a list of tuning records.
+ *
+ * @param[in,out]   tune    The head of the list.
+ *
+ */
+void
+ttc_tune_release(
+        ttc_tune_s  *tune
+        );
+
+
+/**
+ * @brief Function for measuring the configuration of a record.
+ *
+ * @details A plan is created with ttc_tune_create_plan, timed with hot cache
+ * and after flushing the cache, and released.
+ *
+ * @param[in]       options A pointer pointing to the ttc_opt_s object in the
+ * ttc_handler_s object.
+ * @param[in]       param   A parameter describing the transposition.
+ * @param[in]       tune    The record describing the configuration.
+ * @param[in]       input   A pointer pointing to the input tensor.
+ * @param[out]      result  A pointer pointing to the result tensor.
+ * @param[in,out]   flush   A buffer of TTC_TUNE_FLUSH_SIZE bytes.
+ *
+ * @return The mean of the hot and cold time in seconds, or a negative value
+ * if the plan cannot be created or executed.
+ *
+ */
+double
+ttc_tune_eval(
+        const ttc_opt_s     *options,
+        const ttc_param_s   *param,
+        const ttc_tune_s    *tune,
+        const void          *input,
+        void                *result,
+        char                *flush
+        );
+
+
+/**
+ * @brief Function for timing a plan on given buffers.
+ *
+ * @param[in]       plan    A pointer pointing to a plan to be timed.
+ * @param[in]       input   A pointer pointing to the input tensor.
+ * @param[out]      result  A pointer pointing to the result tensor.
+ * @param[in,out]   flush   A buffer of TTC_TUNE_FLUSH_SIZE bytes written
+ * before every run to evict the tensors from cache, or NULL for timing with
+ * hot cache.
+ *
+ * @return The minimum time of TTC_TUNE_REPEAT runs in seconds, or a negative
+ * value if the plan cannot be executed.
+ *
+ */
+double
+ttc_tune_time_plan(
+        ttc_plan_s  *plan,
+        const void  *input,
+        void        *result,
+        char        *flush
+        );
+
+
+/**
+ * @brief Function for checking the statistics of a plan after an execution.
+ *
+ * @details If re-tuning is enabled (see TTC_OPT_RETUNE), the plan is a TTC
+ * kernel (TTC_ENGINE_JIT) of its size rather than of a tile, it has been
+ * executed at least TTC_RETUNE_MIN_CALLS times and has not been re-tuned
+ * yet, its bandwidth is compared with the best bandwidth of the comparable
+ * plans and tuning records (same data type and dimension). A re-tuning job
+ * is started if it falls below the threshold.
+ *
+ * @param[in]       handler A pointer pointing to a TTC handler.
+ * @param[in]       base    The plan of the handler the executed plan was
+ * chosen from, the executed plan itself if it is not a variant.
+ * @param[in,out]   plan    The executed plan.
+ *
+ * @return The status, return 0 if no job is needed or the job is started,
+ * otherwise the `errno`.
+ *
+ */
+int32_t
+ttc_retune_check(
+        const ttc_handler_s *handler,
+        const ttc_plan_s    *base,
+        ttc_plan_s          *plan
+        );
+
+
+/**
+ * @brief Function for getting the options of a re-tuning job.
+ *
+ * @details The kernel of a plan must keep the status bits it was chosen for,
+ * e.g. `TTC_NO_ALIGN` of an alignment variant, the streaming stores of a
+ * store variant, or the hot flags of a residency variant. The options are
+ * the handler's with the status of the plan. The search may only change the
+ * bits of TTC_TUNE_STATUS_MASK of a base plan without a store variant,
+ * taking their value from the handler's options. Any other plan is searched
+ * with all its bits fixed.
+ *
+ * @param[in]   options A pointer pointing to the handler's options.
+ * @param[in]   plan    The re-tuned plan.
+ * @param[in]   variant Whether the plan is a variant of a handler's plan.
+ * @param[out]  result  The options of the job, its `tune_db` is null.
+ *
+ * @return The status bits the search may change.
+ *
+ */
+uint32_t
+ttc_retune_options(
+        const ttc_opt_s     *options,
+        const ttc_plan_s    *plan,
+        bool                variant,
+        ttc_opt_s           *result
+        );
+
+
+/**
+ * @brief Function for getting the observed bandwidth of a plan.
+ *
+ * @param[in]   plan    A pointer pointing to a plan.
+ *
+ * @return The bandwidth in GB/s, or 0 if the plan has not been executed.
+ *
+ */
+double
+ttc_plan_bandwidth(
+        const ttc_plan_s    *plan
+        );
+
+
+/**
+ * @brief Function for waiting for and releasing a re-tuning job.
+ *
+ * @param[in,out]   retune  A pointer pointing to a ttc_retune_s object, or a
+ * null pointer.
+ *
+ */
+void
+ttc_retune_release(
+        void    *retune
+        );
+
+
+#ifdef __CPLUSPLUS
+}
+#endif
@@ -8,6 +8,7 @@
 
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "ttc_c.h"
 
@@ -22,6 +23,10 @@ extern "C" {
 
 #define TTC_GEN_BUF_SIZE        1024
 
+#define TTC_SMALL_BYTES         65536
+#define TTC_BODY_BYTES          64
+#define TTC_GRID_ELEMS          262144
+
 #define TTC_EXECUTABLE          "ttc"
 
 #define TTC_ARG_ALPHA           "--alpha="
@@ -77,11 +82,24 @@ extern "C" {
 #define TTC_PIPE_RD             0
 #define TTC_PIPE_WR             1
 
+#define TTC_ERR_TIMEOUT         -2
+#define TTC_POLL_INTERVAL_NS    10000000
+#define TTC_BUDGET_GROWTH       4
+#define TTC_BUDGET_MAX_STAGE    1024
+#define TTC_BUDGET_KEEP         ".kept"
+
 #define TTC_DIR_GEN_CODE        "ttc_transpositions/"
-#define TTC_DIR_BACK_GEN        "../"
+#define TTC_CD_GEN_CODE         "cd " TTC_DIR_GEN_CODE " && "
 #define TTC_DIR_TTC_ROOT        "$TTC_ROOT"
 
 #define TTC_FUNC_SYMBOL         "transpose"
+#define TTC_FUNC_NAME_MACRO     "TTC_FUNC_NAME"
+
+#define TTC_EXPORT_KERNEL_FMT   "%s_kernel_%u"
+#define TTC_EXPORT_TABLE_FMT    "%s_table"
+#define TTC_EXPORT_REG_FMT      "%s_register"
+#define TTC_EXPORT_AR           "ar rcs "
+#define TTC_EXPORT_NAME_MAX     64
 
 
 #define TTC_GXX_CMPL            "g++ -c -O3 -w -fPIC "
@@ -120,7 +138,10 @@ extern "C" {
  *
  * @details If a same plan exists (according to the parameter signature, see
  * also struct ttc_param), it will return a pointer pointing to
- * this plan, which is stored in a handler.
+ * this plan, which is stored in a handler. Otherwise a new plan is created
+ * with, in this order of preference, the tuning record of the signature, the
+ * built-in engine chosen by ttc_model_select, the record of a near size (see
+ * ttc_tune_transfer), or a full implementation search of TTC.
  *
  * @param[in,out]   handler A pointer pointing to a TTC handler.
  * @param[in]       param   A paramter object describing the plan.
@@ -139,6 +160,206 @@ ttc_plan(
         );
 
 
+/**
+ * @brief A function for looking up an existing plan in a handler.
+ *
+ * @details The plans are compared with the signature parameters, see also
+ * struct ttc_param.
+ *
+ * @param[in]   handler A pointer pointing to a TTC handler.
+ * @param[in]   param   A paramter object describing the plan.
+ *
+ * @return The pointer pointing to the matched plan. If no plan matches or
+ * errors happen, it will return a null pointer.
+ *
+ * @sa ttc_plan, ttc_attach_plan
+ *
+ */
+ttc_plan_s *
+ttc_lookup_plan(
+        const ttc_handler_s *handler,
+        const ttc_param_s   *param
+        );
+
+
+/**
+ * @brief A function for attaching a plan to the tail of a handler's plan list.
+ *
+ * @param[in,out]   handler A pointer pointing to a TTC handler.
+ * @param[in,out]   plan    A pointer pointing to the plan to be attached, it
+ * will be released together with the handler.
+ *
+ * @sa ttc_plan, ttc_lookup_plan
+ *
+ */
+void
+ttc_attach_plan(
+        ttc_handler_s   *handler,
+        ttc_plan_s      *plan
+        );
+
+
+/**
+ * @brief A function for removing a plan from a handler's plan list.
+ *
+ * @details The plan itself is not released.
+ *
+ * @param[in,out]   handler A pointer pointing to a TTC handler.
+ * @param[in,out]   plan    A pointer pointing to the plan to be detached.
+ *
+ * @sa ttc_attach_plan
+ *
+ */
+void
+ttc_detach_plan(
+        ttc_handler_s   *handler,
+        ttc_plan_s      *plan
+        );
+
+
+/**
+ * @brief A function for getting the variant of a plan for a cache residency.
+ *
+ * @details The variant is created with the options adjusted for the
+ * residency on first use, and stored in the plan.
+ *
+ * @param[in]       options     A pointer pointing to the ttc_opt_s object in
+ * the ttc_handler_s object.
+ * @param[in,out]   plan        A pointer pointing to the plan.
+ * @param[in]       residency   The resolved residency, TTC_RES_HOT or
+ * TTC_RES_COLD.
+ *
+ * @return The variant, or `plan` itself for other residencies or if the
+ * variant cannot be created.
+ *
+ * @sa enum ttc_residency, ttc_hw_residency
+ *
+ */
+ttc_plan_s *
+ttc_plan_variant(
+        const ttc_opt_s *options,
+        ttc_plan_s      *plan,
+        ttc_residency_e residency
+        );
+
+
+/**
+ * @brief A function for getting the variant of a plan for a store hint.
+ *
+ * @details The plan is returned if its kernel already has the requested
+ * stores (see ttc_plan::status). Otherwise the variant is created with
+ * TTC_USE_STM_STORE set or cleared in the options on first use, and stored
+ * in the plan.
+ *
+ * @param[in]       options A pointer pointing to the ttc_opt_s object in the
+ * ttc_handler_s object.
+ * @param[in,out]   plan    A pointer pointing to the plan.
+ * @param[in]       store   The resolved hint, TTC_STORE_CACHED or
+ * TTC_STORE_STREAM.
+ *
+ * @return The variant, or `plan` itself for other hints, for plans of
+ * registered kernels or if the variant cannot be created.
+ *
+ * @sa enum ttc_store, ttc_hw_store
+ *
+ */
+ttc_plan_s *
+ttc_plan_store(
+        const ttc_opt_s *options,
+        ttc_plan_s      *plan,
+        ttc_store_e     store
+        );
+
+
+/**
+ * @brief A function for getting the variant of a plan for the alignment of
+ * a call.
+ *
+ * @details A kernel compiled without TTC_NO_ALIGN uses aligned loads and
+ * stores of the vector width of the architecture (16, 32 or 64 bytes). It
+ * is only used if both pointers, the distances between the rows of both
+ * tensors (`lda[0]` and `ldb[0]`) and the tiles of a grid plan are
+ * multiples of the width, otherwise a kernel compiled with TTC_NO_ALIGN is
+ * used. The plan is returned if its kernel fits the call, otherwise the
+ * variant with TTC_NO_ALIGN flipped in ttc_plan::status is created on first
+ * use and stored in the plan.
+ *
+ * @param[in]       options A pointer pointing to the ttc_opt_s object in the
+ * ttc_handler_s object.
+ * @param[in,out]   plan    A pointer pointing to the plan.
+ * @param[in]       input   The input tensor of the call.
+ * @param[in]       result  The result tensor of the call.
+ *
+ * If the variant cannot be created, an aligned call runs the unaligned
+ * kernel of the plan, and an unaligned call runs a built-in engine stored
+ * as the variant, as the aligned kernel would fault on it.
+ *
+ * @return The variant, or `plan` itself if it fits the call, for plans of
+ * registered kernels or if the unaligned variant cannot be created, or
+ * NULL if an unaligned call has no kernel to run.
+ *
+ */
+ttc_plan_s *
+ttc_plan_align(
+        const ttc_opt_s *options,
+        ttc_plan_s      *plan,
+        const void      *input,
+        const void      *result
+        );
+
+
+/**
+ * @brief Functions for serializing the code generation.
+ *
+ * @details TTC's output and the generated files are shared by all the plans
+ * of a signature, so plans (including the ones of re-tuning threads) are
+ * generated one at a time.
+ *
+ */
+void
+ttc_gen_lock(
+        );
+
+
+/// @copydoc ttc_gen_lock
+void
+ttc_gen_unlock(
+        );
+
+
+/**
+ * @brief A function for getting the element size of a data type.
+ *
+ * @param[in]   datatype    The data type.
+ * @param[in]   output      Whether the size of the output element is wanted.
+ *
+ * @return The size of one element in bytes.
+ *
+ */
+uint32_t
+ttc_type_size(
+        ttc_datatype_e  datatype,
+        bool            output
+        );
+
+
+/**
+ * @brief A function for counting the bytes moved by a transposition.
+ *
+ * @details The input is read and the output is written once, the output is
+ * also read if `beta` is not zero.
+ *
+ * @param[in]   param   A parameter describing the transposition.
+ *
+ * @return The number of bytes.
+ *
+ */
+double
+ttc_param_bytes(
+        const ttc_param_s   *param
+        );
+
+
 /**
  * @brief A function that actually creats a new transposition plan.
  *
@@ -161,6 +382,187 @@ ttc_create_plan(
         const ttc_param_s   *param
         );
 
+/**
+ * @brief A function for allocating a plan without any kernel.
+ *
+ * @details It copies the parameter into a newly allocated plan, all the
+ * function pointers are set to null. It is called by ttc_create_plan and
+ * ttc_register_kernel.
+ *
+ * @param[in] param A paramter object describing the plan.
+ *
+ * @return The pointer pointing to the plan. If some errors happen, it will
+ * return a null pointer.
+ *
+ * @sa ttc_create_plan, ttc_register_kernel
+ *
+ */
+ttc_plan_s *
+ttc_alloc_plan(
+        const ttc_param_s   *param
+        );
+
+
+/**
+ * @brief A function for choosing the main body of a transposition.
+ *
+ * @details The kernels of TTC are fastest if the sizes along the input
+ * dimension 0 and the output dimension 0 (input dimension `perm[0]`) are
+ * multiples of the vector blocking, an odd size would push the whole tensor
+ * into the slower remainder code. The main body rounds both sizes down to a
+ * multiple of TTC_BODY_BYTES bytes (of the larger element), and is only
+ * chosen if it is not empty and differs from the tensor. Batches of rows
+ * (`perm[0]` is 0) and tensors of more than TTC_ENGINE_MAX_DIM dimensions
+ * have no main body.
+ *
+ * @param[in]   param   A paramter object describing the transposition.
+ * @param[out]  size    The sizes of the main body, an array of `dim`
+ * elements.
+ *
+ * @return Whether the transposition is split into a main body and remainder
+ * slabs.
+ *
+ * @sa ttc_exec_body
+ *
+ */
+bool
+ttc_body_size(
+        const ttc_param_s   *param,
+        uint32_t            *size
+        );
+
+
+/**
+ * @brief A function for choosing the tile of a grid plan.
+ *
+ * @details The tile spans `edge` elements along the input dimensions 0 and
+ * `perm[0]`, then the other dimensions in order until it has TTC_GRID_ELEMS
+ * elements. A size below the span is rounded down to a power of two, so that
+ * the tiles of a permutation only take a few shapes. The main body is the
+ * part of the tensor covered by whole tiles, the rest is transposed in
+ * slabs as for ttc_body_size.
+ *
+ * @param[in]   param   A paramter object describing the transposition.
+ * @param[in]   edge    The edge of the tile in elements, see ttc_opt::grid.
+ * @param[out]  tile    The sizes of the tile, an array of `dim` elements.
+ * @param[out]  body    The sizes of the main body, an array of `dim`
+ * elements.
+ *
+ * @return Whether the transposition can be tiled, tensors of more than
+ * TTC_ENGINE_MAX_DIM dimensions cannot.
+ *
+ * @sa ttc_grid_share, ttc_exec_body
+ *
+ */
+bool
+ttc_grid_tile(
+        const ttc_param_s   *param,
+        uint32_t            edge,
+        uint32_t            *tile,
+        uint32_t            *body
+        );
+
+
+/**
+ * @brief A function for creating a grid plan with the kernel of another one.
+ *
+ * @details A grid plan of the handler with the same data type, permutation,
+ * loop order and tile (see ttc_grid_tile), whose beta is zero if and only
+ * if the one of `param` is, has the kernel needed, so the
+ * library of the kernel is opened once more for the new plan instead of
+ * running TTC. The kernel stays loaded until both plans are released.
+ *
+ * @param[in]   handler A pointer pointing to a TTC handler.
+ * @param[in]   param   A paramter object describing the transposition.
+ *
+ * @return The pointer pointing to the new plan, or a null pointer if no plan
+ * has the kernel or tiling is disabled.
+ *
+ */
+ttc_plan_s *
+ttc_grid_share(
+        const ttc_handler_s *handler,
+        const ttc_param_s   *param
+        );
+
+
+/**
+ * @brief A function for getting the extents of the padded tensors.
+ *
+ * @details The extents are the leading dimensions if they are set, the
+ * sizes otherwise. A main body or a remainder slab is a sub-tensor of these
+ * extents.
+ *
+ * @param[in]   param   A paramter object describing the transposition.
+ * @param[out]  lda     The extents of the input, an array of `dim` elements.
+ * @param[out]  ldb     The extents of the output in the output order, an
+ * array of `dim` elements.
+ *
+ */
+void
+ttc_body_extents(
+        const ttc_param_s   *param,
+        int32_t             *lda,
+        int32_t             *ldb
+        );
+
+
+/**
+ * @brief A function for executing a plan split into a main body and slabs.
+ *
+ * @details The kernel `fn` of the plan transposes the main body
+ * ttc_plan::body_size with the extents of ttc_body_extents as leading
+ * dimensions, at once or on each tile of ttc_plan::tile in parallel. The
+ * slab beyond the body along each input dimension `d`, within the body
+ * along the dimensions before `d`, is transposed by ttc_engine_generic.
+ *
+ * @param[in]   plan    A pointer pointing to a plan with a main body.
+ * @param[in]   input   A pointer pointing to the input tensor.
+ * @param[out]  result  A pointer pointing to the result tensor.
+ *
+ * @return The status, 0 if succeed, otherwise -1.
+ *
+ * @sa ttc_body_size
+ *
+ */
+int32_t
+ttc_exec_body(
+        const ttc_plan_s    *plan,
+        const void          *input,
+        void                *result
+        );
+
+
+/**
+ * @brief A function for running the TTC executable.
+ *
+ * @details It forks a child process executing TTC with the arguments
+ * generated by ttc_gen_arg, waits for it and locates the generated header
+ * file name in its output. It is called by ttc_create_plan and
+ * ttc_export_static.
+ *
+ * @param[in]   options             A pointer pointing to the ttc_opt_s object
+ * in the ttc_handler_s object.
+ * @param[in]   param               A paramter object describing the plan.
+ * @param[out]  header_file_name    A buffer for storing the header file name.
+ * @param[in]   deadline            The time (see get_wtime) after which TTC
+ * is killed, 0 means no deadline.
+ *
+ * @return The status, return 0 if succeed, TTC_ERR_TIMEOUT if the deadline
+ * is exceeded, otherwise other non-zero value.
+ *
+ * @sa ttc_create_plan, ttc_export_static, ttc_locate_header
+ *
+ */
+int32_t
+ttc_run_ttc(
+        const ttc_opt_s     *options,
+        const ttc_param_s   *param,
+        char                header_file_name[],
+        double              deadline
+        );
+
+
 /**
  * @brief A function for releasing a plan.
  *
@@ -187,12 +589,15 @@ ttc_release_plan(
 /**
  * @brief A function for executing a plan.
  *
- * @details It is used internally.
+ * @details It is used internally. The call is counted and timed in
+ * ttc_plan::num_calls and ttc_plan::exec_time.
  *
- * @param[in]   plan    A pointer pointing to a plan to be executed.
- * @param[in]   input   A pointer pointing to the input tensor.
- * @param[out]  result  A pointer pointing to a piece of memory for storing
+ * @param[in,out]   plan    A pointer pointing to a plan to be executed.
+ * @param[in]       input   A pointer pointing to the input tensor.
+ * @param[out]      result  A pointer pointing to a piece of memory for storing
  * result.
+ * @param[in]       store   The store hint of the call for the built-in
+ * engines, the kernel of TTC keeps the stores it was compiled with.
  *
  * @return The status, if the function parameter are not correct (e.g. `value`
  * is null), then it will return -1. If some internal error happens (e.g. cannot
@@ -204,9 +609,10 @@ ttc_release_plan(
  */
 int32_t
 ttc_exec_plan(
-        const ttc_plan_s    *plan,
-        const void          *input,
-        void                *result
+        ttc_plan_s  *plan,
+        const void  *input,
+        void        *result,
+        ttc_store_e store
         );
 
 
@@ -376,7 +782,8 @@ ttc_gen_code(
 /**
  * @brief Function for creating shared library.
  *
- * @details It is called by function ttc_create_plan.
+ * @details It is called by function ttc_create_plan. Every library gets a
+ * name of its own, and its file is removed once it is loaded.
  *
  * @param[in]   options             A pointer pointing to the ttc_opt_s object
  * in the ttc_handler_s object.
@@ -402,6 +809,43 @@ ttc_gen_lib(
 
 
 
+/**
+ * @brief Function for choosing the compiling command of generated code.
+ *
+ * @param[in]   options A pointer pointing to the ttc_opt_s object in the
+ * ttc_handler_s object.
+ *
+ * @return The compiling command prefix, or NULL when the architecture is not
+ * supported.
+ *
+ * @sa ttc_gen_lib, ttc_link_cmd
+ *
+ */
+const char *
+ttc_cmpl_cmd(
+        const ttc_opt_s *options
+        );
+
+
+/**
+ * @brief Function for choosing the linking command of generated code.
+ *
+ * @param[in]   options A pointer pointing to the ttc_opt_s object in the
+ * ttc_handler_s object.
+ *
+ * @return The linking command prefix, or NULL when the architecture is not
+ * supported.
+ *
+ * @sa ttc_gen_lib, ttc_cmpl_cmd
+ *
+ */
+const char *
+ttc_link_cmd(
+        const ttc_opt_s *options
+        );
+
+
+
 #ifdef __CPLUSPLUS
 }
 #endif
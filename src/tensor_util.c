@@ -1,5 +1,9 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include "tensor_util.h"
 
+#include <time.h>
+
 
 
 bool
@@ -14,6 +18,15 @@ uint32cmp(
 }
 
 
+double
+get_wtime(
+        ) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+
 #ifdef TENSOR_DEBUG
 
 char func_namespace[128];
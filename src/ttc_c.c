@@ -11,6 +11,9 @@
 
 #include "tensor_util.h"
 #include "ttc_c_util.h"
+#include "ttc_c_tune.h"
+#include "ttc_c_hw.h"
+#include "ttc_c_engine.h"
 
 
 
@@ -41,7 +44,42 @@ ttc_init(
     handler->options.arch           = TTC_ARCH_DEFAULT;
     handler->options.tb             = TTC_TB_DEFAULT;
     handler->options.status         = 0;
+    handler->options.tune_db        = NULL;
+    handler->options.time_budget    = 0;
+    handler->options.retune         = 0;
+    handler->options.engine         = TTC_ENGINE_AUTO;
+    handler->options.grid           = 0;
     handler->plans                  = NULL;
+    handler->tunes                  = NULL;
+
+    // Detect hardware properties, and calibrate on request if no previous
+    // calibration of the CPU model is found
+    ttc_hw_detect(&handler->hw);
+    DEBUG_SET_NAMESPACE("ttc_init");
+    if (NULL != getenv(TTC_HW_CALIB_ENV) && 0 == handler->hw.num_points) {
+        DEBUG_INFO_OUTPUT("Calibrating on request of " TTC_HW_CALIB_ENV);
+        if (0 != ttc_calibrate(handler)) {
+            DEBUG_SET_NAMESPACE("ttc_init");
+            DEBUG_WARN_OUTPUT("Cannot calibrate the machine.");
+        }
+        DEBUG_SET_NAMESPACE("ttc_init");
+    }
+
+    // Load the records of previous tuning runs
+    const char *tune_db = getenv(TTC_TUNE_DB_ENV);
+    if (NULL != tune_db) {
+        DEBUG_INFO_OUTPUT("Loading tuning database from " TTC_TUNE_DB_ENV);
+        if (0 != ttc_set_opt(handler, TTC_OPT_TUNE_DB, tune_db,
+                    strlen(tune_db))) {
+            DEBUG_SET_NAMESPACE("ttc_init");
+            DEBUG_WARN_OUTPUT("Cannot set tuning database.");
+        }
+        DEBUG_SET_NAMESPACE("ttc_init");
+    }
+    else {
+        DEBUG_INFO_OUTPUT("Loading default tuning database.");
+        ttc_tune_load(handler, TTC_TUNE_DB_DEFAULT);
+    }
 
     return handler;
 }
@@ -57,13 +95,7 @@ ttc_release(
     if (NULL == handler)
         return;
 
-    // Release options
-    DEBUG_INFO_OUTPUT("Releasing ttc_handler_s::options.");
-    free(handler->options.pref_dist);
-    free(handler->options.blockings);
-    free(handler->options.affinity);
-
-    // Release plans
+    // Release plans, their re-tuning jobs may still use the options
     DEBUG_INFO_OUTPUT("Releasing ttc_handler_s::plans.");
     ttc_plan_s *plan_ptr = handler->plans;
     while (NULL != plan_ptr) {
@@ -73,6 +105,21 @@ ttc_release(
         plan_ptr = handler->plans;
     }
 
+    // Release options
+    DEBUG_INFO_OUTPUT("Releasing ttc_handler_s::options.");
+    free(handler->options.pref_dist);
+    free(handler->options.blockings);
+    free(handler->options.affinity);
+    free(handler->options.tune_db);
+
+    // Release tuning records
+    DEBUG_INFO_OUTPUT("Releasing ttc_handler_s::tunes.");
+    ttc_tune_release(handler->tunes);
+
+    // Release hardware properties
+    DEBUG_INFO_OUTPUT("Releasing ttc_handler_s::hw.");
+    ttc_hw_release(&handler->hw);
+
     // Release handler
     DEBUG_INFO_OUTPUT("Releasing handler object.");
     free(handler);
@@ -91,7 +138,9 @@ ttc_default_param(
         .perm       = NULL,
         .size       = NULL,
         .loop_perm  = NULL,
-        .dim        = 0
+        .dim        = 0,
+        .residency  = TTC_RES_NONE,
+        .store      = TTC_STORE_AUTO
     };
     return def_obj;
 }
@@ -204,6 +253,52 @@ ttc_set_opt(
         handler->options.status = *(uint32_t *)value;
         break;
 
+    case TTC_OPT_TIME_BUDGET:
+        DEBUG_INFO_OUTPUT("Setting option: "
+                "ttc_handler_s::options::time_budget.");
+
+        handler->options.time_budget = *(uint32_t *)value;
+        break;
+
+    case TTC_OPT_TUNE_DB:
+        DEBUG_INFO_OUTPUT("Setting option: "
+                "ttc_handler_s::options::tune_db.");
+
+        free(handler->options.tune_db);
+        handler->options.tune_db
+            = (char *)malloc(sizeof(char) * length + 1);
+        if (NULL == handler->options.tune_db) {
+            DEBUG_ERR_OUTPUT(strerror(errno));
+            return errno;
+        }
+        memcpy(handler->options.tune_db, value, sizeof(char) * length);
+        handler->options.tune_db[sizeof(char) * length] = '\0';
+
+        ttc_tune_load(handler, handler->options.tune_db);
+        DEBUG_SET_NAMESPACE("ttc_set_opt");
+        break;
+
+    case TTC_OPT_RETUNE:
+        DEBUG_INFO_OUTPUT("Setting option: "
+                "ttc_handler_s::options::retune.");
+
+        handler->options.retune = *(uint32_t *)value;
+        break;
+
+    case TTC_OPT_ENGINE:
+        DEBUG_INFO_OUTPUT("Setting option: "
+                "ttc_handler_s::options::engine.");
+
+        handler->options.engine = *(ttc_engine_e *)value;
+        break;
+
+    case TTC_OPT_GRID:
+        DEBUG_INFO_OUTPUT("Setting option: "
+                "ttc_handler_s::options::grid.");
+
+        handler->options.grid = *(uint32_t *)value;
+        break;
+
     default:
         DEBUG_WARN_OUTPUT("Unknown option. Won't change handler.");
         break;
@@ -239,6 +334,29 @@ int32_t ttc_transpose(
         return -1;
     }
 
+    // The kernels would overwrite the input of overlapping tensors while
+    // reading it. Dense tensors of the same precision are moved within the
+    // memory of the input, the others transpose a copy of the input.
+    if (TTC_ARCH_CUDA != handler->options.arch
+        && ttc_engine_overlap(param, input, result)) {
+        if (ttc_engine_is_inplace(param, input, result)) {
+            DEBUG_INFO_OUTPUT("Transposing in place.");
+            return ttc_engine_inplace(param, (void *)input, result);
+        }
+
+        DEBUG_INFO_OUTPUT("Transposing a copy of the overlapping input.");
+        const size_t bytes = ttc_engine_extent(param, false);
+        void *copy = malloc(bytes);
+        if (NULL == copy) {
+            DEBUG_ERR_OUTPUT(strerror(errno));
+            return -1;
+        }
+        memcpy(copy, input, bytes);
+        int32_t ret = ttc_transpose(handler, param, copy, result);
+        free(copy);
+        return ret;
+    }
+
 
     // Create plan
     DEBUG_INFO_OUTPUT("Creating a plan.");
@@ -253,7 +371,92 @@ int32_t ttc_transpose(
     DEBUG_INFO_OUTPUT("Executing transposition.");
     if (TTC_ARCH_CUDA == handler->options.arch)
         return ttc_exec_plan_cuda(plan, input, result);
-    else
-        return ttc_exec_plan(plan, input, result);
+
+    // Select the variant of the cache residency, or else of the stores, a
+    // small tensor is always cache resident and runs its base plan on the
+    // calling thread
+    const ttc_plan_s *base = plan;
+    const ttc_store_e store = ttc_hw_store(&handler->hw, param);
+    if (TTC_ENGINE_JIT == __atomic_load_n(&plan->engine, __ATOMIC_RELAXED)
+            && ttc_param_bytes(param) > TTC_SMALL_BYTES) {
+        plan = TTC_RES_NONE != param->residency
+            ? ttc_plan_variant(&handler->options, plan,
+                    ttc_hw_residency(&handler->hw, param))
+            : ttc_plan_store(&handler->options, plan, store);
+        DEBUG_SET_NAMESPACE("ttc_transpose");
+    }
+
+    // An unaligned call must not run an aligned kernel, whatever its size
+    plan = ttc_plan_align(&handler->options, plan, input, result);
+    DEBUG_SET_NAMESPACE("ttc_transpose");
+    if (NULL == plan) {
+        DEBUG_ERR_OUTPUT("Cannot get a plan for the alignment.");
+        return -1;
+    }
+
+    int32_t ret = ttc_exec_plan(plan, input, result, store);
+    DEBUG_SET_NAMESPACE("ttc_transpose");
+    if (0 == ret && 0 != ttc_retune_check(handler, base, plan))
+        DEBUG_WARN_OUTPUT("Cannot start re-tuning.");
+
+    return ret;
+}
+
+
+int32_t ttc_transpose64(
+        ttc_handler_s           *handler,
+        const ttc_param64_s     *param,
+        const void              *input,
+        void                    *result
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_transpose64");
+    DEBUG_INFO_OUTPUT("Executing transposition with 64-bit sizes.");
+    // Parameter check
+    if (NULL == handler) {
+        DEBUG_ERR_OUTPUT("handler is not initialized.");
+        return -1;
+    }
+    if (NULL == param || NULL == param->perm || NULL == param->size
+        || 0 == param->dim) {
+        DEBUG_ERR_OUTPUT("param is not well initialized.");
+        return -1;
+    }
+    if (NULL == input) {
+        DEBUG_ERR_OUTPUT("input is not initialized.");
+        return -1;
+    }
+    if (NULL == result) {
+        DEBUG_ERR_OUTPUT("result is not initialized.");
+        return -1;
+    }
+
+    // Parameters fitting in 32 bits use the plans of the handler
+    uint32_t size[param->dim];
+    int32_t lda[param->dim], ldb[param->dim];
+    bool narrow = true;
+    uint32_t idx;
+    for (idx = 0; idx < param->dim; ++idx) {
+        narrow = narrow && param->size[idx] <= UINT32_MAX
+            && (NULL == param->lda
+                || (param->lda[idx] >= 0 && param->lda[idx] <= INT32_MAX))
+            && (NULL == param->ldb
+                || (param->ldb[idx] >= 0 && param->ldb[idx] <= INT32_MAX));
+        size[idx] = (uint32_t)param->size[idx];
+        lda[idx] = NULL == param->lda ? 0 : (int32_t)param->lda[idx];
+        ldb[idx] = NULL == param->ldb ? 0 : (int32_t)param->ldb[idx];
+    }
+    if (narrow) {
+        ttc_param_s narrow_param = { .alpha = param->alpha,
+            .beta = param->beta, .lda = NULL == param->lda ? NULL : lda,
+            .ldb = NULL == param->ldb ? NULL : ldb,
+            .residency = param->residency, .store = param->store,
+            .datatype = param->datatype, .perm = param->perm, .size = size,
+            .loop_perm = param->loop_perm, .dim = param->dim };
+        return ttc_transpose(handler, &narrow_param, input, result);
+    }
+
+    DEBUG_INFO_OUTPUT("Transposing on the generic engine with 64-bit "
+            "indexes.");
+    return ttc_engine_wide(param, input, result);
 }
 
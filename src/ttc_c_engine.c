@@ -0,0 +1,2298 @@
+#define _GNU_SOURCE         // For sched_getcpu
+
+#include "ttc_c_engine.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sched.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "tensor_util.h"
+#include "ttc_c.h"
+#include "ttc_c_util.h"
+#include "ttc_c_micro.h"
+#include "ttc_c_hw.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+
+
+/* ======== Internal struct ======== */
+
+/**
+ * @brief Struct for the layout of a transposition in the output order.
+ *
+ * @details Dimension `j` is the output dimension `j`, i.e. the input
+ * dimension `perm[j]`, after dropping the dimensions of size 1 and merging
+ * the neighbours which are contiguous in both tensors. The strides are
+ * counted in elements. The output has its smallest stride along dimension 0,
+ * the input along dimension `inner`. The plane of these two dimensions is
+ * cut into blocks of `block[0]` x `block[1]` elements, every block of every
+ * index of the other (outer) dimensions is an independent work item. The
+ * rows of a layout with `stream` are written with non-temporal stores. A
+ * `skinny` plane has a side of at most TTC_MICRO_SKINNY elements, its blocks
+ * span the short side and cut only the long one. The plane kernels write
+ * the blocks of a layout with `stage` into a padded buffer first, see
+ * ttc_engine_conflict.
+ *
+ */
+typedef struct ttc_engine_layout {
+    uint32_t    dim;
+    uint32_t    inner;
+    uint64_t    size[TTC_ENGINE_MAX_DIM];
+    uint64_t    stride_a[TTC_ENGINE_MAX_DIM];
+    uint64_t    stride_b[TTC_ENGINE_MAX_DIM];
+    uint64_t    block[2];
+    uint64_t    num_blocks[2];
+    uint64_t    tile;
+    uint64_t    num_items;
+    bool        parallel;
+    bool        stream;
+    bool        skinny;
+    bool        stage;
+} ttc_engine_layout_s;
+
+
+/**
+ * @brief Type of the plane kernel of a data type.
+ *
+ * @details A plane kernel transposes `len[0]` x `len[1]` elements of the
+ * plane of the dimensions 0 and `inner` of a layout, starting at the element
+ * offsets `in_off` and `out_off`.
+ *
+ */
+typedef void (*ttc_engine_plane_fn)(
+        const ttc_engine_layout_s   *layout,
+        uint64_t                    in_off,
+        uint64_t                    out_off,
+        const uint64_t              len[2],
+        const void                  *input,
+        void                        *result,
+        double                      alpha,
+        double                      beta
+        );
+
+
+/**
+ * @brief Struct for a box of indices of a layout.
+ *
+ * @details The box covers `len[idx]` indices of every dimension `idx` of the
+ * layout, its first element is at the element offsets `in_off` and
+ * `out_off`.
+ *
+ */
+typedef struct ttc_engine_box {
+    uint64_t    in_off;
+    uint64_t    out_off;
+    uint64_t    len[TTC_ENGINE_MAX_DIM];
+} ttc_engine_box_s;
+
+
+/**
+ * @brief Struct for the invariants of a recursive transposition.
+ *
+ * @details Boxes of at most `leaf` elements are executed plane by plane, by
+ * `micro` if it is not NULL, by `plane` otherwise.
+ *
+ */
+typedef struct ttc_engine_rec {
+    const ttc_engine_layout_s   *layout;
+    ttc_engine_plane_fn         plane;
+    ttc_micro_fn                micro;
+    size_t                      elem_size;
+    uint64_t                    leaf;
+    const void                  *input;
+    void                        *result;
+    double                      alpha;
+    double                      beta;
+} ttc_engine_rec_s;
+
+
+
+/* ======== Internal macro ======== */
+
+#define TTC_ENGINE_MIN(a, b)    ((a) < (b) ? (a) : (b))
+#define TTC_ENGINE_MAX(a, b)    ((a) > (b) ? (a) : (b))
+
+/**
+ * @brief A macro running `call` for every work item of a layout.
+ *
+ * @details The items are shared by the OpenMP threads only if the layout is
+ * large enough, small layouts stay on the calling thread without entering a
+ * parallel region at all. The threads get contiguous ranges of items from
+ * ttc_engine_share, so that a cache domain works on one region of B.
+ *
+ */
+#define TTC_ENGINE_FOR_ITEMS(layout, item, call)                            \
+    do {                                                                    \
+        const int64_t num_items_ = (int64_t)(layout)->num_items;            \
+        if ((layout)->parallel) {                                           \
+            int32_t domains_[TTC_ENGINE_MAX_TEAM];                          \
+            _Pragma("omp parallel")                                         \
+            {                                                               \
+                int64_t item, end_;                                         \
+                ttc_engine_share(num_items_, domains_, &item, &end_);       \
+                for (; item < end_; ++item)                                 \
+                    call;                                                   \
+            }                                                               \
+        }                                                                   \
+        else {                                                              \
+            int64_t item;                                                   \
+            for (item = 0; item < num_items_; ++item)                       \
+                call;                                                       \
+        }                                                                   \
+    } while (0)
+
+/**
+ * @brief A macro defining the streaming row kernel of a data type.
+ *
+ * @details The rows are contiguous in both tensors and `beta` is 0. A row is
+ * scaled and converted into a buffer in the L1 cache, which is then streamed
+ * to the output, a plain copy is streamed directly.
+ *
+ */
+#define TTC_ENGINE_DEF_ROWS(name, in_t, out_t, ncomp)                       \
+static inline void                                                          \
+ttc_engine_row_##name(                                                      \
+        const ttc_engine_layout_s   *layout,                                \
+        uint64_t                    item,                                   \
+        const in_t                  *input,                                 \
+        out_t                       *result,                                \
+        double                      alpha                                   \
+        ) {                                                                 \
+    uint64_t in_off, out_off, len[2];                                       \
+    ttc_engine_item(layout, item, &in_off, &out_off, len);                  \
+    const in_t *in = input + in_off * (ncomp);                              \
+    out_t *out = result + out_off * (ncomp);                                \
+    const uint64_t num = len[0] * (ncomp);                                  \
+    if (1.0 == alpha && sizeof(in_t) == sizeof(out_t)) {                    \
+        ttc_engine_stream(out, in, num * sizeof(out_t));                    \
+        return;                                                             \
+    }                                                                       \
+    const out_t alpha_v = (out_t)alpha;                                     \
+    out_t buffer[TTC_ENGINE_STREAM_BUF];                                    \
+    uint64_t pos, idx;                                                      \
+    for (pos = 0; pos < num; pos += TTC_ENGINE_STREAM_BUF) {                \
+        const uint64_t chunk                                                \
+            = TTC_ENGINE_MIN(TTC_ENGINE_STREAM_BUF, num - pos);             \
+        _Pragma("omp simd")                                                 \
+        for (idx = 0; idx < chunk; ++idx)                                   \
+            buffer[idx] = alpha_v * (out_t)in[pos + idx];                   \
+        ttc_engine_stream(out + pos, buffer, chunk * sizeof(out_t));        \
+    }                                                                       \
+}                                                                           \
+                                                                            \
+static void                                                                 \
+ttc_engine_rows_##name(                                                     \
+        const ttc_engine_layout_s   *layout,                                \
+        const in_t                  *input,                                 \
+        out_t                       *result,                                \
+        double                      alpha                                   \
+        ) {                                                                 \
+    TTC_ENGINE_FOR_ITEMS(layout, item,                                      \
+            ttc_engine_row_##name(layout, item, input, result, alpha));     \
+}
+
+
+/**
+ * @brief A macro defining the generic kernel of a data type.
+ *
+ * @details Inside a block, tiles of `tile` x `tile` elements are transposed
+ * with the output written contiguously, so that the input lines of a tile
+ * stay in the L1 cache until all of their elements are used. Complex types
+ * are handled as `ncomp` scalars per element, `alpha` and `beta` are real.
+ *
+ */
+#define TTC_ENGINE_DEF_GENERIC(name, in_t, out_t, ncomp)                    \
+static void                                                                 \
+ttc_engine_plane_##name(                                                    \
+        const ttc_engine_layout_s   *layout,                                \
+        uint64_t                    in_off,                                 \
+        uint64_t                    out_off,                                \
+        const uint64_t              len[2],                                 \
+        const void                  *input,                                 \
+        void                        *result,                                \
+        double                      alpha,                                  \
+        double                      beta                                    \
+        ) {                                                                 \
+    const out_t alpha_v = (out_t)alpha;                                     \
+    const out_t beta_v = (out_t)beta;                                       \
+    const bool update = 0 != beta;                                          \
+    const uint32_t inner = layout->inner;                                   \
+    const uint64_t tile = layout->tile;                                     \
+    const uint64_t in_inc = layout->stride_a[0] * (ncomp);                  \
+    const uint64_t in_inc_r = layout->stride_a[inner] * (ncomp);            \
+    const uint64_t out_inc = layout->stride_b[0] * (ncomp);                 \
+    const uint64_t out_inc_r = layout->stride_b[inner] * (ncomp);           \
+    const in_t *in = (const in_t *)input + in_off * (ncomp);                \
+    out_t *out = (out_t *)result + out_off * (ncomp);                       \
+    uint64_t tile_0, tile_r, pos_0, pos_r;                                  \
+    for (tile_r = 0; tile_r < len[1]; tile_r += tile)                       \
+    for (tile_0 = 0; tile_0 < len[0]; tile_0 += tile) {                     \
+        const uint64_t end_0 = TTC_ENGINE_MIN(tile_0 + tile, len[0]);       \
+        const uint64_t end_r = TTC_ENGINE_MIN(tile_r + tile, len[1]);       \
+        for (pos_r = tile_r; pos_r < end_r; ++pos_r) {                      \
+            const in_t *in_row = in + pos_r * in_inc_r;                     \
+            out_t *out_row = out + pos_r * out_inc_r;                       \
+            if (update) {                                                   \
+                _Pragma("omp simd")                                         \
+                for (pos_0 = tile_0; pos_0 < end_0; ++pos_0) {              \
+                    uint32_t comp;                                          \
+                    for (comp = 0; comp < (ncomp); ++comp)                  \
+                        out_row[pos_0 * out_inc + comp]                     \
+                            = alpha_v * (out_t)in_row[pos_0 * in_inc + comp]\
+                            + beta_v * out_row[pos_0 * out_inc + comp];     \
+                }                                                           \
+            }                                                               \
+            else {                                                          \
+                _Pragma("omp simd")                                         \
+                for (pos_0 = tile_0; pos_0 < end_0; ++pos_0) {              \
+                    uint32_t comp;                                          \
+                    for (comp = 0; comp < (ncomp); ++comp)                  \
+                        out_row[pos_0 * out_inc + comp]                     \
+                            = alpha_v                                       \
+                            * (out_t)in_row[pos_0 * in_inc + comp];         \
+                }                                                           \
+            }                                                               \
+        }                                                                   \
+    }                                                                       \
+}                                                                           \
+                                                                            \
+static inline void                                                          \
+ttc_engine_block_##name(                                                    \
+        const ttc_engine_layout_s   *layout,                                \
+        uint64_t                    item,                                   \
+        const in_t                  *input,                                 \
+        out_t                       *result,                                \
+        double                      alpha,                                  \
+        double                      beta                                    \
+        ) {                                                                 \
+    uint64_t in_off, out_off, len[2];                                       \
+    ttc_engine_item(layout, item, &in_off, &out_off, len);                  \
+    if (!layout->stage) {                                                   \
+        ttc_engine_plane_##name(layout, in_off, out_off, len, input,        \
+                result, alpha, beta);                                       \
+        return;                                                             \
+    }                                                                       \
+                                                                            \
+    /* The rows of the buffer are a line apart from the block's end */      \
+    double buf[TTC_ENGINE_STAGE_BUF / sizeof(double)];                      \
+    const size_t elem_size = sizeof(out_t) * (ncomp);                       \
+    const uint64_t ld = len[0] + TTC_ENGINE_LINE / elem_size;               \
+    ttc_engine_layout_s staged = *layout;                                   \
+    staged.stride_b[layout->inner] = ld;                                    \
+    if (0 != beta)                                                          \
+        ttc_engine_stage(layout, len, elem_size, ld, buf,                   \
+                result + out_off * (ncomp), true);                          \
+    ttc_engine_plane_##name(&staged, in_off, 0, len, input, buf, alpha,     \
+            beta);                                                          \
+    ttc_engine_stage(layout, len, elem_size, ld, buf,                       \
+            result + out_off * (ncomp), false);                             \
+}                                                                           \
+                                                                            \
+static void                                                                 \
+ttc_engine_generic_##name(                                                  \
+        const ttc_engine_layout_s   *layout,                                \
+        const in_t                  *input,                                 \
+        out_t                       *result,                                \
+        double                      alpha,                                  \
+        double                      beta                                    \
+        ) {                                                                 \
+    if (layout->stream)                                                     \
+        ttc_engine_rows_##name(layout, input, result, alpha);               \
+    else                                                                    \
+        TTC_ENGINE_FOR_ITEMS(layout, item, ttc_engine_block_##name(layout,  \
+                    item, input, result, alpha, beta));                     \
+}
+
+
+
+/**
+ * @brief A macro defining the in-place chain and cycle kernels of a data type.
+ *
+ * @details The positions count elements from the lower one of the input and
+ * the result, which start at the positions `off[0]` and `off[1]`. Every
+ * position of the result takes the scaled element of its source position
+ * (see ttc_engine_source), which is still unchanged at that point.
+ *
+ * A chain starts at a position of the result outside of the input, whose
+ * element is not needed, and goes on with the source until a position
+ * outside of the result. A cycle stays within both tensors, the element of
+ * `start` is held aside for the last position, whose source is `start`
+ * again.
+ *
+ * The positions are marked in the bitmap `visited`. The marks are only a
+ * hint, a mark lost to another thread writing the same word only makes its
+ * position follow the cycle.
+ *
+ */
+#define TTC_ENGINE_DEF_INPLACE(name, t, ncomp)                              \
+static void                                                                 \
+ttc_engine_chain_##name(                                                    \
+        const ttc_engine_layout_s   *layout,                                \
+        const uint64_t              off[2],                                 \
+        uint64_t                    num_elem,                               \
+        uint64_t                    head,                                   \
+        t                           *data,                                  \
+        double                      alpha,                                  \
+        double                      beta,                                   \
+        uint64_t                    *visited                                \
+        ) {                                                                 \
+    const t alpha_v = (t)alpha, beta_v = (t)beta;                           \
+    uint64_t pos = head, from;                                              \
+    uint32_t comp;                                                          \
+    do {                                                                    \
+        __atomic_store_n(visited + pos / 64, 1ull << pos % 64               \
+                | __atomic_load_n(visited + pos / 64, __ATOMIC_RELAXED),    \
+                __ATOMIC_RELAXED);                                          \
+        from = off[0] + ttc_engine_source(layout, pos - off[1]);            \
+        t *out = data + pos * (ncomp);                                      \
+        const t *in = data + from * (ncomp);                                \
+        for (comp = 0; comp < (ncomp); ++comp)                              \
+            out[comp] = 0.0 == beta ? alpha_v * in[comp]                    \
+                : alpha_v * in[comp] + beta_v * out[comp];                  \
+        pos = from;                                                         \
+    } while (pos >= off[1] && pos - off[1] < num_elem);                     \
+}                                                                           \
+                                                                            \
+static void                                                                 \
+ttc_engine_cycle_##name(                                                    \
+        const ttc_engine_layout_s   *layout,                                \
+        const uint64_t              off[2],                                 \
+        uint64_t                    start,                                  \
+        t                           *data,                                  \
+        double                      alpha,                                  \
+        double                      beta,                                   \
+        uint64_t                    *visited                                \
+        ) {                                                                 \
+    const t alpha_v = (t)alpha, beta_v = (t)beta;                           \
+    t first[ncomp];                                                         \
+    uint32_t comp;                                                          \
+    for (comp = 0; comp < (ncomp); ++comp)                                  \
+        first[comp] = data[start * (ncomp) + comp];                         \
+                                                                            \
+    uint64_t pos = start, from;                                             \
+    while (start != (from = off[0] + ttc_engine_source(layout,              \
+                    pos - off[1]))) {                                       \
+        __atomic_store_n(visited + pos / 64, 1ull << pos % 64               \
+                | __atomic_load_n(visited + pos / 64, __ATOMIC_RELAXED),    \
+                __ATOMIC_RELAXED);                                          \
+        t *out = data + pos * (ncomp);                                      \
+        const t *in = data + from * (ncomp);                                \
+        for (comp = 0; comp < (ncomp); ++comp)                              \
+            out[comp] = 0.0 == beta ? alpha_v * in[comp]                    \
+                : alpha_v * in[comp] + beta_v * out[comp];                  \
+        pos = from;                                                         \
+    }                                                                       \
+    t *out = data + pos * (ncomp);                                          \
+    for (comp = 0; comp < (ncomp); ++comp)                                  \
+        out[comp] = 0.0 == beta ? alpha_v * first[comp]                     \
+            : alpha_v * first[comp] + beta_v * out[comp];                   \
+}                                                                           \
+                                                                            \
+static void                                                                 \
+ttc_engine_swap_##name(                                                     \
+        const ttc_engine_layout_s   *layout,                                \
+        const uint32_t              pair[2],                                \
+        uint64_t                    item,                                   \
+        t                           *data,                                  \
+        double                      alpha,                                  \
+        double                      beta                                    \
+        ) {                                                                 \
+    const uint64_t size = layout->size[pair[0]];                            \
+    const uint64_t num_tiles                                                \
+        = (size + TTC_ENGINE_SWAP - 1) / TTC_ENGINE_SWAP;                   \
+    const uint64_t tile_i = item % num_tiles;                               \
+    const uint64_t tile_j = item / num_tiles % num_tiles;                   \
+    if (tile_i > tile_j)                                                    \
+        return;                                                             \
+                                                                            \
+    uint64_t rest = item / num_tiles / num_tiles, off = 0;                  \
+    uint32_t idx;                                                           \
+    for (idx = 0; idx < layout->dim; ++idx) {                               \
+        if (pair[0] == idx || pair[1] == idx)                               \
+            continue;                                                       \
+        off += rest % layout->size[idx] * layout->stride_a[idx];            \
+        rest /= layout->size[idx];                                          \
+    }                                                                       \
+                                                                            \
+    const uint64_t stride_i = layout->stride_a[pair[0]];                    \
+    const uint64_t stride_j = layout->stride_a[pair[1]];                    \
+    const uint64_t end_i = TTC_ENGINE_MIN((tile_i + 1) * TTC_ENGINE_SWAP,   \
+            size);                                                          \
+    const uint64_t end_j = TTC_ENGINE_MIN((tile_j + 1) * TTC_ENGINE_SWAP,   \
+            size);                                                          \
+    const t alpha_v = (t)alpha, beta_v = (t)beta;                           \
+    uint64_t pos_i, pos_j;                                                  \
+    uint32_t comp;                                                          \
+    for (pos_j = tile_j * TTC_ENGINE_SWAP; pos_j < end_j; ++pos_j)          \
+    for (pos_i = tile_i * TTC_ENGINE_SWAP;                                  \
+            pos_i < end_i && (tile_i != tile_j || pos_i <= pos_j); ++pos_i) {\
+        t *x = data + (off + pos_i * stride_i + pos_j * stride_j) * (ncomp);\
+        t *y = data + (off + pos_j * stride_i + pos_i * stride_j) * (ncomp);\
+        for (comp = 0; comp < (ncomp); ++comp) {                            \
+            const t old_x = x[comp], old_y = y[comp];                       \
+            x[comp] = 0.0 == beta ? alpha_v * old_y                         \
+                : alpha_v * old_y + beta_v * old_x;                         \
+            y[comp] = 0.0 == beta ? alpha_v * old_x                         \
+                : alpha_v * old_x + beta_v * old_y;                         \
+        }                                                                   \
+    }                                                                       \
+}
+
+
+
+/* ======== Internal function ======== */
+
+uint64_t
+ttc_engine_source(
+        const ttc_engine_layout_s   *layout,
+        uint64_t                    pos
+        );
+
+
+bool
+ttc_engine_is_swap(
+        const ttc_engine_layout_s   *layout,
+        uint32_t                    pair[2]
+        );
+
+
+int32_t
+ttc_engine_permute(
+        const ttc_engine_layout_s   *layout,
+        ttc_datatype_e              datatype,
+        double                      alpha,
+        double                      beta,
+        void                        *input,
+        void                        *result
+        );
+
+
+bool
+ttc_engine_conflict(
+        uint64_t    stride
+        );
+
+
+void
+ttc_engine_stage(
+        const ttc_engine_layout_s   *layout,
+        const uint64_t              len[2],
+        size_t                      elem_size,
+        uint64_t                    ld,
+        void                        *buf,
+        void                        *result,
+        bool                        load
+        );
+
+
+void
+ttc_engine_item(
+        const ttc_engine_layout_s   *layout,
+        uint64_t                    item,
+        uint64_t                    *in_off,
+        uint64_t                    *out_off,
+        uint64_t                    len[2]
+        );
+
+
+void
+ttc_engine_stream(
+        void        *target,
+        const void  *source,
+        size_t      bytes
+        );
+
+
+ttc_micro_fn
+ttc_engine_kernel(
+        const ttc_engine_layout_s   *layout,
+        ttc_datatype_e              datatype
+        );
+
+
+ttc_engine_plane_fn
+ttc_engine_plane(
+        ttc_datatype_e  datatype
+        );
+
+
+void
+ttc_engine_recurse(
+        const ttc_engine_rec_s  *rec,
+        const ttc_engine_box_s  *box,
+        bool                    spawn
+        );
+
+
+void
+ttc_engine_leaf(
+        const ttc_engine_rec_s  *rec,
+        const ttc_engine_box_s  *box
+        );
+
+
+void
+ttc_engine_micro_block(
+        const ttc_engine_layout_s   *layout,
+        uint64_t                    item,
+        ttc_micro_fn                micro,
+        size_t                      elem_size,
+        const void                  *input,
+        void                        *result,
+        double                      alpha,
+        double                      beta
+        );
+
+
+void
+ttc_engine_micro(
+        const ttc_engine_layout_s   *layout,
+        ttc_micro_fn                micro,
+        size_t                      elem_size,
+        const void                  *input,
+        void                        *result,
+        double                      alpha,
+        double                      beta
+        );
+
+
+uint64_t
+ttc_engine_page(
+        );
+
+
+double
+ttc_engine_side(
+        uint64_t    len,
+        uint64_t    stride,
+        uint64_t    jump,
+        uint32_t    elem_size,
+        uint64_t    page
+        );
+
+
+double
+ttc_engine_cost(
+        const ttc_engine_layout_s   *layout,
+        uint32_t                    size_in,
+        uint32_t                    size_out,
+        uint64_t                    page
+        );
+
+
+double
+ttc_engine_pass_cost(
+        const ttc_param_s   *param,
+        uint64_t            page
+        );
+
+
+void
+ttc_engine_passes(
+        const ttc_param_s   *param,
+        uint32_t            num_in,
+        uint32_t            num_out,
+        ttc_engine_split_s  *split
+        );
+
+
+double
+ttc_engine_alpha(
+        const ttc_param_s   *param
+        );
+
+
+double
+ttc_engine_beta(
+        const ttc_param_s   *param
+        );
+
+
+int32_t
+ttc_engine_layout(
+        const ttc_param_s   *param,
+        ttc_engine_layout_s *layout
+        );
+
+
+int32_t
+ttc_engine_layout_ld(
+        const ttc_param_s   *param,
+        const uint64_t      *size_in,
+        const uint64_t      *lda,
+        const uint64_t      *ldb,
+        ttc_engine_layout_s *layout
+        );
+
+
+void
+ttc_engine_run(
+        const ttc_param_s           *param,
+        const ttc_engine_layout_s   *layout,
+        const void                  *input,
+        void                        *result
+        );
+
+
+
+/* ======== Internal kernel ======== */
+
+TTC_ENGINE_DEF_ROWS(s, float, float, 1)
+TTC_ENGINE_DEF_ROWS(d, double, double, 1)
+TTC_ENGINE_DEF_ROWS(c, float, float, 2)
+TTC_ENGINE_DEF_ROWS(z, double, double, 2)
+TTC_ENGINE_DEF_ROWS(sd, float, double, 1)
+TTC_ENGINE_DEF_ROWS(ds, double, float, 1)
+TTC_ENGINE_DEF_ROWS(cz, float, double, 2)
+TTC_ENGINE_DEF_ROWS(zc, double, float, 2)
+
+TTC_ENGINE_DEF_GENERIC(s, float, float, 1)
+TTC_ENGINE_DEF_GENERIC(d, double, double, 1)
+TTC_ENGINE_DEF_GENERIC(c, float, float, 2)
+TTC_ENGINE_DEF_GENERIC(z, double, double, 2)
+TTC_ENGINE_DEF_GENERIC(sd, float, double, 1)
+TTC_ENGINE_DEF_GENERIC(ds, double, float, 1)
+TTC_ENGINE_DEF_GENERIC(cz, float, double, 2)
+TTC_ENGINE_DEF_GENERIC(zc, double, float, 2)
+
+TTC_ENGINE_DEF_INPLACE(s, float, 1)
+TTC_ENGINE_DEF_INPLACE(d, double, 1)
+TTC_ENGINE_DEF_INPLACE(c, float, 2)
+TTC_ENGINE_DEF_INPLACE(z, double, 2)
+
+
+
+/* ======== Function definition ======== */
+
+bool
+ttc_engine_is_copy(
+        const ttc_param_s   *param
+        ) {
+    if (NULL == param || NULL == param->perm || NULL == param->size
+        || param->dim > TTC_ENGINE_MAX_DIM)
+        return false;
+
+    if (TTC_TYPE_DEFAULT != param->datatype && TTC_TYPE_S != param->datatype
+        && TTC_TYPE_D != param->datatype && TTC_TYPE_C != param->datatype
+        && TTC_TYPE_Z != param->datatype)
+        return false;
+    if (1.0 != ttc_engine_alpha(param) || 0.0 != ttc_engine_beta(param))
+        return false;
+
+    // Both tensors are one contiguous run in the same order
+    ttc_engine_layout_s layout;
+    return 0 == ttc_engine_layout(param, &layout) && 1 == layout.dim
+        && 1 == layout.stride_a[0] && 1 == layout.stride_b[0];
+}
+
+
+bool
+ttc_engine_is_skinny(
+        const ttc_param_s   *param
+        ) {
+    if (NULL == param || NULL == param->perm || NULL == param->size
+        || param->dim > TTC_ENGINE_MAX_DIM)
+        return false;
+
+    ttc_engine_layout_s layout;
+    return 0 == ttc_engine_layout(param, &layout) && layout.skinny;
+}
+
+
+bool
+ttc_engine_is_blocked(
+        const ttc_param_s   *param
+        ) {
+    if (NULL == param || NULL == param->perm || NULL == param->size
+        || param->dim > TTC_ENGINE_MAX_DIM)
+        return false;
+
+    ttc_engine_layout_s layout;
+    return 0 == ttc_engine_layout(param, &layout) && 0 != layout.inner
+        && !layout.skinny;
+}
+
+
+bool
+ttc_engine_is_rows(
+        const ttc_param_s   *param
+        ) {
+    if (NULL == param || NULL == param->perm || NULL == param->size
+        || param->dim > TTC_ENGINE_MAX_DIM)
+        return false;
+
+    // The input and output run along the same dimension
+    ttc_engine_layout_s layout;
+    return 0 == ttc_engine_layout(param, &layout) && 0 == layout.inner;
+}
+
+
+int32_t
+ttc_engine_split(
+        const ttc_param_s   *param,
+        ttc_engine_split_s  *split
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_engine_split");
+    // Parameter check
+    if (NULL == param || NULL == split) {
+        DEBUG_ERR_OUTPUT("Parameters are not well initialized.");
+        return -1;
+    }
+
+    ttc_engine_layout_s layout;
+    int32_t ret = ttc_engine_layout(param, &layout);
+    if (0 != ret)
+        return ret;
+
+    const uint64_t page = ttc_engine_page();
+    split->cost = ttc_engine_cost(&layout,
+            ttc_type_size(param->datatype, false),
+            ttc_type_size(param->datatype, true), page);
+    split->cost_split = split->cost;
+    if (0 == layout.inner || layout.skinny)
+        return 1;
+
+    // The groups are disjoint, the input group is the leading input
+    // dimensions and the output group the leading output dimensions
+    uint32_t best_in = 0, best_out = 0;
+    double best = split->cost * TTC_ENGINE_SPLIT_GAIN;
+    uint64_t elem_in = 1;
+    uint32_t num_in, num_out;
+    for (num_in = 1; num_in < param->dim
+            && (elem_in *= param->size[num_in - 1]) <= TTC_ENGINE_ROW;
+            ++num_in) {
+        uint64_t elem_out = 1;
+        for (num_out = 1; num_in + num_out <= param->dim
+                && param->perm[num_out - 1] >= num_in
+                && (elem_out *= param->size[param->perm[num_out - 1]])
+                <= TTC_ENGINE_ROW; ++num_out) {
+            ttc_engine_passes(param, num_in, num_out, split);
+            double cost = ttc_engine_pass_cost(&split->pass[0], page)
+                + ttc_engine_pass_cost(&split->pass[1], page);
+            if (cost < best) {
+                best = cost;
+                best_in = num_in;
+                best_out = num_out;
+            }
+        }
+    }
+    if (0 == best_in)
+        return 1;
+
+    ttc_engine_passes(param, best_in, best_out, split);
+    split->cost_split = best;
+
+    return 0;
+}
+
+
+bool
+ttc_engine_is_multipass(
+        const ttc_param_s   *param
+        ) {
+    if (NULL == param || NULL == param->perm || NULL == param->size
+        || param->dim > TTC_ENGINE_MAX_DIM)
+        return false;
+
+    ttc_engine_split_s split;
+    return 0 == ttc_engine_split(param, &split);
+}
+
+
+size_t
+ttc_engine_scratch(
+        const ttc_param_s   *param
+        ) {
+    if (!ttc_engine_is_multipass(param))
+        return 0;
+
+    size_t bytes = ttc_type_size(param->datatype, false);
+    uint32_t idx;
+    for (idx = 0; idx < param->dim; ++idx)
+        bytes *= param->size[idx];
+
+    return bytes;
+}
+
+
+int32_t
+ttc_engine_multipass(
+        const ttc_param_s   *param,
+        void                *scratch,
+        const void          *input,
+        void                *result
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_engine_multipass");
+    // Parameter check
+    if (NULL == param || NULL == input || NULL == result) {
+        DEBUG_ERR_OUTPUT("Parameters are not well initialized.");
+        return -1;
+    }
+
+    ttc_engine_split_s split;
+    int32_t ret = ttc_engine_split(param, &split);
+    if (ret < 0)
+        return -1;
+    if (1 == ret)
+        return ttc_engine_generic(param, input, result);
+    if (NULL == scratch) {
+        DEBUG_ERR_OUTPUT("scratch is not well initialized.");
+        return -1;
+    }
+
+    if (0 != ttc_engine_generic(&split.pass[0], input, scratch))
+        return -1;
+    return ttc_engine_generic(&split.pass[1], scratch, result);
+}
+
+
+int32_t
+ttc_engine_generic(
+        const ttc_param_s   *param,
+        const void          *input,
+        void                *result
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_engine_generic");
+    // Parameter check
+    if (NULL == param || NULL == input || NULL == result) {
+        DEBUG_ERR_OUTPUT("Parameters are not well initialized.");
+        return -1;
+    }
+
+    ttc_engine_layout_s layout;
+    int32_t ret = ttc_engine_layout(param, &layout);
+    if (0 != ret)
+        return ret < 0 ? -1 : 0;
+
+    ttc_engine_run(param, &layout, input, result);
+
+    return 0;
+}
+
+
+int32_t
+ttc_engine_recursive(
+        const ttc_param_s   *param,
+        const void          *input,
+        void                *result
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_engine_recursive");
+    // Parameter check
+    if (NULL == param || NULL == input || NULL == result) {
+        DEBUG_ERR_OUTPUT("Parameters are not well initialized.");
+        return -1;
+    }
+
+    ttc_engine_layout_s layout;
+    int32_t ret = ttc_engine_layout(param, &layout);
+    if (0 != ret)
+        return ret < 0 ? -1 : 0;
+
+    ttc_engine_rec_s rec;
+    rec.layout = &layout;
+    rec.plane = ttc_engine_plane(param->datatype);
+    rec.micro = ttc_engine_kernel(&layout, param->datatype);
+    rec.elem_size = ttc_type_size(param->datatype, false);
+    rec.leaf = TTC_ENGINE_LEAF / (ttc_type_size(param->datatype, false)
+            + ttc_type_size(param->datatype, true));
+    rec.input = input;
+    rec.result = result;
+    rec.alpha = ttc_engine_alpha(param);
+    rec.beta = ttc_engine_beta(param);
+
+    ttc_engine_box_s box;
+    box.in_off = 0;
+    box.out_off = 0;
+    uint32_t idx;
+    for (idx = 0; idx < layout.dim; ++idx)
+        box.len[idx] = layout.size[idx];
+
+    // The halves of the large boxes are tasks of the OpenMP threads
+    if (layout.parallel) {
+        _Pragma("omp parallel")
+        _Pragma("omp single nowait")
+        ttc_engine_recurse(&rec, &box, true);
+    }
+    else
+        ttc_engine_recurse(&rec, &box, false);
+
+    return 0;
+}
+
+
+int32_t
+ttc_engine_copy(
+        const ttc_param_s   *param,
+        const void          *input,
+        void                *result
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_engine_copy");
+    // Parameter check
+    if (NULL == param || NULL == param->size || NULL == input
+        || NULL == result) {
+        DEBUG_ERR_OUTPUT("Parameters are not well initialized.");
+        return -1;
+    }
+
+    size_t bytes = ttc_type_size(param->datatype, false);
+    uint32_t idx;
+    for (idx = 0; idx < param->dim; ++idx)
+        bytes *= param->size[idx];
+
+    // Large copies are split into chunks so that every thread streams a part
+    int64_t num_chunks = (bytes + TTC_ENGINE_CHUNK - 1) / TTC_ENGINE_CHUNK;
+    int32_t domains[TTC_ENGINE_MAX_TEAM];
+    _Pragma("omp parallel if(num_chunks > 1)")
+    {
+        int64_t chunk, end;
+        ttc_engine_share(num_chunks, domains, &chunk, &end);
+        for (; chunk < end; ++chunk) {
+            size_t offset = (size_t)chunk * TTC_ENGINE_CHUNK;
+            memcpy((char *)result + offset, (const char *)input + offset,
+                    TTC_ENGINE_MIN(TTC_ENGINE_CHUNK, bytes - offset));
+        }
+    }
+
+    return 0;
+}
+
+
+void
+ttc_engine_share(
+        int64_t     num_items,
+        int32_t     *domains,
+        int64_t     *begin,
+        int64_t     *end
+        ) {
+    int64_t num_threads = 1, rank = 0;
+#ifdef _OPENMP
+    num_threads = omp_get_num_threads();
+    rank = omp_get_thread_num();
+#endif
+    *begin = num_items * rank / num_threads;
+    *end = num_items * (rank + 1) / num_threads;
+
+    // The same for every thread, so either all or none reach the barrier
+    const char *env = getenv(TTC_ENGINE_DOMAIN_ENV);
+    if (num_threads < 2 || num_threads > TTC_ENGINE_MAX_TEAM
+        || (NULL != env && 0 == strcmp(env, "0")))
+        return;
+
+    const int cpu = sched_getcpu();
+    domains[rank] = cpu < 0 ? -1 : ttc_hw_domain((uint32_t)cpu);
+    _Pragma("omp barrier")
+
+    // The threads of the domains before this one come first, the mates in
+    // the same domain split its range
+    int64_t before = 0, mates = 0, pos = 0, idx;
+    for (idx = 0; idx < num_threads; ++idx) {
+        if (domains[idx] < 0)
+            return;
+        if (domains[idx] < domains[rank])
+            ++before;
+        else if (domains[idx] == domains[rank]) {
+            ++mates;
+            pos += idx < rank;
+        }
+    }
+    const int64_t first = num_items * before / num_threads;
+    const int64_t len = num_items * (before + mates) / num_threads - first;
+    *begin = first + len * pos / mates;
+    *end = first + len * (pos + 1) / mates;
+}
+
+
+size_t
+ttc_engine_extent(
+        const ttc_param_s   *param,
+        bool                output
+        ) {
+    if (NULL == param || NULL == param->perm || NULL == param->size
+        || 0 == param->dim)
+        return 0;
+
+    // The last dimension is not padded
+    const int32_t *ld = output ? param->ldb : param->lda;
+    size_t bytes = ttc_type_size(param->datatype, output);
+    uint32_t idx;
+    for (idx = 0; idx < param->dim; ++idx) {
+        const uint32_t dim_idx = output ? param->perm[idx] : idx;
+        if (dim_idx >= param->dim || 0 == param->size[dim_idx])
+            return 0;
+        const uint32_t size = param->size[dim_idx];
+        bytes *= NULL != ld && idx + 1 < param->dim ? (size_t)ld[idx] : size;
+    }
+
+    return bytes;
+}
+
+
+bool
+ttc_engine_overlap(
+        const ttc_param_s   *param,
+        const void          *input,
+        const void          *result
+        ) {
+    const size_t bytes_a = ttc_engine_extent(param, false);
+    const size_t bytes_b = ttc_engine_extent(param, true);
+    const char *begin_a = (const char *)input;
+    const char *begin_b = (const char *)result;
+
+    return 0 != bytes_a && 0 != bytes_b && begin_a < begin_b + bytes_b
+        && begin_b < begin_a + bytes_a;
+}
+
+
+bool
+ttc_engine_is_inplace(
+        const ttc_param_s   *param,
+        const void          *input,
+        const void          *result
+        ) {
+    if (NULL == param || NULL == param->perm || NULL == param->size
+        || 0 == param->dim || param->dim > TTC_ENGINE_MAX_DIM)
+        return false;
+    if (TTC_TYPE_DEFAULT != param->datatype && TTC_TYPE_S != param->datatype
+        && TTC_TYPE_D != param->datatype && TTC_TYPE_C != param->datatype
+        && TTC_TYPE_Z != param->datatype)
+        return false;
+
+    uint32_t idx;
+    for (idx = 0; idx + 1 < param->dim; ++idx) {
+        if (param->perm[idx] >= param->dim
+            || (NULL != param->lda
+                && (uint32_t)param->lda[idx] != param->size[idx])
+            || (NULL != param->ldb
+                && (uint32_t)param->ldb[idx] != param->size[param->perm[idx]]))
+            return false;
+    }
+
+    // The positions of both tensors count the same elements
+    const char *begin_a = (const char *)input;
+    const char *begin_b = (const char *)result;
+    const size_t shift = begin_a < begin_b
+        ? (size_t)(begin_b - begin_a) : (size_t)(begin_a - begin_b);
+    return 0 == shift % ttc_type_size(param->datatype, false);
+}
+
+
+int32_t
+ttc_engine_inplace(
+        const ttc_param_s   *param,
+        void                *input,
+        void                *result
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_engine_inplace");
+    // Parameter check
+    if (NULL == input || NULL == result
+        || !ttc_engine_is_inplace(param, input, result)) {
+        DEBUG_ERR_OUTPUT("Parameters are not well initialized.");
+        return -1;
+    }
+
+    ttc_engine_layout_s layout;
+    int32_t ret = ttc_engine_layout(param, &layout);
+    if (0 != ret)
+        return ret < 0 ? -1 : 0;
+
+    // A shifted copy only has to pick the direction of the copy
+    if (ttc_engine_is_copy(param)) {
+        if (input != result)
+            memmove(result, input, ttc_engine_extent(param, false));
+        return 0;
+    }
+
+    return ttc_engine_permute(&layout, param->datatype,
+            ttc_engine_alpha(param), ttc_engine_beta(param), input, result);
+}
+
+
+
+bool
+ttc_engine_is_large(
+        const ttc_param_s   *param
+        ) {
+    if (NULL == param)
+        return false;
+
+    const size_t elem_a = ttc_engine_extent(param, false)
+        / ttc_type_size(param->datatype, false);
+    const size_t elem_b = ttc_engine_extent(param, true)
+        / ttc_type_size(param->datatype, true);
+
+    return elem_a > INT32_MAX || elem_b > INT32_MAX;
+}
+
+
+int32_t
+ttc_engine_wide(
+        const ttc_param64_s *param,
+        const void          *input,
+        void                *result
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_engine_wide");
+    // Parameter check
+    if (NULL == param || NULL == param->perm || NULL == param->size
+        || 0 == param->dim || param->dim > TTC_ENGINE_MAX_DIM
+        || NULL == input || NULL == result) {
+        DEBUG_ERR_OUTPUT("Parameters are not well initialized.");
+        return -1;
+    }
+
+    // The bytes spanned by both tensors, as ttc_engine_extent, without
+    // overflowing. A leading dimension smaller than its size would fold the
+    // tensor onto itself.
+    size_t bytes[2] = { ttc_type_size(param->datatype, false),
+        ttc_type_size(param->datatype, true) };
+    uint32_t side, idx;
+    for (side = 0; side < 2; ++side) {
+        const int64_t *ld = 0 == side ? param->lda : param->ldb;
+        for (idx = 0; idx < param->dim; ++idx) {
+            const uint32_t dim_idx = 0 == side ? idx : param->perm[idx];
+            if (dim_idx >= param->dim) {
+                DEBUG_ERR_OUTPUT("The permutation is not valid.");
+                return -1;
+            }
+            const uint64_t size = param->size[dim_idx];
+            if (0 == size)
+                return 0;
+            if (NULL != ld && (ld[idx] < 0 || (uint64_t)ld[idx] < size)) {
+                DEBUG_ERR_OUTPUT("A leading dimension is smaller than its "
+                        "size.");
+                return -1;
+            }
+            const uint64_t extent = NULL != ld && idx + 1 < param->dim
+                ? (uint64_t)ld[idx] : size;
+            if (bytes[side] > SIZE_MAX / extent) {
+                DEBUG_ERR_OUTPUT("The tensors are too large.");
+                return -1;
+            }
+            bytes[side] *= extent;
+        }
+    }
+
+    // The layout only reads the scalars and the signature of the parameter
+    ttc_param_s narrow = { .alpha = param->alpha, .beta = param->beta,
+        .lda = NULL, .ldb = NULL, .residency = param->residency,
+        .store = param->store, .datatype = param->datatype,
+        .perm = param->perm, .size = NULL, .loop_perm = NULL,
+        .dim = param->dim };
+    uint64_t lda[TTC_ENGINE_MAX_DIM], ldb[TTC_ENGINE_MAX_DIM];
+    for (idx = 0; idx < param->dim; ++idx) {
+        lda[idx] = NULL == param->lda ? 0 : (uint64_t)param->lda[idx];
+        ldb[idx] = NULL == param->ldb ? 0 : (uint64_t)param->ldb[idx];
+    }
+    ttc_engine_layout_s layout;
+    int32_t ret = ttc_engine_layout_ld(&narrow, param->size,
+            NULL == param->lda ? NULL : lda, NULL == param->ldb ? NULL : ldb,
+            &layout);
+    if (0 != ret)
+        return ret < 0 ? -1 : 0;
+
+    const char *begin_a = (const char *)input;
+    const char *begin_b = (const char *)result;
+    if (begin_a < begin_b + bytes[1] && begin_b < begin_a + bytes[0]) {
+        // Dense tensors of the same precision are moved like in
+        // ttc_engine_inplace, the others transpose a copy of the input
+        const size_t elem_size = ttc_type_size(param->datatype, false);
+        const size_t shift = begin_a < begin_b
+            ? (size_t)(begin_b - begin_a) : (size_t)(begin_a - begin_b);
+        uint64_t num_elem = 1;
+        for (idx = 0; idx < layout.dim; ++idx)
+            num_elem *= layout.size[idx];
+        if (elem_size == ttc_type_size(param->datatype, true)
+            && bytes[0] == bytes[1] && bytes[0] == num_elem * elem_size
+            && 0 == shift % elem_size) {
+            DEBUG_INFO_OUTPUT("Transposing within the memory of the input.");
+            return ttc_engine_permute(&layout, param->datatype,
+                    ttc_engine_alpha(&narrow), ttc_engine_beta(&narrow),
+                    (void *)input, result);
+        }
+
+        DEBUG_INFO_OUTPUT("Transposing a copy of the overlapping input.");
+        void *copy = malloc(bytes[0]);
+        if (NULL == copy) {
+            DEBUG_ERR_OUTPUT(strerror(errno));
+            return -1;
+        }
+        memcpy(copy, input, bytes[0]);
+        ttc_engine_run(&narrow, &layout, copy, result);
+        free(copy);
+        return 0;
+    }
+
+    ttc_engine_run(&narrow, &layout, input, result);
+
+    return 0;
+}
+
+
+int32_t
+ttc_suggest_ld(
+        const ttc_param_s   *param,
+        int32_t             *lda,
+        int32_t             *ldb
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_suggest_ld");
+    // Parameter check
+    if (NULL == param || NULL == param->perm || NULL == param->size
+        || 0 == param->dim) {
+        DEBUG_ERR_OUTPUT("param is not well initialized.");
+        return -1;
+    }
+    uint32_t idx;
+    for (idx = 0; idx < param->dim; ++idx) {
+        if (param->perm[idx] >= param->dim || 0 == param->size[idx]
+            || param->size[idx] > INT32_MAX) {
+            DEBUG_ERR_OUTPUT("param is not well initialized.");
+            return -1;
+        }
+    }
+
+    // A leading dimension setting a conflicting stride grows by a line for
+    // the rows, so that they stay aligned to the lines, and by an element
+    // for the others. The stride before is not a conflict, so one step is
+    // enough.
+    uint32_t side;
+    for (side = 0; side < 2; ++side) {
+        int32_t *ld = 0 == side ? lda : ldb;
+        if (NULL == ld)
+            continue;
+        const uint64_t elem_size = ttc_type_size(param->datatype, 1 == side);
+        uint64_t stride = elem_size;
+        for (idx = 0; idx < param->dim; ++idx) {
+            const int32_t pad = 0 == idx ? TTC_ENGINE_LINE / elem_size : 1;
+            ld[idx] = param->size[0 == side ? idx : param->perm[idx]];
+            if (idx + 1 < param->dim && 1 != ld[idx]
+                && ttc_engine_conflict(stride * ld[idx])
+                && ld[idx] <= INT32_MAX - pad)
+                ld[idx] += pad;
+            stride *= ld[idx];
+        }
+    }
+
+    return 0;
+}
+
+
+
+/* ======== Internal function definition ======== */
+
+double
+ttc_engine_alpha(
+        const ttc_param_s   *param
+        ) {
+    // alpha has the precision of the input, a non-positive value means 1
+    double alpha;
+    if (TTC_TYPE_DEFAULT == param->datatype
+        || TTC_TYPE_S == param->datatype
+        || TTC_TYPE_C == param->datatype
+        || TTC_TYPE_SD == param->datatype
+        || TTC_TYPE_CZ == param->datatype
+       )
+        alpha = param->alpha.s;
+    else
+        alpha = param->alpha.d;
+
+    return alpha <= 0 ? 1.0 : alpha;
+}
+
+
+double
+ttc_engine_beta(
+        const ttc_param_s   *param
+        ) {
+    // beta has the precision of the output, a non-positive value means 0
+    double beta;
+    if (TTC_TYPE_DEFAULT == param->datatype
+        || TTC_TYPE_S == param->datatype
+        || TTC_TYPE_C == param->datatype
+        || TTC_TYPE_DS == param->datatype
+        || TTC_TYPE_ZC == param->datatype
+       )
+        beta = param->beta.s;
+    else
+        beta = param->beta.d;
+
+    return beta <= 0 ? 0.0 : beta;
+}
+
+
+/**
+ * @brief Function for getting the page size relevant to the TLB.
+ *
+ * @details The transparent huge pages back large tensors if the kernel
+ * always uses them, otherwise the base pages do. The result is detected at
+ * the first call and reused.
+ *
+ */
+uint64_t
+ttc_engine_page(
+        ) {
+    // Detected once, every thread computes the same value
+    static uint64_t cached = 0;
+    uint64_t known = __atomic_load_n(&cached, __ATOMIC_RELAXED);
+    if (0 != known)
+        return known;
+
+    long base = sysconf(_SC_PAGESIZE);
+    uint64_t page = base > 0 ? (uint64_t)base : 4096;
+    char mode[128] = { 0 };
+    FILE *file = fopen(TTC_ENGINE_THP_MODE, "r");
+    if (NULL != file) {
+        if (NULL == fgets(mode, sizeof(mode), file))
+            mode[0] = '\0';
+        fclose(file);
+    }
+    unsigned long long huge = 0;
+    if (NULL != strstr(mode, "[always]")
+        && NULL != (file = fopen(TTC_ENGINE_THP_SIZE, "r"))) {
+        if (1 == fscanf(file, "%llu", &huge) && huge > page)
+            page = huge;
+        fclose(file);
+    }
+
+    __atomic_store_n(&cached, page, __ATOMIC_RELAXED);
+    return page;
+}
+
+
+/**
+ * @brief Function for rating the locality of one tensor of a work item.
+ *
+ * @details The item touches runs of `len` elements along a dimension of
+ * `stride`, one run after another at a distance of `jump` elements. A run
+ * takes at least a cache line and a page unless the next run shares them.
+ *
+ * @return The cache lines plus the weighted pages per element.
+ *
+ */
+double
+ttc_engine_side(
+        uint64_t    len,
+        uint64_t    stride,
+        uint64_t    jump,
+        uint32_t    elem_size,
+        uint64_t    page
+        ) {
+    // Elements apart from each other are runs of their own
+    if (1 != stride) {
+        jump = stride;
+        len = 1;
+    }
+
+    double run = (double)len * elem_size;
+    double gap = (double)jump * elem_size;
+    double lines = TTC_ENGINE_MAX(run,
+            TTC_ENGINE_MIN(gap, (double)TTC_ENGINE_LINE)) / TTC_ENGINE_LINE;
+    double pages = TTC_ENGINE_MAX(run, TTC_ENGINE_MIN(gap, (double)page))
+        / page;
+
+    return (lines + TTC_ENGINE_PAGE_COST * pages) / len;
+}
+
+
+/**
+ * @brief Function for rating the locality of a layout.
+ *
+ * @details A block reads runs along the input dimension `inner` one index
+ * of dimension 0 after another, and writes runs along dimension 0 one index
+ * of `inner` after another. A row is followed by the next block of the row
+ * or the next index of dimension 1.
+ *
+ * @return The locality cost in cache lines per element.
+ *
+ */
+double
+ttc_engine_cost(
+        const ttc_engine_layout_s   *layout,
+        uint32_t                    size_in,
+        uint32_t                    size_out,
+        uint64_t                    page
+        ) {
+    const uint32_t inner = layout->inner;
+    const uint64_t len_0 = TTC_ENGINE_MIN(layout->block[0], layout->size[0]);
+    double cost;
+    uint64_t num;
+    if (0 == inner) {
+        bool next = len_0 < layout->size[0] || 1 == layout->dim;
+        cost = ttc_engine_side(len_0, layout->stride_a[0],
+                next ? len_0 : layout->stride_a[1], size_in, page)
+            + ttc_engine_side(len_0, layout->stride_b[0],
+                    next ? len_0 : layout->stride_b[1], size_out, page);
+        num = len_0;
+    }
+    else {
+        const uint64_t len_r = TTC_ENGINE_MIN(layout->block[1],
+                layout->size[inner]);
+        cost = ttc_engine_side(len_r, layout->stride_a[inner],
+                layout->stride_a[0], size_in, page)
+            + ttc_engine_side(len_0, layout->stride_b[0],
+                    layout->stride_b[inner], size_out, page);
+        num = len_0 * len_r;
+    }
+
+    // Locating a work item divides its index by every dimension
+    return cost + TTC_ENGINE_ITEM_COST * layout->dim / num;
+}
+
+
+/**
+ * @brief Function for rating the locality of a pass.
+ *
+ * @return The locality cost in cache lines per element, 0 if the pass is
+ * empty.
+ *
+ */
+double
+ttc_engine_pass_cost(
+        const ttc_param_s   *param,
+        uint64_t            page
+        ) {
+    ttc_engine_layout_s layout;
+    if (0 != ttc_engine_layout(param, &layout))
+        return 0.0;
+
+    return ttc_engine_cost(&layout, ttc_type_size(param->datatype, false),
+            ttc_type_size(param->datatype, true), page);
+}
+
+
+/**
+ * @brief Function for splitting a transposition at given groups.
+ *
+ * @details The scratch tensor has the first `num_in` input dimensions, then
+ * the first `num_out` output dimensions and the remaining ones in the
+ * output order. The first pass runs in the precision of the input.
+ *
+ */
+void
+ttc_engine_passes(
+        const ttc_param_s   *param,
+        uint32_t            num_in,
+        uint32_t            num_out,
+        ttc_engine_split_s  *split
+        ) {
+    uint32_t inv[TTC_ENGINE_MAX_DIM];
+    uint32_t idx, pos = 0;
+    for (idx = 0; idx < num_in; ++idx)
+        split->perm[0][pos++] = idx;
+    for (idx = 0; idx < num_out; ++idx)
+        split->perm[0][pos++] = param->perm[idx];
+    for (idx = num_out; idx < param->dim; ++idx)
+        if (param->perm[idx] >= num_in)
+            split->perm[0][pos++] = param->perm[idx];
+
+    for (idx = 0; idx < param->dim; ++idx) {
+        inv[split->perm[0][idx]] = idx;
+        split->size[0][idx] = param->size[idx];
+        split->size[1][idx] = param->size[split->perm[0][idx]];
+    }
+    for (idx = 0; idx < param->dim; ++idx)
+        split->perm[1][idx] = inv[param->perm[idx]];
+
+    ttc_param_s *pass = split->pass;
+    pass[0] = *param;
+    memset(&pass[0].alpha, 0, sizeof(pass[0].alpha));
+    memset(&pass[0].beta, 0, sizeof(pass[0].beta));
+    pass[0].ldb = NULL;
+    pass[0].loop_perm = NULL;
+    // The second pass reads the scratch tensor right away
+    pass[0].store = TTC_STORE_CACHED;
+    pass[0].perm = split->perm[0];
+    pass[0].size = split->size[0];
+    switch (param->datatype) {
+        case TTC_TYPE_SD:
+            pass[0].datatype = TTC_TYPE_S;
+            break;
+        case TTC_TYPE_DS:
+            pass[0].datatype = TTC_TYPE_D;
+            break;
+        case TTC_TYPE_CZ:
+            pass[0].datatype = TTC_TYPE_C;
+            break;
+        case TTC_TYPE_ZC:
+            pass[0].datatype = TTC_TYPE_Z;
+            break;
+        default:
+            break;
+    }
+
+    pass[1] = *param;
+    pass[1].lda = NULL;
+    pass[1].loop_perm = NULL;
+    pass[1].perm = split->perm[1];
+    pass[1].size = split->size[1];
+}
+
+
+/**
+ * @brief Function for computing the layout of a transposition.
+ *
+ * @return 0 if succeed, 1 if the tensor is empty, or -1 if the parameter is
+ * not supported.
+ *
+ */
+int32_t
+ttc_engine_layout(
+        const ttc_param_s   *param,
+        ttc_engine_layout_s *layout
+        ) {
+    if (NULL == param->perm || NULL == param->size || 0 == param->dim
+        || param->dim > TTC_ENGINE_MAX_DIM) {
+        DEBUG_ERR_OUTPUT("The dimension is not supported.");
+        return -1;
+    }
+
+    uint64_t size[TTC_ENGINE_MAX_DIM];
+    uint64_t lda[TTC_ENGINE_MAX_DIM], ldb[TTC_ENGINE_MAX_DIM];
+    uint32_t idx;
+    for (idx = 0; idx < param->dim; ++idx) {
+        size[idx] = param->size[idx];
+        lda[idx] = NULL == param->lda ? 0 : (uint64_t)param->lda[idx];
+        ldb[idx] = NULL == param->ldb ? 0 : (uint64_t)param->ldb[idx];
+    }
+
+    return ttc_engine_layout_ld(param, size, NULL == param->lda ? NULL : lda,
+            NULL == param->ldb ? NULL : ldb, layout);
+}
+
+
+/**
+ * @brief Function for creating the layout of a transposition from 64-bit
+ * sizes and leading dimensions.
+ *
+ * @details The `size`, `lda` and `ldb` of the parameter are ignored, the
+ * arrays given replace them (`lda` and `ldb` may be null).
+ *
+ * @return 0 if succeed, 1 if the tensor is empty, or -1 if the parameter is
+ * not supported.
+ *
+ */
+int32_t
+ttc_engine_layout_ld(
+        const ttc_param_s   *param,
+        const uint64_t      *size_in,
+        const uint64_t      *lda,
+        const uint64_t      *ldb,
+        ttc_engine_layout_s *layout
+        ) {
+    if (NULL == param->perm || 0 == param->dim
+        || param->dim > TTC_ENGINE_MAX_DIM) {
+        DEBUG_ERR_OUTPUT("The dimension is not supported.");
+        return -1;
+    }
+
+    uint64_t stride_a[TTC_ENGINE_MAX_DIM];
+    uint64_t stride = 1;
+    uint32_t idx;
+    for (idx = 0; idx < param->dim; ++idx) {
+        if (0 == size_in[idx])
+            return 1;
+        stride_a[idx] = stride;
+        stride *= NULL == lda ? size_in[idx] : lda[idx];
+    }
+
+    // Dimensions of size 1 are dropped, and a dimension contiguous to the
+    // previous one in both tensors extends it
+    uint32_t dim = 0;
+    stride = 1;
+    for (idx = 0; idx < param->dim; ++idx) {
+        uint32_t perm = param->perm[idx];
+        if (perm >= param->dim) {
+            DEBUG_ERR_OUTPUT("The permutation is not valid.");
+            return -1;
+        }
+        uint64_t size = size_in[perm];
+        uint64_t stride_b = stride;
+        stride *= NULL == ldb ? size : ldb[idx];
+        if (1 == size)
+            continue;
+        if (0 != dim && stride_a[perm] == layout->stride_a[dim - 1]
+                * layout->size[dim - 1]
+            && stride_b == layout->stride_b[dim - 1] * layout->size[dim - 1]) {
+            layout->size[dim - 1] *= size;
+            continue;
+        }
+        layout->size[dim] = size;
+        layout->stride_a[dim] = stride_a[perm];
+        layout->stride_b[dim] = stride_b;
+        ++dim;
+    }
+    if (0 == dim) {
+        layout->size[0] = 1;
+        layout->stride_a[0] = layout->stride_b[0] = 1;
+        dim = 1;
+    }
+    layout->dim = dim;
+    layout->inner = 0;
+    for (idx = 1; idx < dim; ++idx)
+        if (layout->stride_a[idx] < layout->stride_a[layout->inner])
+            layout->inner = idx;
+
+    // Long contiguous rows without beta bypass the caches, the output would
+    // only evict useful data. A call that reads the output again keeps it in
+    // the caches, one that does not streams shorter rows as well.
+    const uint64_t row = layout->size[0]
+        * ttc_type_size(param->datatype, true);
+    layout->stream = 0 == layout->inner && 1 == layout->stride_a[0]
+        && 1 == layout->stride_b[0] && 0.0 == ttc_engine_beta(param)
+        && TTC_STORE_CACHED != param->store
+        && row >= (TTC_STORE_STREAM == param->store ? TTC_ENGINE_STREAM_MIN
+                : TTC_ENGINE_STREAM_ROW);
+
+    // A plane with a short and a long side is only cut along the long side,
+    // square blocks would be mostly empty and give too few work items
+    const uint64_t size_r = layout->size[layout->inner];
+    layout->skinny = 0 != layout->inner
+        && TTC_ENGINE_MIN(layout->size[0], size_r) <= TTC_MICRO_SKINNY
+        && (layout->size[0] >= TTC_ENGINE_BLOCK
+            || size_r >= TTC_ENGINE_BLOCK);
+
+    // Both tensors run along dimension 0 if it is kept in place, then a
+    // block is a long row and needs no tiling
+    if (0 == layout->inner) {
+        layout->block[0] = TTC_ENGINE_ROW;
+        layout->block[1] = 1;
+        layout->tile = TTC_ENGINE_ROW;
+    }
+    else if (layout->skinny) {
+        layout->block[0] = layout->size[0] <= TTC_MICRO_SKINNY
+            ? layout->size[0] : TTC_ENGINE_ROW;
+        layout->block[1] = size_r <= TTC_MICRO_SKINNY ? size_r
+            : TTC_ENGINE_ROW;
+        layout->tile = TTC_ENGINE_TILE;
+    }
+    else {
+        layout->block[0] = TTC_ENGINE_BLOCK;
+        layout->block[1] = TTC_ENGINE_BLOCK;
+        layout->tile = TTC_ENGINE_TILE;
+    }
+
+    // The plane kernels write square blocks element by element, so rows of
+    // the output that conflict in the caches would be evicted and reloaded
+    // many times, such blocks are written row by row through a padded
+    // buffer. The micro-kernels write whole vectors, and measured no gain.
+    layout->stage = 0 != layout->inner && !layout->skinny
+        && 1 == layout->stride_b[0]
+        && ttc_engine_conflict(layout->stride_b[layout->inner]
+                * ttc_type_size(param->datatype, true));
+
+    uint64_t elem = layout->size[0];
+    layout->num_blocks[0] = (layout->size[0] + layout->block[0] - 1)
+        / layout->block[0];
+    layout->num_blocks[1] = 1;
+    layout->num_items = layout->num_blocks[0];
+    for (idx = 1; idx < layout->dim; ++idx) {
+        elem *= layout->size[idx];
+        if (idx == layout->inner) {
+            layout->num_blocks[1] = (layout->size[idx] + layout->block[1] - 1)
+                / layout->block[1];
+            layout->num_items *= layout->num_blocks[1];
+        }
+        else
+            layout->num_items *= layout->size[idx];
+    }
+    layout->parallel = elem >= TTC_ENGINE_PAR_MIN;
+
+    return 0;
+}
+
+
+/**
+ * @brief Function for locating a work item of a layout.
+ *
+ * @details The blocks along the output dimension 0 are the fastest varying,
+ * so that neighbouring items write neighbouring parts of the output.
+ *
+ */
+void
+ttc_engine_item(
+        const ttc_engine_layout_s   *layout,
+        uint64_t                    item,
+        uint64_t                    *in_off,
+        uint64_t                    *out_off,
+        uint64_t                    len[2]
+        ) {
+    uint64_t block_0 = item % layout->num_blocks[0] * layout->block[0];
+    item /= layout->num_blocks[0];
+    uint64_t block_r = item % layout->num_blocks[1] * layout->block[1];
+    item /= layout->num_blocks[1];
+
+    const uint32_t inner = layout->inner;
+    len[0] = TTC_ENGINE_MIN(layout->block[0], layout->size[0] - block_0);
+    len[1] = 0 == inner ? 1
+        : TTC_ENGINE_MIN(layout->block[1], layout->size[inner] - block_r);
+    *in_off = block_0 * layout->stride_a[0];
+    *out_off = block_0 * layout->stride_b[0];
+    if (0 != inner) {
+        *in_off += block_r * layout->stride_a[inner];
+        *out_off += block_r * layout->stride_b[inner];
+    }
+
+    uint32_t idx;
+    for (idx = 1; idx < layout->dim; ++idx) {
+        if (idx == inner)
+            continue;
+        uint64_t pos = item % layout->size[idx];
+        item /= layout->size[idx];
+        *in_off += pos * layout->stride_a[idx];
+        *out_off += pos * layout->stride_b[idx];
+    }
+}
+
+
+/**
+ * @brief Function for executing the blocks of a layout with a micro-kernel.
+ *
+ * @details A block is the transpose of a `len[1]` x `len[0]` matrix with the
+ * leading dimension `stride_a[0]`, into the leading dimension
+ * `stride_b[inner]`.
+ *
+ */
+void
+ttc_engine_micro(
+        const ttc_engine_layout_s   *layout,
+        ttc_micro_fn                micro,
+        size_t                      elem_size,
+        const void                  *input,
+        void                        *result,
+        double                      alpha,
+        double                      beta
+        ) {
+    TTC_ENGINE_FOR_ITEMS(layout, item, ttc_engine_micro_block(layout, item,
+                micro, elem_size, input, result, alpha, beta));
+}
+
+
+void
+ttc_engine_micro_block(
+        const ttc_engine_layout_s   *layout,
+        uint64_t                    item,
+        ttc_micro_fn                micro,
+        size_t                      elem_size,
+        const void                  *input,
+        void                        *result,
+        double                      alpha,
+        double                      beta
+        ) {
+    uint64_t in_off, out_off, len[2];
+    ttc_engine_item(layout, item, &in_off, &out_off, len);
+    micro((const char *)input + in_off * elem_size, layout->stride_a[0],
+            (char *)result + out_off * elem_size,
+            layout->stride_b[layout->inner], len[1], len[0], alpha, beta);
+}
+
+
+/**
+ * @brief Function for checking if a stride maps rows to few cache sets.
+ *
+ * @details Rows at a stride of a multiple of TTC_ENGINE_CONFLICT bytes fall
+ * into a few sets of a cache, e.g. 4 of the 64 sets of an L1 data cache,
+ * which hold fewer lines than the rows of a block. The lines of a block
+ * would evict each other before they are complete.
+ *
+ * @param[in]   stride  The stride in bytes.
+ *
+ */
+bool
+ttc_engine_conflict(
+        uint64_t    stride
+        ) {
+    return 0 == stride % TTC_ENGINE_CONFLICT;
+}
+
+
+/**
+ * @brief Function for copying a staged block between the buffer and the
+ * result.
+ *
+ * @details The block has `len[1]` rows of `len[0]` contiguous elements, at
+ * the stride `stride_b[inner]` in the result and `ld` in the buffer. The
+ * rows are loaded into the buffer if `load`, stored from it otherwise, one
+ * after another so that only two lines are open at a time.
+ *
+ */
+void
+ttc_engine_stage(
+        const ttc_engine_layout_s   *layout,
+        const uint64_t              len[2],
+        size_t                      elem_size,
+        uint64_t                    ld,
+        void                        *buf,
+        void                        *result,
+        bool                        load
+        ) {
+    const uint64_t stride = layout->stride_b[layout->inner] * elem_size;
+    const size_t row = len[0] * elem_size;
+    char *staged = (char *)buf;
+    char *out = (char *)result;
+    uint64_t idx;
+    for (idx = 0; idx < len[1]; ++idx) {
+        if (load)
+            memcpy(staged + idx * ld * elem_size, out + idx * stride, row);
+        else
+            memcpy(out + idx * stride, staged + idx * ld * elem_size, row);
+    }
+}
+
+
+/**
+ * @brief Function for choosing the register kernel of a layout.
+ *
+ * @details The planes of a real transposition are 2-D transposes for the
+ * SIMD micro-kernels if the CPU has them, or for the skinny kernels if the
+ * planes have a short side.
+ *
+ * @return The kernel, or NULL if the plane kernel of the data type is used.
+ *
+ */
+ttc_micro_fn
+ttc_engine_kernel(
+        const ttc_engine_layout_s   *layout,
+        ttc_datatype_e              datatype
+        ) {
+    if (0 == layout->inner || 1 != layout->stride_a[layout->inner]
+        || 1 != layout->stride_b[0])
+        return NULL;
+
+    return layout->skinny ? ttc_micro_skinny(datatype)
+        : ttc_micro_select(datatype);
+}
+
+
+ttc_engine_plane_fn
+ttc_engine_plane(
+        ttc_datatype_e  datatype
+        ) {
+    switch (datatype) {
+        case TTC_TYPE_D:
+            return ttc_engine_plane_d;
+        case TTC_TYPE_C:
+            return ttc_engine_plane_c;
+        case TTC_TYPE_Z:
+            return ttc_engine_plane_z;
+        case TTC_TYPE_SD:
+            return ttc_engine_plane_sd;
+        case TTC_TYPE_DS:
+            return ttc_engine_plane_ds;
+        case TTC_TYPE_CZ:
+            return ttc_engine_plane_cz;
+        case TTC_TYPE_ZC:
+            return ttc_engine_plane_zc;
+        default:
+            return ttc_engine_plane_s;
+    }
+}
+
+
+/**
+ * @brief Function for transposing a box by divide and conquer.
+ *
+ * @details The longest dimension of the box is halved until a box has at
+ * most `leaf` elements, so that every level of the cache holds the boxes of
+ * some level of the recursion whatever the sizes are. If `spawn`, the first
+ * half of a box larger than TTC_ENGINE_TASK elements is an OpenMP task.
+ *
+ */
+void
+ttc_engine_recurse(
+        const ttc_engine_rec_s  *rec,
+        const ttc_engine_box_s  *box,
+        bool                    spawn
+        ) {
+    const ttc_engine_layout_s *layout = rec->layout;
+    uint64_t elem = 1;
+    uint32_t idx, split = 0;
+    for (idx = 0; idx < layout->dim; ++idx) {
+        elem *= box->len[idx];
+        if (box->len[idx] > box->len[split])
+            split = idx;
+    }
+    if (elem <= rec->leaf) {
+        ttc_engine_leaf(rec, box);
+        return;
+    }
+
+    ttc_engine_box_s half[2];
+    half[0] = *box;
+    half[1] = *box;
+    half[0].len[split] = box->len[split] / 2;
+    half[1].len[split] = box->len[split] - half[0].len[split];
+    half[1].in_off += half[0].len[split] * layout->stride_a[split];
+    half[1].out_off += half[0].len[split] * layout->stride_b[split];
+
+    spawn = spawn && elem > TTC_ENGINE_TASK;
+    if (spawn) {
+        _Pragma("omp task firstprivate(half)")
+        ttc_engine_recurse(rec, &half[0], true);
+    }
+    else
+        ttc_engine_recurse(rec, &half[0], false);
+    ttc_engine_recurse(rec, &half[1], spawn);
+}
+
+
+/**
+ * @brief Function for transposing a box plane by plane.
+ *
+ * @details The indices of the outer dimensions are visited like an odometer,
+ * every index is a plane of `len[0]` x `len[inner]` elements.
+ *
+ */
+void
+ttc_engine_leaf(
+        const ttc_engine_rec_s  *rec,
+        const ttc_engine_box_s  *box
+        ) {
+    const ttc_engine_layout_s *layout = rec->layout;
+    const uint32_t inner = layout->inner;
+    const uint64_t len[2]
+        = { box->len[0], 0 == inner ? 1 : box->len[inner] };
+    uint64_t pos[TTC_ENGINE_MAX_DIM] = { 0 };
+    uint64_t in_off = box->in_off, out_off = box->out_off;
+    uint32_t idx;
+
+    do {
+        if (NULL != rec->micro)
+            rec->micro((const char *)rec->input + in_off * rec->elem_size,
+                    layout->stride_a[0],
+                    (char *)rec->result + out_off * rec->elem_size,
+                    layout->stride_b[inner], len[1], len[0], rec->alpha,
+                    rec->beta);
+        else
+            rec->plane(layout, in_off, out_off, len, rec->input,
+                    rec->result, rec->alpha, rec->beta);
+
+        for (idx = 1; idx < layout->dim; ++idx) {
+            if (idx == inner)
+                continue;
+            if (++pos[idx] < box->len[idx]) {
+                in_off += layout->stride_a[idx];
+                out_off += layout->stride_b[idx];
+                break;
+            }
+            in_off -= (box->len[idx] - 1) * layout->stride_a[idx];
+            out_off -= (box->len[idx] - 1) * layout->stride_b[idx];
+            pos[idx] = 0;
+        }
+    } while (idx < layout->dim);
+}
+
+
+/**
+ * @brief Function for copying bytes with non-temporal stores.
+ *
+ * @details The stores are fenced before returning, so that the data is
+ * visible to the other threads once the parallel loop ends.
+ *
+ */
+void
+ttc_engine_stream(
+        void        *target,
+        const void  *source,
+        size_t      bytes
+        ) {
+#ifdef __SSE2__
+    char *dst = (char *)target;
+    const char *src = (const char *)source;
+    size_t head = (16 - ((uintptr_t)dst & 15)) & 15;
+    head = head > bytes ? bytes : head;
+    memcpy(dst, src, head);
+    dst += head;
+    src += head;
+    bytes -= head;
+
+    for (; bytes >= 64; bytes -= 64, dst += 64, src += 64) {
+        __m128i data_0 = _mm_loadu_si128((const __m128i *)src);
+        __m128i data_1 = _mm_loadu_si128((const __m128i *)(src + 16));
+        __m128i data_2 = _mm_loadu_si128((const __m128i *)(src + 32));
+        __m128i data_3 = _mm_loadu_si128((const __m128i *)(src + 48));
+        _mm_stream_si128((__m128i *)dst, data_0);
+        _mm_stream_si128((__m128i *)(dst + 16), data_1);
+        _mm_stream_si128((__m128i *)(dst + 32), data_2);
+        _mm_stream_si128((__m128i *)(dst + 48), data_3);
+    }
+    for (; bytes >= 16; bytes -= 16, dst += 16, src += 16)
+        _mm_stream_si128((__m128i *)dst,
+                _mm_loadu_si128((const __m128i *)src));
+    memcpy(dst, src, bytes);
+    _mm_sfence();
+#else
+    memcpy(target, source, bytes);
+#endif
+}
+
+
+/**
+ * @brief Function for getting the source of an element of a dense in-place
+ * transposition.
+ *
+ * @details The position is split into the indices of the layout dimensions,
+ * the output strides are the products of the sizes of a dense tensor, so a
+ * division per dimension gives both the index and the rest.
+ *
+ * @return The position in the input whose element goes to `pos` of the
+ * output.
+ *
+ */
+uint64_t
+ttc_engine_source(
+        const ttc_engine_layout_s   *layout,
+        uint64_t                    pos
+        ) {
+    uint64_t source = 0;
+    uint32_t idx;
+    for (idx = 0; idx < layout->dim; ++idx) {
+        source += pos % layout->size[idx] * layout->stride_a[idx];
+        pos /= layout->size[idx];
+    }
+
+    return source;
+}
+
+
+/**
+ * @brief Function for checking if a dense transposition swaps two
+ * dimensions.
+ *
+ * @details Two dimensions of the layout have the same size and exchange
+ * their strides, every other dimension keeps its stride.
+ *
+ * @return Whether the dimensions are found, they are written to `pair`.
+ *
+ */
+bool
+ttc_engine_is_swap(
+        const ttc_engine_layout_s   *layout,
+        uint32_t                    pair[2]
+        ) {
+    uint32_t num = 0, idx;
+    for (idx = 0; idx < layout->dim; ++idx) {
+        if (layout->stride_a[idx] == layout->stride_b[idx])
+            continue;
+        if (2 == num)
+            return false;
+        pair[num++] = idx;
+    }
+
+    return 2 == num && layout->size[pair[0]] == layout->size[pair[1]]
+        && layout->stride_a[pair[0]] == layout->stride_b[pair[1]]
+        && layout->stride_a[pair[1]] == layout->stride_b[pair[0]];
+}
+
+
+/**
+ * @brief Function for moving the elements of a dense transposition within
+ * the memory of its input.
+ *
+ * @details The result starts a whole number of elements away from the input
+ * (or at the input). Two dimensions of the same size at the same address
+ * exchange pairs of tiles. Otherwise the chains move first, one per position
+ * of the result outside of the input, then the cycles among the remaining
+ * positions. The smallest position of a cycle leads it, so every thread
+ * finds the cycles of its starts on its own, without a serial scan. The moved
+ * positions are marked, a later start of their cycle is skipped without
+ * following it. A fixed point only moves if it is scaled.
+ *
+ * @return The status, return 0 if succeed, -1 if the bitmap cannot be
+ * allocated.
+ *
+ */
+int32_t
+ttc_engine_permute(
+        const ttc_engine_layout_s   *layout,
+        ttc_datatype_e              datatype,
+        double                      alpha,
+        double                      beta,
+        void                        *input,
+        void                        *result
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_engine_permute");
+    uint64_t num_elem = 1;
+    uint32_t idx;
+    for (idx = 0; idx < layout->dim; ++idx)
+        num_elem *= layout->size[idx];
+
+    // A swap of two dimensions of the same size exchanges pairs of tiles,
+    // which needs no memory and keeps the tiles in the L1 cache
+    const bool parallel = num_elem >= TTC_ENGINE_PAR_MIN;
+    uint32_t pair[2];
+    if (input == result && ttc_engine_is_swap(layout, pair)) {
+        const uint64_t num_tiles = (layout->size[pair[0]] + TTC_ENGINE_SWAP
+                - 1) / TTC_ENGINE_SWAP;
+        const int64_t num_items = (int64_t)(num_elem / layout->size[pair[0]]
+                / layout->size[pair[1]] * num_tiles * num_tiles);
+        int64_t item;
+        _Pragma("omp parallel for schedule(dynamic, 16) if(parallel)")
+        for (item = 0; item < num_items; ++item) {
+            switch (datatype) {
+                case TTC_TYPE_D:
+                    ttc_engine_swap_d(layout, pair, item, result, alpha, beta);
+                    break;
+                case TTC_TYPE_C:
+                    ttc_engine_swap_c(layout, pair, item, result, alpha, beta);
+                    break;
+                case TTC_TYPE_Z:
+                    ttc_engine_swap_z(layout, pair, item, result, alpha, beta);
+                    break;
+                default:
+                    ttc_engine_swap_s(layout, pair, item, result, alpha, beta);
+                    break;
+            }
+        }
+        return 0;
+    }
+
+    // The positions count the elements from the lower tensor
+    const size_t elem_size = ttc_type_size(datatype, false);
+    const char *begin_a = (const char *)input;
+    const char *begin_b = (const char *)result;
+    const uint64_t off[2] = {
+        begin_a > begin_b ? (uint64_t)(begin_a - begin_b) / elem_size : 0,
+        begin_b > begin_a ? (uint64_t)(begin_b - begin_a) / elem_size : 0 };
+    void *data = begin_a < begin_b ? input : result;
+    const uint64_t num_pos = num_elem + off[0] + off[1];
+    uint64_t *visited
+        = (uint64_t *)calloc((num_pos + 63) / 64, sizeof(uint64_t));
+    if (NULL == visited) {
+        DEBUG_ERR_OUTPUT(strerror(errno));
+        return -1;
+    }
+
+    // A chain starts at a position of the result outside of the input
+    int64_t elem;
+    if (input != result) {
+        _Pragma("omp parallel for schedule(dynamic, 4096) if(parallel)")
+        for (elem = 0; elem < (int64_t)num_elem; ++elem) {
+            const uint64_t head = off[1] + (uint64_t)elem;
+            if (head >= off[0] && head - off[0] < num_elem)
+                continue;
+
+            switch (datatype) {
+                case TTC_TYPE_D:
+                    ttc_engine_chain_d(layout, off, num_elem, head, data,
+                            alpha, beta, visited);
+                    break;
+                case TTC_TYPE_C:
+                    ttc_engine_chain_c(layout, off, num_elem, head, data,
+                            alpha, beta, visited);
+                    break;
+                case TTC_TYPE_Z:
+                    ttc_engine_chain_z(layout, off, num_elem, head, data,
+                            alpha, beta, visited);
+                    break;
+                default:
+                    ttc_engine_chain_s(layout, off, num_elem, head, data,
+                            alpha, beta, visited);
+                    break;
+            }
+        }
+    }
+
+    // A position whose sources leave the result before coming back is on a
+    // chain, whose mark may have been lost
+    const bool scaled = 1.0 != alpha || 0.0 != beta;
+    _Pragma("omp parallel for schedule(dynamic, 4096) if(parallel)")
+    for (elem = 0; elem < (int64_t)num_elem; ++elem) {
+        const uint64_t first = off[1] + (uint64_t)elem;
+        if (first < off[0] || first - off[0] >= num_elem
+            || 0 != (__atomic_load_n(visited + first / 64, __ATOMIC_RELAXED)
+                & 1ull << first % 64))
+            continue;
+        uint64_t pos = off[0] + ttc_engine_source(layout, (uint64_t)elem);
+        if (first == pos && !scaled)
+            continue;
+        while (pos > first && pos >= off[1] && pos - off[1] < num_elem)
+            pos = off[0] + ttc_engine_source(layout, pos - off[1]);
+        if (pos != first)
+            continue;
+
+        switch (datatype) {
+            case TTC_TYPE_D:
+                ttc_engine_cycle_d(layout, off, first, data, alpha, beta,
+                        visited);
+                break;
+            case TTC_TYPE_C:
+                ttc_engine_cycle_c(layout, off, first, data, alpha, beta,
+                        visited);
+                break;
+            case TTC_TYPE_Z:
+                ttc_engine_cycle_z(layout, off, first, data, alpha, beta,
+                        visited);
+                break;
+            default:
+                ttc_engine_cycle_s(layout, off, first, data, alpha, beta,
+                        visited);
+                break;
+        }
+    }
+
+    free(visited);
+
+    return 0;
+}
+
+
+/**
+ * @brief Function for executing the layout of a transposition on the micro-
+ * kernels or the generic kernels.
+ *
+ */
+void
+ttc_engine_run(
+        const ttc_param_s           *param,
+        const ttc_engine_layout_s   *layout,
+        const void                  *input,
+        void                        *result
+        ) {
+    double alpha = ttc_engine_alpha(param);
+    double beta = ttc_engine_beta(param);
+
+    ttc_micro_fn micro = ttc_engine_kernel(layout, param->datatype);
+    if (NULL != micro) {
+        ttc_engine_micro(layout, micro,
+                ttc_type_size(param->datatype, false), input, result, alpha,
+                beta);
+        return;
+    }
+
+    switch (param->datatype) {
+        case TTC_TYPE_D:
+            ttc_engine_generic_d(layout, input, result, alpha, beta);
+            break;
+        case TTC_TYPE_C:
+            ttc_engine_generic_c(layout, input, result, alpha, beta);
+            break;
+        case TTC_TYPE_Z:
+            ttc_engine_generic_z(layout, input, result, alpha, beta);
+            break;
+        case TTC_TYPE_SD:
+            ttc_engine_generic_sd(layout, input, result, alpha, beta);
+            break;
+        case TTC_TYPE_DS:
+            ttc_engine_generic_ds(layout, input, result, alpha, beta);
+            break;
+        case TTC_TYPE_CZ:
+            ttc_engine_generic_cz(layout, input, result, alpha, beta);
+            break;
+        case TTC_TYPE_ZC:
+            ttc_engine_generic_zc(layout, input, result, alpha, beta);
+            break;
+        default:
+            ttc_engine_generic_s(layout, input, result, alpha, beta);
+            break;
+    }
+}
@@ -0,0 +1,467 @@
+#include "ttc_c.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <stdio.h>          // For snprintf
+#include <string.h>
+#include <ctype.h>
+
+#include <errno.h>
+#include <unistd.h>
+
+#include "tensor_util.h"
+#include "ttc_c_util.h"
+
+
+
+/* ======== Internal function ======== */
+
+bool
+ttc_export_check_name(
+        const char  *name
+        );
+
+
+void
+ttc_export_print_array(
+        FILE            *target_file,
+        const char      *name,
+        uint32_t        idx,
+        const char      *type,
+        const void      *arr,
+        uint32_t        length
+        );
+
+
+double
+ttc_export_get_scalar(
+        const ttc_param_s   *param,
+        bool                is_alpha
+        );
+
+
+int32_t
+ttc_export_gen_table(
+        const ttc_param_s   *params,
+        uint32_t            count,
+        const char          *name
+        );
+
+
+int32_t
+ttc_export_gen_header(
+        const char  *name
+        );
+
+
+
+/* ======== Function definition ======== */
+
+int32_t
+ttc_export_static(
+        ttc_handler_s       *handler,
+        const ttc_param_s   *params,
+        uint32_t            count,
+        const char          *name
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_export_static");
+    DEBUG_INFO_OUTPUT("Exporting kernels into a static archive.");
+    // Parameter check
+    if (NULL == handler) {
+        DEBUG_ERR_OUTPUT("handler is not initialized.");
+        return -1;
+    }
+    if (NULL == params || 0 == count) {
+        DEBUG_ERR_OUTPUT("params is not initialized.");
+        return -1;
+    }
+    if (NULL == name || !ttc_export_check_name(name)) {
+        DEBUG_ERR_OUTPUT("name is not a valid C identifier or too long.");
+        return -1;
+    }
+    if (TTC_ARCH_CUDA == handler->options.arch) {
+        DEBUG_ERR_OUTPUT("CUDA kernels cannot be exported.");
+        return -1;
+    }
+
+    const ttc_opt_s *options = &handler->options;
+    const char *cmpl = ttc_cmpl_cmd(options);
+    DEBUG_SET_NAMESPACE("ttc_export_static");
+    if (NULL == cmpl) {
+        DEBUG_ERR_OUTPUT("The architecture is currently not supported.");
+        return -1;
+    }
+
+    // Start with an empty archive
+    char cmd_buf[TTC_GEN_BUF_SIZE];
+    snprintf(cmd_buf, sizeof(cmd_buf), "lib%s.a", name);
+    unlink(cmd_buf);
+
+    // Generate and compile every kernel with a unique symbol name
+    uint32_t idx;
+    for (idx = 0; idx < count; ++idx) {
+        const ttc_param_s *param = &params[idx];
+        if (NULL == param->perm || NULL == param->size) {
+            DEBUG_ERR_OUTPUT("param is not well initialized.");
+            return -1;
+        }
+
+        char seek_buf[TTC_GEN_BUF_SIZE];
+        DEBUG_INFO_OUTPUT("Running TTC.");
+        ttc_gen_lock();
+        if (0 != ttc_run_ttc(options, param, seek_buf, 0.0)) {
+            DEBUG_SET_NAMESPACE("ttc_export_static");
+            DEBUG_ERR_OUTPUT("TTC failed to generate a kernel.");
+            ttc_gen_unlock();
+            return -1;
+        }
+        DEBUG_SET_NAMESPACE("ttc_export_static");
+
+        char target_prefix[TTC_GEN_BUF_SIZE];
+        char target_suffix[TTC_GEN_BUF_SIZE];
+        int32_t ret = ttc_gen_code(options, param, seek_buf, target_prefix,
+                target_suffix);
+        DEBUG_SET_NAMESPACE("ttc_export_static");
+        if (0 != ret) {
+            DEBUG_ERR_OUTPUT("Cannot generate code.");
+            ttc_gen_unlock();
+            return -1;
+        }
+
+        char kernel_name[TTC_GEN_BUF_SIZE];
+        snprintf(kernel_name, sizeof(kernel_name), TTC_EXPORT_KERNEL_FMT,
+                name, idx);
+        int32_t length = snprintf(cmd_buf, sizeof(cmd_buf), TTC_CD_GEN_CODE
+                "%s -D " TTC_FUNC_NAME_MACRO "=%s -o %s.o %s.%s", cmpl,
+                kernel_name, kernel_name, target_prefix, target_suffix);
+        if (length < 0 || (size_t)length >= sizeof(cmd_buf)) {
+            DEBUG_ERR_OUTPUT("The compile command is too long.");
+            ttc_gen_unlock();
+            return -1;
+        }
+        DEBUG_INFO_OUTPUT(cmd_buf);
+        ret = system(cmd_buf);
+        ttc_gen_unlock();
+        if (0 != ret) {
+            DEBUG_ERR_OUTPUT("Cannot compile kernel.");
+            return -1;
+        }
+
+        length = snprintf(cmd_buf, sizeof(cmd_buf), TTC_EXPORT_AR "lib%s.a "
+                TTC_DIR_GEN_CODE "%s.o", name, kernel_name);
+        DEBUG_INFO_OUTPUT(cmd_buf);
+        if (length < 0 || (size_t)length >= sizeof(cmd_buf)
+            || 0 != system(cmd_buf)) {
+            DEBUG_ERR_OUTPUT("Cannot archive kernel.");
+            return -1;
+        }
+    }
+
+    // Generate and compile the registration table
+    DEBUG_INFO_OUTPUT("Generating registration table.");
+    if (0 != ttc_export_gen_table(params, count, name)) {
+        DEBUG_SET_NAMESPACE("ttc_export_static");
+        DEBUG_ERR_OUTPUT("Cannot generate registration table.");
+        return -1;
+    }
+    DEBUG_SET_NAMESPACE("ttc_export_static");
+
+    char table_name[TTC_GEN_BUF_SIZE];
+    snprintf(table_name, sizeof(table_name), TTC_EXPORT_TABLE_FMT, name);
+    int32_t length = snprintf(cmd_buf, sizeof(cmd_buf), "%s -o "
+            TTC_DIR_GEN_CODE "%s.o " TTC_DIR_GEN_CODE "%s.cpp", cmpl,
+            table_name, table_name);
+    if (length < 0 || (size_t)length >= sizeof(cmd_buf)) {
+        DEBUG_ERR_OUTPUT("The compile command is too long.");
+        return -1;
+    }
+    DEBUG_INFO_OUTPUT(cmd_buf);
+    if (0 != system(cmd_buf)) {
+        DEBUG_ERR_OUTPUT("Cannot compile registration table.");
+        return -1;
+    }
+
+    length = snprintf(cmd_buf, sizeof(cmd_buf), TTC_EXPORT_AR "lib%s.a "
+            TTC_DIR_GEN_CODE "%s.o", name, table_name);
+    DEBUG_INFO_OUTPUT(cmd_buf);
+    if (length < 0 || (size_t)length >= sizeof(cmd_buf)
+        || 0 != system(cmd_buf)) {
+        DEBUG_ERR_OUTPUT("Cannot archive registration table.");
+        return -1;
+    }
+
+    DEBUG_INFO_OUTPUT("Generating header.");
+    return ttc_export_gen_header(name);
+}
+
+
+int32_t
+ttc_register_kernel(
+        ttc_handler_s   *handler,
+        ttc_datatype_e  datatype,
+        uint32_t        dim,
+        const uint32_t  *perm,
+        const uint32_t  *size,
+        const uint32_t  *loop_perm,
+        const int32_t   *lda,
+        const int32_t   *ldb,
+        double          alpha,
+        double          beta,
+        int32_t         (*fn)(
+            const void      *input,
+            void            *result,
+            const void      *alpha,
+            const void      *beta,
+            const int32_t   *lda,
+            const int32_t   *ldb
+            )
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_register_kernel");
+    DEBUG_INFO_OUTPUT("Registering a static kernel.");
+    // Parameter check
+    if (NULL == handler) {
+        DEBUG_ERR_OUTPUT("handler is not initialized.");
+        return -1;
+    }
+    if (NULL == perm || NULL == size || 0 == dim) {
+        DEBUG_ERR_OUTPUT("perm or size is not initialized.");
+        return -1;
+    }
+    if (NULL == fn) {
+        DEBUG_ERR_OUTPUT("fn is not initialized.");
+        return -1;
+    }
+
+    ttc_param_s param = ttc_default_param();
+    param.datatype  = datatype;
+    param.dim       = dim;
+    param.perm      = (uint32_t *)perm;
+    param.size      = (uint32_t *)size;
+    param.loop_perm = (uint32_t *)loop_perm;
+    param.lda       = (int32_t *)lda;
+    param.ldb       = (int32_t *)ldb;
+
+    if (TTC_TYPE_DEFAULT == datatype || TTC_TYPE_S == datatype
+        || TTC_TYPE_C == datatype || TTC_TYPE_SD == datatype
+        || TTC_TYPE_CZ == datatype)
+        param.alpha.s = alpha;
+    else
+        param.alpha.d = alpha;
+
+    if (TTC_TYPE_DEFAULT == datatype || TTC_TYPE_S == datatype
+        || TTC_TYPE_C == datatype || TTC_TYPE_DS == datatype
+        || TTC_TYPE_ZC == datatype)
+        param.beta.s = beta;
+    else
+        param.beta.d = beta;
+
+    // Keep the existing plan
+    if (NULL != ttc_lookup_plan(handler, &param)) {
+        DEBUG_SET_NAMESPACE("ttc_register_kernel");
+        DEBUG_WARN_OUTPUT("A plan with the same signature exists.");
+        return 0;
+    }
+
+    ttc_plan_s *new_plan = ttc_alloc_plan(&param);
+    DEBUG_SET_NAMESPACE("ttc_register_kernel");
+    if (NULL == new_plan) {
+        DEBUG_ERR_OUTPUT("Cannot allocate plan.");
+        return -1;
+    }
+    new_plan->fn = fn;
+
+    ttc_attach_plan(handler, new_plan);
+
+    return 0;
+}
+
+
+bool
+ttc_export_check_name(
+        const char  *name
+        ) {
+    // The length bounds the names and commands built from it
+    if ('\0' == *name || isdigit((unsigned char)*name)
+        || strlen(name) > TTC_EXPORT_NAME_MAX)
+        return false;
+
+    for (; '\0' != *name; ++name)
+        if (!isalnum((unsigned char)*name) && '_' != *name)
+            return false;
+
+    return true;
+}
+
+
+void
+ttc_export_print_array(
+        FILE            *target_file,
+        const char      *name,
+        uint32_t        idx,
+        const char      *type,
+        const void      *arr,
+        uint32_t        length
+        ) {
+    fprintf(target_file, "    static const %s %s_%u[] = { ", type, name, idx);
+
+    uint32_t arr_idx;
+    for (arr_idx = 0; arr_idx < length; ++arr_idx) {
+        if (0 == strcmp("int32_t", type))
+            fprintf(target_file, "%d", ((const int32_t *)arr)[arr_idx]);
+        else
+            fprintf(target_file, "%u", ((const uint32_t *)arr)[arr_idx]);
+        fprintf(target_file, arr_idx + 1 == length ? " };\n" : ", ");
+    }
+}
+
+
+double
+ttc_export_get_scalar(
+        const ttc_param_s   *param,
+        bool                is_alpha
+        ) {
+    ttc_datatype_e type = param->datatype;
+    if (is_alpha) {
+        if (TTC_TYPE_DEFAULT == type || TTC_TYPE_S == type
+            || TTC_TYPE_C == type || TTC_TYPE_SD == type
+            || TTC_TYPE_CZ == type)
+            return param->alpha.s;
+        return param->alpha.d;
+    }
+
+    if (TTC_TYPE_DEFAULT == type || TTC_TYPE_S == type
+        || TTC_TYPE_C == type || TTC_TYPE_DS == type
+        || TTC_TYPE_ZC == type)
+        return param->beta.s;
+    return param->beta.d;
+}
+
+
+int32_t
+ttc_export_gen_table(
+        const ttc_param_s   *params,
+        uint32_t            count,
+        const char          *name
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_export_gen_table");
+    DEBUG_INFO_OUTPUT("Generating registration table (.cpp file).");
+
+    char gen_buf[TTC_GEN_BUF_SIZE];
+    snprintf(gen_buf, sizeof(gen_buf), TTC_DIR_GEN_CODE TTC_EXPORT_TABLE_FMT
+            ".cpp", name);
+    FILE *target_file = fopen(gen_buf, "w");
+    if (NULL == target_file) {
+        DEBUG_ERR_OUTPUT("Cannot create .cpp file.");
+        return -1;
+    }
+
+    // The table only uses the flattened registration function, so that it
+    // does not need the TTC C API header while being compiled.
+    fprintf(target_file, "#include <stdint.h>\n\n"
+            "typedef int (*ttc_kernel_fn)(const void *, void *,\n"
+            "        const void *, const void *,\n"
+            "        const int *, const int *);\n\n"
+            "extern \"C\" {\n"
+            "    struct ttc_handler;\n"
+            "    int32_t ttc_register_kernel(struct ttc_handler *, int,\n"
+            "        uint32_t, const uint32_t *, const uint32_t *,\n"
+            "        const uint32_t *, const int32_t *, const int32_t *,\n"
+            "        double, double, ttc_kernel_fn);\n\n");
+
+    uint32_t idx;
+    char kernel_name[TTC_GEN_BUF_SIZE];
+    for (idx = 0; idx < count; ++idx) {
+        snprintf(kernel_name, sizeof(kernel_name), TTC_EXPORT_KERNEL_FMT,
+                name, idx);
+        fprintf(target_file, "    int %s(const void *, void *,\n"
+                "        const void *, const void *,\n"
+                "        const int *, const int *);\n", kernel_name);
+    }
+
+    fprintf(target_file, "\n    int32_t " TTC_EXPORT_REG_FMT
+            "(struct ttc_handler *);\n}\n\n", name);
+
+    // Registration function
+    fprintf(target_file, "int32_t " TTC_EXPORT_REG_FMT
+            "(struct ttc_handler *handler) {\n"
+            "    int32_t ret;\n", name);
+    for (idx = 0; idx < count; ++idx) {
+        const ttc_param_s *param = &params[idx];
+        uint32_t dim = param->dim;
+
+        fprintf(target_file, "\n");
+        ttc_export_print_array(target_file, "perm", idx, "uint32_t",
+                param->perm, dim);
+        ttc_export_print_array(target_file, "size", idx, "uint32_t",
+                param->size, dim);
+        if (NULL != param->loop_perm)
+            ttc_export_print_array(target_file, "loop_perm", idx, "uint32_t",
+                    param->loop_perm, dim);
+        if (NULL != param->lda)
+            ttc_export_print_array(target_file, "lda", idx, "int32_t",
+                    param->lda, dim);
+        if (NULL != param->ldb)
+            ttc_export_print_array(target_file, "ldb", idx, "int32_t",
+                    param->ldb, dim);
+
+        snprintf(kernel_name, sizeof(kernel_name), TTC_EXPORT_KERNEL_FMT,
+                name, idx);
+        fprintf(target_file, "    ret = ttc_register_kernel(handler, %d, %u,\n"
+                "        perm_%u, size_%u,\n", param->datatype, dim, idx, idx);
+        if (NULL != param->loop_perm)
+            fprintf(target_file, "        loop_perm_%u,", idx);
+        else
+            fprintf(target_file, "        0,");
+        if (NULL != param->lda)
+            fprintf(target_file, " lda_%u,", idx);
+        else
+            fprintf(target_file, " 0,");
+        if (NULL != param->ldb)
+            fprintf(target_file, " ldb_%u,\n", idx);
+        else
+            fprintf(target_file, " 0,\n");
+        fprintf(target_file, "        %.17g, %.17g, %s);\n"
+                "    if (0 != ret)\n"
+                "        return ret;\n",
+                ttc_export_get_scalar(param, true),
+                ttc_export_get_scalar(param, false), kernel_name);
+    }
+    fprintf(target_file, "\n    return 0;\n}\n");
+
+    fclose(target_file);
+
+    return 0;
+}
+
+
+int32_t
+ttc_export_gen_header(
+        const char  *name
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_export_gen_header");
+    DEBUG_INFO_OUTPUT("Generating registration header (.h file).");
+
+    char gen_buf[TTC_GEN_BUF_SIZE];
+    snprintf(gen_buf, sizeof(gen_buf), "%s.h", name);
+    FILE *target_file = fopen(gen_buf, "w");
+    if (NULL == target_file) {
+        DEBUG_ERR_OUTPUT("Cannot create .h file.");
+        return -1;
+    }
+
+    fprintf(target_file, "#pragma once\n\n"
+            "#include <stdint.h>\n\n"
+            "#include <ttc_c.h>\n\n"
+            "#ifdef __cplusplus\n"
+            "extern \"C\" {\n"
+            "#endif\n\n"
+            "int32_t " TTC_EXPORT_REG_FMT "(ttc_handler_s *handler);\n\n"
+            "#ifdef __cplusplus\n"
+            "}\n"
+            "#endif\n", name);
+
+    fclose(target_file);
+
+    return 0;
+}
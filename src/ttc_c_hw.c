@@ -0,0 +1,950 @@
+#define _GNU_SOURCE         // For sched_setaffinity and CPU_SET
+
+#include "ttc_c_hw.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+#include <errno.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "tensor_util.h"
+#include "ttc_c.h"
+#include "ttc_c_util.h"
+
+
+
+/* ======== Internal struct ======== */
+
+/**
+ * @brief Struct for a thread of the STREAM-like kernels.
+ *
+ * @details Every thread works on its own part of the arrays. The threads wait
+ * on `start` until all of them are created, and synchronize every run on
+ * `barrier`. The first thread measures the time.
+ *
+ */
+typedef struct ttc_hw_stream {
+    pthread_mutex_t     *start;
+    pthread_barrier_t   *barrier;
+    const bool          *abort;
+    double              *src;
+    double              *dst;
+    size_t              len;
+    int32_t             cpu;
+    bool                leader;
+    double              *time;
+    double              sink;
+} ttc_hw_stream_s;
+
+
+
+/* ======== Internal function ======== */
+
+int32_t
+ttc_hw_cpu_model(
+        char        *model,
+        uint32_t    length
+        );
+
+
+uint64_t
+ttc_hw_read_size(
+        const char  *path
+        );
+
+
+int32_t
+ttc_hw_cache_level(
+        uint32_t    cpu,
+        uint32_t    idx
+        );
+
+
+int32_t
+ttc_hw_llc_index(
+        uint32_t    cpu,
+        uint64_t    *size
+        );
+
+
+uint32_t
+ttc_hw_node_cpus(
+        uint32_t    node,
+        int32_t     *cpus,
+        uint32_t    max_cpus
+        );
+
+
+int32_t
+ttc_hw_stream(
+        uint32_t        num_threads,
+        const int32_t   *cpus,
+        size_t          size,
+        double          bandwidth[3]
+        );
+
+
+void *
+ttc_hw_stream_run(
+        void    *arg
+        );
+
+
+
+/* ======== Function definition ======== */
+
+int32_t
+ttc_calibrate(
+        ttc_handler_s   *handler
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_calibrate");
+    DEBUG_INFO_OUTPUT("Calibrating the machine.");
+    // Parameter check
+    if (NULL == handler) {
+        DEBUG_ERR_OUTPUT("handler is not initialized.");
+        return -1;
+    }
+
+    int32_t ret = ttc_hw_calibrate(&handler->hw);
+    DEBUG_SET_NAMESPACE("ttc_calibrate");
+    if (0 != ret) {
+        DEBUG_ERR_OUTPUT("Cannot measure the bandwidth.");
+        return ret;
+    }
+
+    if (0 != ttc_hw_save(&handler->hw)) {
+        DEBUG_SET_NAMESPACE("ttc_calibrate");
+        DEBUG_WARN_OUTPUT("Cannot save the calibration file.");
+    }
+
+    return 0;
+}
+
+
+int32_t
+ttc_hw_detect(
+        ttc_hw_s    *hw
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_hw_detect");
+    DEBUG_INFO_OUTPUT("Detecting hardware properties.");
+    // Parameter check
+    if (NULL == hw) {
+        DEBUG_ERR_OUTPUT("hw is not initialized.");
+        return -1;
+    }
+
+    hw->l1_size = 0;
+    hw->l2_size = 0;
+    hw->llc_size = TTC_HW_LLC_DEFAULT;
+    hw->bandwidth = 0.0;
+    hw->num_points = 0;
+    hw->threads = NULL;
+    hw->read_bw = NULL;
+    hw->write_bw = NULL;
+    hw->copy_bw = NULL;
+    hw->node_bw = NULL;
+
+    long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+    hw->num_cores = num_cores > 0 ? (uint32_t)num_cores : 1;
+
+    hw->num_nodes = 0;
+    for (; hw->num_nodes < TTC_HW_MAX_NODES; ++hw->num_nodes) {
+        char path[TTC_GEN_BUF_SIZE];
+        sprintf(path, TTC_HW_NODE_DIR, hw->num_nodes);
+        if (0 != access(path, F_OK))
+            break;
+    }
+    if (0 == hw->num_nodes)
+        hw->num_nodes = 1;
+
+    // The level 1 and 2 data caches of the first CPU
+    uint32_t idx;
+    for (idx = 0; idx < TTC_HW_CACHE_MAX_INDEX; ++idx) {
+        int32_t level = ttc_hw_cache_level(0, idx);
+        if (level < 0)
+            break;
+        if (1 != level && 2 != level)
+            continue;
+
+        char path[TTC_GEN_BUF_SIZE];
+        snprintf(path, TTC_GEN_BUF_SIZE, TTC_HW_CPU_CACHE_DIR "size", 0,
+                idx);
+        uint64_t size = ttc_hw_read_size(path);
+        if (1 == level && 0 != size)
+            hw->l1_size = size;
+        else if (0 != size)
+            hw->l2_size = size;
+    }
+    uint64_t llc_size = 0;
+    int32_t llc_idx = ttc_hw_llc_index(0, &llc_size);
+    if (llc_idx >= 0)
+        hw->llc_size = llc_size;
+
+    // The measurements of a previous calibration
+    int32_t loaded = ttc_hw_load(hw);
+    DEBUG_SET_NAMESPACE("ttc_hw_detect");
+    if (0 == loaded)
+        DEBUG_INFO_OUTPUT("Loaded the calibration file.");
+
+    if (llc_idx < 0) {
+        DEBUG_WARN_OUTPUT("Cannot detect cache sizes, using default values.");
+        return -1;
+    }
+
+    return 0;
+}
+
+
+void
+ttc_hw_release(
+        ttc_hw_s    *hw
+        ) {
+    if (NULL == hw)
+        return;
+
+    free(hw->threads);
+    free(hw->read_bw);
+    free(hw->write_bw);
+    free(hw->copy_bw);
+    free(hw->node_bw);
+    hw->threads = NULL;
+    hw->read_bw = NULL;
+    hw->write_bw = NULL;
+    hw->copy_bw = NULL;
+    hw->node_bw = NULL;
+    hw->num_points = 0;
+}
+
+
+int32_t
+ttc_hw_calibrate(
+        ttc_hw_s    *hw
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_hw_calibrate");
+    // Parameter check
+    if (NULL == hw) {
+        DEBUG_ERR_OUTPUT("hw is not initialized.");
+        return -1;
+    }
+
+    // Points: 1, 2, 4, ... and all the cores
+    uint32_t num_points = 1;
+    uint32_t threads;
+    for (threads = 1; threads < hw->num_cores; threads *= 2)
+        ++num_points;
+
+    ttc_hw_release(hw);
+    hw->threads = (uint32_t *)malloc(sizeof(uint32_t) * num_points);
+    hw->read_bw = (double *)malloc(sizeof(double) * num_points);
+    hw->write_bw = (double *)malloc(sizeof(double) * num_points);
+    hw->copy_bw = (double *)malloc(sizeof(double) * num_points);
+    hw->node_bw = (double *)malloc(sizeof(double) * hw->num_nodes);
+    int32_t *cpus = (int32_t *)malloc(sizeof(int32_t) * hw->num_cores);
+    if (NULL == hw->threads || NULL == hw->read_bw || NULL == hw->write_bw
+        || NULL == hw->copy_bw || NULL == hw->node_bw || NULL == cpus) {
+        int32_t err = errno;
+        DEBUG_ERR_OUTPUT(strerror(err));
+        ttc_hw_release(hw);
+        free(cpus);
+        return err;
+    }
+
+    // Larger than the last level cache, so that the memory is measured
+    size_t size = 4 * hw->llc_size;
+    if (size < TTC_HW_BW_MIN_SIZE)
+        size = TTC_HW_BW_MIN_SIZE;
+    if (size > TTC_HW_BW_MAX_SIZE)
+        size = TTC_HW_BW_MAX_SIZE;
+
+    // The cores the process may run on, threads are pinned in this order
+    cpu_set_t allowed;
+    uint32_t num_allowed = 0;
+    CPU_ZERO(&allowed);
+    if (0 == sched_getaffinity(0, sizeof(allowed), &allowed)) {
+        int32_t cpu;
+        for (cpu = 0; cpu < CPU_SETSIZE && num_allowed < hw->num_cores;
+                ++cpu)
+            if (CPU_ISSET(cpu, &allowed))
+                cpus[num_allowed++] = cpu;
+    }
+
+    uint32_t point = 0;
+    for (threads = 1; point < num_points; threads *= 2, ++point) {
+        if (threads > hw->num_cores)
+            threads = hw->num_cores;
+        DEBUG_INFO_OUTPUT("Measuring a number of threads.");
+        double bandwidth[3];
+        int32_t ret = ttc_hw_stream(threads,
+                threads <= num_allowed ? cpus : NULL, size, bandwidth);
+        DEBUG_SET_NAMESPACE("ttc_hw_calibrate");
+        if (0 != ret) {
+            DEBUG_ERR_OUTPUT("Cannot run the kernels.");
+            ttc_hw_release(hw);
+            free(cpus);
+            return ret;
+        }
+        hw->threads[point] = threads;
+        hw->read_bw[point] = bandwidth[0];
+        hw->write_bw[point] = bandwidth[1];
+        hw->copy_bw[point] = bandwidth[2];
+    }
+    hw->num_points = num_points;
+    hw->bandwidth = hw->copy_bw[0];
+
+    // Every NUMA node with its own cores
+    uint32_t node;
+    for (node = 0; node < hw->num_nodes; ++node) {
+        hw->node_bw[node] = hw->copy_bw[num_points - 1];
+        uint32_t node_cpus = ttc_hw_node_cpus(node, cpus, hw->num_cores);
+        if (0 == node_cpus || hw->num_nodes < 2)
+            continue;
+        DEBUG_INFO_OUTPUT("Measuring a NUMA node.");
+        double bandwidth[3];
+        if (0 == ttc_hw_stream(node_cpus, cpus, size, bandwidth))
+            hw->node_bw[node] = bandwidth[2];
+        DEBUG_SET_NAMESPACE("ttc_hw_calibrate");
+    }
+    free(cpus);
+
+    return 0;
+}
+
+
+int32_t
+ttc_hw_load(
+        ttc_hw_s    *hw
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_hw_load");
+    // Parameter check
+    if (NULL == hw)
+        return -1;
+
+    char model[TTC_GEN_BUF_SIZE];
+    char path[TTC_GEN_BUF_SIZE * 2];
+    ttc_hw_cpu_model(model, TTC_GEN_BUF_SIZE);
+    sprintf(path, TTC_HW_CALIB_FMT, model);
+    FILE *calib_file = fopen(path, "r");
+    if (NULL == calib_file)
+        return -1;
+
+    // Count the points before allocating
+    char line[TTC_GEN_BUF_SIZE];
+    uint32_t num_points = 0;
+    while (NULL != fgets(line, TTC_GEN_BUF_SIZE, calib_file))
+        if (0 == strncmp(line, "threads,", 8))
+            ++num_points;
+    if (0 == num_points) {
+        fclose(calib_file);
+        return -1;
+    }
+
+    ttc_hw_release(hw);
+    hw->threads = (uint32_t *)malloc(sizeof(uint32_t) * num_points);
+    hw->read_bw = (double *)malloc(sizeof(double) * num_points);
+    hw->write_bw = (double *)malloc(sizeof(double) * num_points);
+    hw->copy_bw = (double *)malloc(sizeof(double) * num_points);
+    // A node without a line in the file keeps 0 until it is filled below
+    hw->node_bw = (double *)calloc(hw->num_nodes, sizeof(double));
+    if (NULL == hw->threads || NULL == hw->read_bw || NULL == hw->write_bw
+        || NULL == hw->copy_bw || NULL == hw->node_bw) {
+        int32_t err = errno;
+        DEBUG_ERR_OUTPUT(strerror(err));
+        ttc_hw_release(hw);
+        fclose(calib_file);
+        return err;
+    }
+
+    rewind(calib_file);
+    uint32_t point = 0;
+    while (NULL != fgets(line, TTC_GEN_BUF_SIZE, calib_file)) {
+        uint64_t l1, l2, llc;
+        uint32_t num;
+        double read, write, copy;
+        if (point < num_points && 4 == sscanf(line, "threads,%u,%lf,%lf,%lf",
+                    &num, &read, &write, &copy)) {
+            hw->threads[point] = num;
+            hw->read_bw[point] = read;
+            hw->write_bw[point] = write;
+            hw->copy_bw[point] = copy;
+            ++point;
+        }
+        else if (2 == sscanf(line, "node,%u,%lf", &num, &copy)
+                && num < hw->num_nodes)
+            hw->node_bw[num] = copy;
+        else if (3 == sscanf(line, "cache,%" SCNu64 ",%" SCNu64 ",%" SCNu64,
+                    &l1, &l2, &llc)) {
+            hw->l1_size = l1;
+            hw->l2_size = l2;
+            hw->llc_size = llc;
+        }
+    }
+    fclose(calib_file);
+
+    hw->num_points = point;
+    uint32_t node;
+    for (node = 0; node < hw->num_nodes; ++node)
+        if (0 == hw->node_bw[node] && 0 != point)
+            hw->node_bw[node] = hw->copy_bw[point - 1];
+    if (0 == point) {
+        ttc_hw_release(hw);
+        return -1;
+    }
+    hw->bandwidth = hw->copy_bw[0];
+
+    return 0;
+}
+
+
+int32_t
+ttc_hw_save(
+        const ttc_hw_s  *hw
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_hw_save");
+    // Parameter check
+    if (NULL == hw || 0 == hw->num_points)
+        return -1;
+
+    char model[TTC_GEN_BUF_SIZE];
+    char path[TTC_GEN_BUF_SIZE * 2];
+    ttc_hw_cpu_model(model, TTC_GEN_BUF_SIZE);
+    sprintf(path, TTC_HW_CALIB_FMT, model);
+    FILE *calib_file = fopen(path, "w");
+    if (NULL == calib_file) {
+        DEBUG_ERR_OUTPUT("Cannot open the calibration file.");
+        return -1;
+    }
+
+    fprintf(calib_file, TTC_HW_CALIB_HEADER);
+    fprintf(calib_file, "cache,%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n",
+            hw->l1_size, hw->l2_size, hw->llc_size);
+    uint32_t idx;
+    for (idx = 0; idx < hw->num_points; ++idx)
+        fprintf(calib_file, "threads,%u,%g,%g,%g\n", hw->threads[idx],
+                hw->read_bw[idx], hw->write_bw[idx], hw->copy_bw[idx]);
+    for (idx = 0; NULL != hw->node_bw && idx < hw->num_nodes; ++idx)
+        fprintf(calib_file, "node,%u,%g\n", idx, hw->node_bw[idx]);
+    fclose(calib_file);
+
+    return 0;
+}
+
+
+double
+ttc_hw_copy_bandwidth(
+        const ttc_hw_s  *hw,
+        uint32_t        threads
+        ) {
+    if (NULL == hw)
+        return TTC_HW_BW_DEFAULT;
+    if (0 == hw->num_points)
+        return hw->bandwidth > 0 ? hw->bandwidth : TTC_HW_BW_DEFAULT;
+
+    uint32_t point = 0;
+    uint32_t idx;
+    for (idx = 1; idx < hw->num_points; ++idx)
+        if (0 == threads || hw->threads[idx] <= threads)
+            point = idx;
+
+    return hw->copy_bw[point];
+}
+
+
+uint32_t
+ttc_hw_threads(
+        const ttc_hw_s  *hw
+        ) {
+    if (NULL == hw)
+        return 1;
+    if (0 == hw->num_points)
+        return hw->num_cores > 1 ? hw->num_cores / 2 : 1;
+
+    double best = 0.0;
+    uint32_t idx;
+    for (idx = 0; idx < hw->num_points; ++idx)
+        if (hw->copy_bw[idx] > best)
+            best = hw->copy_bw[idx];
+    for (idx = 0; idx < hw->num_points; ++idx)
+        if (hw->copy_bw[idx] >= TTC_HW_SATURATION * best)
+            break;
+
+    return hw->threads[idx < hw->num_points ? idx : hw->num_points - 1];
+}
+
+
+double
+ttc_hw_bandwidth(
+        ttc_hw_s    *hw
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_hw_bandwidth");
+    // Parameter check
+    if (NULL == hw)
+        return TTC_HW_BW_DEFAULT;
+    if (hw->bandwidth > 0)
+        return hw->bandwidth;
+
+    DEBUG_INFO_OUTPUT("Measuring memory bandwidth.");
+    size_t size = 2 * hw->llc_size;
+    if (size < TTC_HW_BW_MIN_SIZE)
+        size = TTC_HW_BW_MIN_SIZE;
+    if (size > TTC_HW_BW_MAX_SIZE)
+        size = TTC_HW_BW_MAX_SIZE;
+
+    char *src = (char *)malloc(size);
+    char *dst = (char *)malloc(size);
+    if (NULL == src || NULL == dst) {
+        DEBUG_WARN_OUTPUT("Cannot allocate buffers, using default value.");
+        free(src);
+        free(dst);
+        hw->bandwidth = TTC_HW_BW_DEFAULT;
+        return hw->bandwidth;
+    }
+
+    // Touch the pages before timing
+    memset(src, 1, size);
+    memset(dst, 0, size);
+    double best = 0.0;
+    uint32_t idx;
+    for (idx = 0; idx < TTC_HW_BW_REPEAT; ++idx) {
+        double start = get_wtime();
+        memcpy(dst, src, size);
+        double time = get_wtime() - start;
+        if (time > 0 && (0 == best || time < best))
+            best = time;
+    }
+    free(src);
+    free(dst);
+
+    hw->bandwidth = best > 0 ? 2.0 * size / best / 1e9 : TTC_HW_BW_DEFAULT;
+
+    return hw->bandwidth;
+}
+
+
+ttc_residency_e
+ttc_hw_residency(
+        const ttc_hw_s      *hw,
+        const ttc_param_s   *param
+        ) {
+    if (NULL == hw || NULL == param || TTC_RES_AUTO != param->residency)
+        return NULL == param ? TTC_RES_NONE : param->residency;
+
+    // Footprint of the input and output tensors
+    double footprint = ttc_type_size(param->datatype, false)
+        + ttc_type_size(param->datatype, true);
+    uint32_t idx;
+    for (idx = 0; idx < param->dim; ++idx)
+        footprint *= param->size[idx];
+
+    return footprint <= (double)hw->llc_size ? TTC_RES_HOT : TTC_RES_COLD;
+}
+
+
+ttc_store_e
+ttc_hw_store(
+        const ttc_hw_s      *hw,
+        const ttc_param_s   *param
+        ) {
+    if (NULL == hw || NULL == param || TTC_STORE_AUTO != param->store)
+        return NULL == param ? TTC_STORE_AUTO : param->store;
+
+    // Footprint of the output tensor, the last dimension is not padded
+    double footprint = ttc_type_size(param->datatype, true);
+    uint32_t idx;
+    for (idx = 0; idx < param->dim; ++idx)
+        footprint *= NULL != param->ldb && idx + 1 < param->dim
+            ? param->ldb[idx] : param->size[param->perm[idx]];
+
+    return footprint > (double)hw->llc_size ? TTC_STORE_STREAM
+        : TTC_STORE_CACHED;
+}
+
+
+int32_t
+ttc_hw_domain(
+        uint32_t    cpu
+        ) {
+    // Read once per CPU, the entries hold the domain plus 2 so that 0 is
+    // unknown and 1 is a CPU without a shared cache
+    static int32_t cached[TTC_HW_MAX_CPUS];
+    if (cpu >= TTC_HW_MAX_CPUS)
+        return -1;
+    int32_t known = __atomic_load_n(&cached[cpu], __ATOMIC_RELAXED);
+    if (0 != known)
+        return known - 2;
+
+    // The first CPU sharing the last level cache names the domain, the
+    // list is sorted, e.g. `0-7,64-71`
+    int32_t domain = -1;
+    int32_t idx = ttc_hw_llc_index(cpu, NULL);
+    if (idx >= 0) {
+        char path[TTC_GEN_BUF_SIZE];
+        uint32_t first = 0;
+        snprintf(path, TTC_GEN_BUF_SIZE,
+                TTC_HW_CPU_CACHE_DIR "shared_cpu_list", cpu, (uint32_t)idx);
+        FILE *cache_file = fopen(path, "r");
+        if (NULL != cache_file) {
+            if (1 == fscanf(cache_file, "%u", &first))
+                domain = (int32_t)first;
+            fclose(cache_file);
+        }
+    }
+
+    __atomic_store_n(&cached[cpu], domain + 2, __ATOMIC_RELAXED);
+
+    return domain;
+}
+
+
+
+/* ======== Internal function definition ======== */
+
+/**
+ * @brief Function for getting the CPU model as a file name.
+ *
+ * @details The model name in `/proc/cpuinfo` followed by the number of cores,
+ * every character other than letters and digits is replaced by `_`.
+ *
+ */
+int32_t
+ttc_hw_cpu_model(
+        char        *model,
+        uint32_t    length
+        ) {
+    char line[TTC_GEN_BUF_SIZE];
+    char name[TTC_GEN_BUF_SIZE] = "unknown";
+    FILE *cpuinfo = fopen(TTC_HW_CPUINFO, "r");
+    if (NULL != cpuinfo) {
+        while (NULL != fgets(line, TTC_GEN_BUF_SIZE, cpuinfo)) {
+            char *value = strchr(line, ':');
+            if (0 != strncmp(line, TTC_HW_CPU_MODEL, strlen(TTC_HW_CPU_MODEL))
+                || NULL == value)
+                continue;
+            for (++value; isspace((unsigned char)*value); ++value);
+            strncpy(name, value, TTC_GEN_BUF_SIZE - 1);
+            name[TTC_GEN_BUF_SIZE - 1] = '\0';
+            name[strcspn(name, "\n")] = '\0';
+            break;
+        }
+        fclose(cpuinfo);
+    }
+
+    long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+    snprintf(model, length, "%s_%ldc", name, num_cores);
+    char *ptr = model;
+    for (; '\0' != *ptr; ++ptr)
+        if (!isalnum((unsigned char)*ptr))
+            *ptr = '_';
+
+    return 0;
+}
+
+
+/**
+ * @brief Function for reading a cache size like `32K` from sysfs.
+ *
+ * @return The size in bytes, 0 if it cannot be read.
+ *
+ */
+uint64_t
+ttc_hw_read_size(
+        const char  *path
+        ) {
+    FILE *size_file = fopen(path, "r");
+    if (NULL == size_file)
+        return 0;
+
+    uint64_t size = 0;
+    char unit = '\0';
+    int32_t ret = fscanf(size_file, "%" SCNu64 "%c", &size, &unit);
+    fclose(size_file);
+    if (ret < 1)
+        return 0;
+
+    if ('K' == unit)
+        size *= 1024;
+    else if ('M' == unit)
+        size *= 1024 * 1024;
+    else if ('G' == unit)
+        size *= 1024 * 1024 * 1024;
+
+    return size;
+}
+
+
+/**
+ * @brief Function for reading the level of a cache of a CPU from sysfs.
+ *
+ * @return The level, 0 if the index is an instruction cache or cannot be
+ * read, or -1 if the CPU has no cache of the index.
+ *
+ */
+int32_t
+ttc_hw_cache_level(
+        uint32_t    cpu,
+        uint32_t    idx
+        ) {
+    char path[TTC_GEN_BUF_SIZE];
+    uint32_t level = 0;
+    char type = '\0';
+
+    snprintf(path, TTC_GEN_BUF_SIZE, TTC_HW_CPU_CACHE_DIR "level", cpu, idx);
+    FILE *cache_file = fopen(path, "r");
+    if (NULL == cache_file)
+        return -1;
+    int32_t ret = fscanf(cache_file, "%u", &level);
+    fclose(cache_file);
+    if (1 != ret)
+        return 0;
+
+    snprintf(path, TTC_GEN_BUF_SIZE, TTC_HW_CPU_CACHE_DIR "type", cpu, idx);
+    cache_file = fopen(path, "r");
+    if (NULL != cache_file) {
+        ret = fscanf(cache_file, "%c", &type);
+        fclose(cache_file);
+    }
+
+    // Skip instruction caches
+    return 'I' == type ? 0 : (int32_t)level;
+}
+
+
+/**
+ * @brief Function for finding the last level data cache of a CPU.
+ *
+ * @details The data or unified cache with the highest level is the last
+ * level cache, the largest one if several share the level.
+ *
+ * @return The index of the cache in sysfs, or -1 if there is none. Its size
+ * is written to `size` if it is not a null pointer.
+ *
+ */
+int32_t
+ttc_hw_llc_index(
+        uint32_t    cpu,
+        uint64_t    *size
+        ) {
+    int32_t llc_idx = -1, llc_level = 0;
+    uint64_t llc_size = 0;
+    uint32_t idx;
+    for (idx = 0; idx < TTC_HW_CACHE_MAX_INDEX; ++idx) {
+        int32_t level = ttc_hw_cache_level(cpu, idx);
+        if (level < 0)
+            break;
+        if (0 == level || level < llc_level)
+            continue;
+
+        char path[TTC_GEN_BUF_SIZE];
+        snprintf(path, TTC_GEN_BUF_SIZE, TTC_HW_CPU_CACHE_DIR "size", cpu,
+                idx);
+        uint64_t cache_size = ttc_hw_read_size(path);
+        if (0 == cache_size
+            || (level == llc_level && cache_size < llc_size))
+            continue;
+
+        llc_idx = (int32_t)idx;
+        llc_level = level;
+        llc_size = cache_size;
+    }
+
+    if (NULL != size)
+        *size = llc_size;
+
+    return llc_idx;
+}
+
+
+/**
+ * @brief Function for reading the cores of a NUMA node from its `cpulist`,
+ * e.g. `0-7,16-23`.
+ *
+ * @return The number of cores written to `cpus`.
+ *
+ */
+uint32_t
+ttc_hw_node_cpus(
+        uint32_t    node,
+        int32_t     *cpus,
+        uint32_t    max_cpus
+        ) {
+    char path[TTC_GEN_BUF_SIZE];
+    char list[TTC_GEN_BUF_SIZE];
+    sprintf(path, TTC_HW_NODE_DIR "cpulist", node);
+    FILE *list_file = fopen(path, "r");
+    if (NULL == list_file)
+        return 0;
+    char *ret = fgets(list, TTC_GEN_BUF_SIZE, list_file);
+    fclose(list_file);
+    if (NULL == ret)
+        return 0;
+
+    uint32_t num_cpus = 0;
+    char *parse_ptr = list;
+    while (num_cpus < max_cpus && isdigit((unsigned char)*parse_ptr)) {
+        char *end_ptr;
+        long first = strtol(parse_ptr, &end_ptr, 10);
+        long last = first;
+        if ('-' == *end_ptr)
+            last = strtol(end_ptr + 1, &end_ptr, 10);
+        for (; first <= last && num_cpus < max_cpus; ++first)
+            cpus[num_cpus++] = (int32_t)first;
+        parse_ptr = ',' == *end_ptr ? end_ptr + 1 : end_ptr;
+    }
+
+    return num_cpus;
+}
+
+
+/**
+ * @brief Function for running the read, write and copy kernels.
+ *
+ * @param[in]   num_threads The number of threads.
+ * @param[in]   cpus        The cores of the threads, or NULL for no pinning.
+ * @param[in]   size        The size of each array in bytes.
+ * @param[out]  bandwidth   The read, write and copy bandwidth in GB/s.
+ *
+ */
+int32_t
+ttc_hw_stream(
+        uint32_t        num_threads,
+        const int32_t   *cpus,
+        size_t          size,
+        double          bandwidth[3]
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_hw_stream");
+    size_t len = size / sizeof(double) / num_threads;
+    double *src = (double *)malloc(sizeof(double) * len * num_threads);
+    double *dst = (double *)malloc(sizeof(double) * len * num_threads);
+    ttc_hw_stream_s *streams
+        = (ttc_hw_stream_s *)malloc(sizeof(ttc_hw_stream_s) * num_threads);
+    pthread_t *thread_ids
+        = (pthread_t *)malloc(sizeof(pthread_t) * num_threads);
+    if (NULL == src || NULL == dst || NULL == streams || NULL == thread_ids) {
+        int32_t err = errno;
+        DEBUG_ERR_OUTPUT(strerror(err));
+        free(src);
+        free(dst);
+        free(streams);
+        free(thread_ids);
+        return err;
+    }
+
+    pthread_mutex_t start = PTHREAD_MUTEX_INITIALIZER;
+    pthread_barrier_t barrier;
+    bool abort = false;
+    double time[3] = { 0.0, 0.0, 0.0 };
+
+    // The threads wait for the start lock until all of them are created
+    pthread_mutex_lock(&start);
+    uint32_t created;
+    for (created = 0; created < num_threads; ++created) {
+        ttc_hw_stream_s *stream = streams + created;
+        stream->start = &start;
+        stream->barrier = &barrier;
+        stream->abort = &abort;
+        stream->src = src + len * created;
+        stream->dst = dst + len * created;
+        stream->len = len;
+        stream->cpu = NULL == cpus ? -1 : cpus[created];
+        stream->leader = 0 == created;
+        stream->time = time;
+        if (0 != pthread_create(thread_ids + created, NULL,
+                    ttc_hw_stream_run, stream))
+            break;
+    }
+    if (created < num_threads
+        || 0 != pthread_barrier_init(&barrier, NULL, num_threads))
+        abort = true;
+    pthread_mutex_unlock(&start);
+
+    uint32_t idx;
+    for (idx = 0; idx < created; ++idx)
+        pthread_join(thread_ids[idx], NULL);
+    if (!abort)
+        pthread_barrier_destroy(&barrier);
+
+    free(src);
+    free(dst);
+    free(streams);
+    free(thread_ids);
+    if (abort || 0 == time[0] || 0 == time[1] || 0 == time[2]) {
+        DEBUG_ERR_OUTPUT("Cannot start the threads.");
+        return -1;
+    }
+
+    double bytes = (double)sizeof(double) * len * num_threads;
+    bandwidth[0] = bytes / time[0] * 1e-9;
+    bandwidth[1] = bytes / time[1] * 1e-9;
+    bandwidth[2] = 2.0 * bytes / time[2] * 1e-9;
+
+    return 0;
+}
+
+
+/**
+ * @brief Function of a thread running the kernels, the fastest of
+ * TTC_HW_CALIB_REPEAT runs of every kernel is kept.
+ *
+ */
+void *
+ttc_hw_stream_run(
+        void    *arg
+        ) {
+    ttc_hw_stream_s *stream = (ttc_hw_stream_s *)arg;
+    pthread_mutex_lock(stream->start);
+    pthread_mutex_unlock(stream->start);
+    if (*stream->abort)
+        return NULL;
+
+    if (stream->cpu >= 0) {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(stream->cpu, &cpu_set);
+        sched_setaffinity(0, sizeof(cpu_set), &cpu_set);
+    }
+
+    // The first touch places the pages on the node of the thread
+    double *src = stream->src;
+    double *dst = stream->dst;
+    size_t len = stream->len;
+    size_t pos;
+    for (pos = 0; pos < len; ++pos) {
+        src[pos] = 1.0;
+        dst[pos] = 0.0;
+    }
+
+    uint32_t kernel, rep;
+    for (kernel = 0; kernel < 3; ++kernel) {
+        for (rep = 0; rep < TTC_HW_CALIB_REPEAT; ++rep) {
+            pthread_barrier_wait(stream->barrier);
+            double start = get_wtime();
+            if (0 == kernel) {
+                double sum = 0.0;
+                for (pos = 0; pos < len; ++pos)
+                    sum += src[pos];
+                stream->sink += sum;
+            }
+            else if (1 == kernel)
+                for (pos = 0; pos < len; ++pos)
+                    dst[pos] = (double)rep;
+            else
+                for (pos = 0; pos < len; ++pos)
+                    dst[pos] = src[pos];
+            pthread_barrier_wait(stream->barrier);
+            double time = get_wtime() - start;
+            if (stream->leader && time > 0
+                && (0 == stream->time[kernel] || time < stream->time[kernel]))
+                stream->time[kernel] = time;
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,729 @@
+#include "ttc_c_micro.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <string.h>
+
+#include "tensor_util.h"
+#include "ttc_c.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TTC_MICRO_X86
+#include <immintrin.h>
+#endif
+
+
+
+#ifdef TTC_MICRO_X86
+
+/* ======== Internal macro ======== */
+
+#define TTC_MICRO_AVX2_TARGET   __attribute__((target("avx2,fma")))
+#define TTC_MICRO_AVX512_TARGET __attribute__((target("avx512f")))
+#define TTC_MICRO_INLINE        static inline __attribute__((always_inline))
+
+#define TTC_MICRO_MIN(a, b)     ((a) < (b) ? (a) : (b))
+
+/**
+ * @brief A macro defining a micro-kernel from its register tile.
+ *
+ * @details The tile covers `width` x `width` elements of `esize` bytes, the
+ * tiles at the edges are smaller.
+ *
+ */
+#define TTC_MICRO_DEF_KERNEL(name, target, width, esize, tile)              \
+target static void                                                          \
+ttc_micro_##name(                                                           \
+        const void  *input,                                                 \
+        uint64_t    lda,                                                    \
+        void        *result,                                                \
+        uint64_t    ldb,                                                    \
+        uint64_t    m,                                                      \
+        uint64_t    n,                                                      \
+        double      alpha,                                                  \
+        double      beta                                                    \
+        ) {                                                                 \
+    const char *in = (const char *)input;                                   \
+    char *out = (char *)result;                                             \
+    uint64_t pos_i, pos_j;                                                  \
+    for (pos_j = 0; pos_j < n; pos_j += (width))                            \
+        for (pos_i = 0; pos_i < m; pos_i += (width)) {                      \
+            const char *in_tile = in + (pos_i + pos_j * lda) * (esize);     \
+            char *out_tile = out + (pos_j + pos_i * ldb) * (esize);         \
+            /* Full tiles get a copy of the tile with constant sizes */     \
+            if (pos_i + (width) <= m && pos_j + (width) <= n)               \
+                tile(in_tile, lda, out_tile, ldb, (width), (width), alpha,  \
+                        beta);                                              \
+            else                                                            \
+                tile(in_tile, lda, out_tile, ldb,                           \
+                        TTC_MICRO_MIN((width), m - pos_i),                  \
+                        TTC_MICRO_MIN((width), n - pos_j), alpha, beta);    \
+        }                                                                   \
+}
+
+
+
+/**
+ * @brief A macro moving the elements of a skinny matrix in a fixed order.
+ *
+ * @details The loop over `outer` runs along the long side of the matrix, the
+ * loop over `inner` along the short side, which has a constant length at the
+ * call sites. B is read only if `update` is true.
+ *
+ */
+#define TTC_MICRO_SKINNY_LOOP(type, outer, len_outer, inner, len_inner,    \
+        update)                                                             \
+    for (outer = 0; outer < (len_outer); ++outer)                           \
+        for (inner = 0; inner < (len_inner); ++inner) {                     \
+            const type *src = in + (pos_i + pos_j * lda) * num_comp;        \
+            type *dst = out + (pos_j + pos_i * ldb) * num_comp;             \
+            for (comp = 0; comp < num_comp; ++comp)                         \
+                dst[comp] = (update) ? alpha * src[comp] + beta * dst[comp] \
+                    : alpha * src[comp];                                    \
+        }
+
+/**
+ * @brief A macro calling a skinny loop with a constant short side.
+ *
+ * @details The short side is `n` if `along_m`, otherwise `m`.
+ *
+ */
+#define TTC_MICRO_SKINNY_CASE(body, width, along_m)                         \
+    case (width):                                                           \
+        body(in, lda, out, ldb, (along_m) ? m : (width),                    \
+                (along_m) ? (width) : n, alpha_v, beta_v, (along_m));       \
+        return;
+
+#define TTC_MICRO_SKINNY_CASES(body, along_m)                               \
+    TTC_MICRO_SKINNY_CASE(body, 2, along_m)                                 \
+    TTC_MICRO_SKINNY_CASE(body, 3, along_m)                                 \
+    TTC_MICRO_SKINNY_CASE(body, 4, along_m)                                 \
+    TTC_MICRO_SKINNY_CASE(body, 5, along_m)                                 \
+    TTC_MICRO_SKINNY_CASE(body, 6, along_m)                                 \
+    TTC_MICRO_SKINNY_CASE(body, 7, along_m)                                 \
+    TTC_MICRO_SKINNY_CASE(body, 8, along_m)
+
+/**
+ * @brief A macro defining the skinny kernel of a data type.
+ *
+ * @details The kernel has the signature of a micro-kernel and is meant for
+ * matrices with a side of at most TTC_MICRO_SKINNY elements. Every short
+ * side from 2 to TTC_MICRO_SKINNY gets a copy of the loops with a constant
+ * length, so that the compiler vectorizes along the long side with
+ * interleaving loads or stores instead of padding register tiles. Complex
+ * types are handled as `ncomp` scalars per element.
+ *
+ */
+#define TTC_MICRO_DEF_SKINNY(name, target, type, ncomp)                     \
+target TTC_MICRO_INLINE void                                                \
+ttc_micro_skinny_body_##name(                                               \
+        const type  *in,                                                    \
+        uint64_t    lda,                                                    \
+        type        *out,                                                   \
+        uint64_t    ldb,                                                    \
+        uint64_t    m,                                                      \
+        uint64_t    n,                                                      \
+        type        alpha,                                                  \
+        type        beta,                                                   \
+        bool        along_m                                                 \
+        ) {                                                                 \
+    const uint32_t num_comp = (ncomp);                                      \
+    uint64_t pos_i, pos_j;                                                  \
+    uint32_t comp;                                                          \
+    if (along_m && 0 != beta)                                               \
+        TTC_MICRO_SKINNY_LOOP(type, pos_i, m, pos_j, n, true)               \
+    else if (along_m)                                                       \
+        TTC_MICRO_SKINNY_LOOP(type, pos_i, m, pos_j, n, false)              \
+    else if (0 != beta)                                                     \
+        TTC_MICRO_SKINNY_LOOP(type, pos_j, n, pos_i, m, true)               \
+    else                                                                    \
+        TTC_MICRO_SKINNY_LOOP(type, pos_j, n, pos_i, m, false)              \
+}                                                                           \
+                                                                            \
+target static void                                                          \
+ttc_micro_##name(                                                           \
+        const void  *input,                                                 \
+        uint64_t    lda,                                                    \
+        void        *result,                                                \
+        uint64_t    ldb,                                                    \
+        uint64_t    m,                                                      \
+        uint64_t    n,                                                      \
+        double      alpha,                                                  \
+        double      beta                                                    \
+        ) {                                                                 \
+    const type *in = (const type *)input;                                   \
+    type *out = (type *)result;                                             \
+    const type alpha_v = (type)alpha;                                       \
+    const type beta_v = (type)beta;                                         \
+    if (n <= m)                                                             \
+        switch (n) {                                                        \
+            TTC_MICRO_SKINNY_CASES(ttc_micro_skinny_body_##name, true)      \
+        }                                                                   \
+    else                                                                    \
+        switch (m) {                                                        \
+            TTC_MICRO_SKINNY_CASES(ttc_micro_skinny_body_##name, false)     \
+        }                                                                   \
+    ttc_micro_skinny_body_##name(in, lda, out, ldb, m, n, alpha_v, beta_v,  \
+            n <= m);                                                        \
+}
+
+
+
+/* ======== Internal variable ======== */
+
+// A mask of the first k lanes starts at entry (lanes - k)
+static const int32_t ttc_micro_mask32[16]
+    = { -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0 };
+static const int64_t ttc_micro_mask64[8] = { -1, -1, -1, -1, 0, 0, 0, 0 };
+
+
+
+/* ======== Internal tile ======== */
+
+/**
+ * @brief AVX2 tile of 8 x 8 floats.
+ *
+ */
+TTC_MICRO_AVX2_TARGET TTC_MICRO_INLINE void
+ttc_micro_avx2_tile_s(
+        const void  *input,
+        uint64_t    lda,
+        void        *result,
+        uint64_t    ldb,
+        uint64_t    m,
+        uint64_t    n,
+        double      alpha,
+        double      beta
+        ) {
+    const float *in = (const float *)input;
+    float *out = (float *)result;
+    const bool full = 8 == m && 8 == n;
+    const __m128i mask_lo = _mm_loadu_si128(
+            (const __m128i *)(ttc_micro_mask32 + 8 - (m < 4 ? m : 4)));
+    const __m128i mask_hi = _mm_loadu_si128(
+            (const __m128i *)(ttc_micro_mask32 + 8 - (m > 4 ? m - 4 : 0)));
+    const __m256i mask_n
+        = _mm256_loadu_si256((const __m256i *)(ttc_micro_mask32 + 8 - n));
+    __m128 half[16];
+    __m256 row[8], tmp[8];
+    uint32_t idx;
+
+    // Column k and k + 4 share a register, so that the 128-bit lanes never
+    // need to be exchanged by a shuffle
+    for (idx = 0; idx < 8; ++idx) {
+        const float *col = in + idx * lda;
+        half[idx] = idx >= n ? _mm_setzero_ps()
+            : full ? _mm_loadu_ps(col) : _mm_maskload_ps(col, mask_lo);
+        half[idx + 8] = idx >= n ? _mm_setzero_ps()
+            : full ? _mm_loadu_ps(col + 4)
+            : _mm_maskload_ps(col + 4, mask_hi);
+    }
+    for (idx = 0; idx < 4; ++idx) {
+        row[idx] = _mm256_insertf128_ps(_mm256_castps128_ps256(half[idx]),
+                half[idx + 4], 1);
+        row[idx + 4] = _mm256_insertf128_ps(
+                _mm256_castps128_ps256(half[idx + 8]), half[idx + 12], 1);
+    }
+
+    for (idx = 0; idx < 8; idx += 2) {
+        tmp[idx] = _mm256_unpacklo_ps(row[idx], row[idx + 1]);
+        tmp[idx + 1] = _mm256_unpackhi_ps(row[idx], row[idx + 1]);
+    }
+    for (idx = 0; idx < 8; idx += 4) {
+        row[idx] = _mm256_shuffle_ps(tmp[idx], tmp[idx + 2], 0x44);
+        row[idx + 1] = _mm256_shuffle_ps(tmp[idx], tmp[idx + 2], 0xEE);
+        row[idx + 2] = _mm256_shuffle_ps(tmp[idx + 1], tmp[idx + 3], 0x44);
+        row[idx + 3] = _mm256_shuffle_ps(tmp[idx + 1], tmp[idx + 3], 0xEE);
+    }
+
+    const __m256 alpha_v = _mm256_set1_ps((float)alpha);
+    const __m256 beta_v = _mm256_set1_ps((float)beta);
+    for (idx = 0; idx < m; ++idx) {
+        float *col = out + idx * ldb;
+        __m256 value = _mm256_mul_ps(row[idx], alpha_v);
+        if (0 != beta)
+            value = _mm256_fmadd_ps(full ? _mm256_loadu_ps(col)
+                    : _mm256_maskload_ps(col, mask_n), beta_v, value);
+        if (full)
+            _mm256_storeu_ps(col, value);
+        else
+            _mm256_maskstore_ps(col, mask_n, value);
+    }
+}
+
+
+/**
+ * @brief AVX2 tile of 4 x 4 elements of 64 bits.
+ *
+ * @details The elements are doubles, or single complex numbers if `single`.
+ *
+ */
+TTC_MICRO_AVX2_TARGET TTC_MICRO_INLINE void
+ttc_micro_avx2_tile_64(
+        const void  *input,
+        uint64_t    lda,
+        void        *result,
+        uint64_t    ldb,
+        uint64_t    m,
+        uint64_t    n,
+        double      alpha,
+        double      beta,
+        bool        single
+        ) {
+    const double *in = (const double *)input;
+    double *out = (double *)result;
+    const bool full = 4 == m && 4 == n;
+    const __m256i mask_m
+        = _mm256_loadu_si256((const __m256i *)(ttc_micro_mask64 + 4 - m));
+    const __m256i mask_n
+        = _mm256_loadu_si256((const __m256i *)(ttc_micro_mask64 + 4 - n));
+    __m256d row[4], tmp[4];
+    uint32_t idx;
+
+    for (idx = 0; idx < 4; ++idx)
+        row[idx] = idx >= n ? _mm256_setzero_pd()
+            : full ? _mm256_loadu_pd(in + idx * lda)
+            : _mm256_maskload_pd(in + idx * lda, mask_m);
+
+    tmp[0] = _mm256_unpacklo_pd(row[0], row[1]);
+    tmp[1] = _mm256_unpackhi_pd(row[0], row[1]);
+    tmp[2] = _mm256_unpacklo_pd(row[2], row[3]);
+    tmp[3] = _mm256_unpackhi_pd(row[2], row[3]);
+    row[0] = _mm256_permute2f128_pd(tmp[0], tmp[2], 0x20);
+    row[1] = _mm256_permute2f128_pd(tmp[1], tmp[3], 0x20);
+    row[2] = _mm256_permute2f128_pd(tmp[0], tmp[2], 0x31);
+    row[3] = _mm256_permute2f128_pd(tmp[1], tmp[3], 0x31);
+
+    for (idx = 0; idx < m; ++idx) {
+        double *col = out + idx * ldb;
+        __m256d old = _mm256_setzero_pd(), value;
+        if (0 != beta)
+            old = full ? _mm256_loadu_pd(col)
+                : _mm256_maskload_pd(col, mask_n);
+        if (single)
+            value = _mm256_castps_pd(_mm256_fmadd_ps(_mm256_castpd_ps(old),
+                        _mm256_set1_ps((float)beta),
+                        _mm256_mul_ps(_mm256_castpd_ps(row[idx]),
+                            _mm256_set1_ps((float)alpha))));
+        else
+            value = _mm256_fmadd_pd(old, _mm256_set1_pd(beta),
+                    _mm256_mul_pd(row[idx], _mm256_set1_pd(alpha)));
+        if (full)
+            _mm256_storeu_pd(col, value);
+        else
+            _mm256_maskstore_pd(col, mask_n, value);
+    }
+}
+
+
+TTC_MICRO_AVX2_TARGET TTC_MICRO_INLINE void
+ttc_micro_avx2_tile_d(
+        const void  *input,
+        uint64_t    lda,
+        void        *result,
+        uint64_t    ldb,
+        uint64_t    m,
+        uint64_t    n,
+        double      alpha,
+        double      beta
+        ) {
+    ttc_micro_avx2_tile_64(input, lda, result, ldb, m, n, alpha, beta,
+            false);
+}
+
+
+TTC_MICRO_AVX2_TARGET TTC_MICRO_INLINE void
+ttc_micro_avx2_tile_c(
+        const void  *input,
+        uint64_t    lda,
+        void        *result,
+        uint64_t    ldb,
+        uint64_t    m,
+        uint64_t    n,
+        double      alpha,
+        double      beta
+        ) {
+    ttc_micro_avx2_tile_64(input, lda, result, ldb, m, n, alpha, beta,
+            true);
+}
+
+
+/**
+ * @brief AVX2 tile of 2 x 2 double complex numbers.
+ *
+ */
+TTC_MICRO_AVX2_TARGET TTC_MICRO_INLINE void
+ttc_micro_avx2_tile_z(
+        const void  *input,
+        uint64_t    lda,
+        void        *result,
+        uint64_t    ldb,
+        uint64_t    m,
+        uint64_t    n,
+        double      alpha,
+        double      beta
+        ) {
+    const double *in = (const double *)input;
+    double *out = (double *)result;
+    const __m256i mask_m = _mm256_loadu_si256(
+            (const __m256i *)(ttc_micro_mask64 + 4 - 2 * m));
+    const __m256i mask_n = _mm256_loadu_si256(
+            (const __m256i *)(ttc_micro_mask64 + 4 - 2 * n));
+    __m256d row[2], tmp[2];
+    uint32_t idx;
+
+    for (idx = 0; idx < 2; ++idx)
+        row[idx] = idx >= n ? _mm256_setzero_pd()
+            : _mm256_maskload_pd(in + 2 * idx * lda, mask_m);
+
+    tmp[0] = _mm256_permute2f128_pd(row[0], row[1], 0x20);
+    tmp[1] = _mm256_permute2f128_pd(row[0], row[1], 0x31);
+
+    for (idx = 0; idx < m; ++idx) {
+        double *col = out + 2 * idx * ldb;
+        __m256d value = _mm256_mul_pd(tmp[idx], _mm256_set1_pd(alpha));
+        if (0 != beta)
+            value = _mm256_fmadd_pd(_mm256_maskload_pd(col, mask_n),
+                    _mm256_set1_pd(beta), value);
+        _mm256_maskstore_pd(col, mask_n, value);
+    }
+}
+
+
+/**
+ * @brief AVX-512 tile of 16 x 16 floats.
+ *
+ */
+TTC_MICRO_AVX512_TARGET TTC_MICRO_INLINE void
+ttc_micro_avx512_tile_s(
+        const void  *input,
+        uint64_t    lda,
+        void        *result,
+        uint64_t    ldb,
+        uint64_t    m,
+        uint64_t    n,
+        double      alpha,
+        double      beta
+        ) {
+    const float *in = (const float *)input;
+    float *out = (float *)result;
+    const __mmask16 mask_m = (__mmask16)((1u << m) - 1);
+    const __mmask16 mask_n = (__mmask16)((1u << n) - 1);
+    __m512 row[16], tmp[16];
+    uint32_t idx;
+
+    for (idx = 0; idx < 16; ++idx)
+        row[idx] = idx >= n ? _mm512_setzero_ps()
+            : _mm512_maskz_loadu_ps(mask_m, in + idx * lda);
+
+    // Transpose the 4 x 4 blocks inside the 128-bit lanes, then the lanes
+    for (idx = 0; idx < 16; idx += 2) {
+        tmp[idx] = _mm512_unpacklo_ps(row[idx], row[idx + 1]);
+        tmp[idx + 1] = _mm512_unpackhi_ps(row[idx], row[idx + 1]);
+    }
+    for (idx = 0; idx < 16; idx += 4) {
+        row[idx] = _mm512_shuffle_ps(tmp[idx], tmp[idx + 2], 0x44);
+        row[idx + 1] = _mm512_shuffle_ps(tmp[idx], tmp[idx + 2], 0xEE);
+        row[idx + 2] = _mm512_shuffle_ps(tmp[idx + 1], tmp[idx + 3], 0x44);
+        row[idx + 3] = _mm512_shuffle_ps(tmp[idx + 1], tmp[idx + 3], 0xEE);
+    }
+    for (idx = 0; idx < 4; ++idx) {
+        __m512 lo_0 = _mm512_shuffle_f32x4(row[idx], row[idx + 4], 0x44);
+        __m512 hi_0 = _mm512_shuffle_f32x4(row[idx], row[idx + 4], 0xEE);
+        __m512 lo_1 = _mm512_shuffle_f32x4(row[idx + 8], row[idx + 12], 0x44);
+        __m512 hi_1 = _mm512_shuffle_f32x4(row[idx + 8], row[idx + 12], 0xEE);
+        tmp[idx] = _mm512_shuffle_f32x4(lo_0, lo_1, 0x88);
+        tmp[idx + 4] = _mm512_shuffle_f32x4(lo_0, lo_1, 0xDD);
+        tmp[idx + 8] = _mm512_shuffle_f32x4(hi_0, hi_1, 0x88);
+        tmp[idx + 12] = _mm512_shuffle_f32x4(hi_0, hi_1, 0xDD);
+    }
+
+    const __m512 alpha_v = _mm512_set1_ps((float)alpha);
+    const __m512 beta_v = _mm512_set1_ps((float)beta);
+    for (idx = 0; idx < m; ++idx) {
+        float *col = out + idx * ldb;
+        __m512 value = _mm512_mul_ps(tmp[idx], alpha_v);
+        if (0 != beta)
+            value = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask_n, col),
+                    beta_v, value);
+        _mm512_mask_storeu_ps(col, mask_n, value);
+    }
+}
+
+
+/**
+ * @brief AVX-512 tile of 8 x 8 elements of 64 bits.
+ *
+ * @details The elements are doubles, or single complex numbers if `single`.
+ *
+ */
+TTC_MICRO_AVX512_TARGET TTC_MICRO_INLINE void
+ttc_micro_avx512_tile_64(
+        const void  *input,
+        uint64_t    lda,
+        void        *result,
+        uint64_t    ldb,
+        uint64_t    m,
+        uint64_t    n,
+        double      alpha,
+        double      beta,
+        bool        single
+        ) {
+    const double *in = (const double *)input;
+    double *out = (double *)result;
+    const __mmask8 mask_m = (__mmask8)((1u << m) - 1);
+    const __mmask8 mask_n = (__mmask8)((1u << n) - 1);
+    __m512d row[8], tmp[8];
+    uint32_t idx;
+
+    for (idx = 0; idx < 8; ++idx)
+        row[idx] = idx >= n ? _mm512_setzero_pd()
+            : _mm512_maskz_loadu_pd(mask_m, in + idx * lda);
+
+    for (idx = 0; idx < 8; idx += 2) {
+        tmp[idx] = _mm512_unpacklo_pd(row[idx], row[idx + 1]);
+        tmp[idx + 1] = _mm512_unpackhi_pd(row[idx], row[idx + 1]);
+    }
+    for (idx = 0; idx < 2; ++idx) {
+        __m512d lo_0 = _mm512_shuffle_f64x2(tmp[idx], tmp[idx + 2], 0x44);
+        __m512d hi_0 = _mm512_shuffle_f64x2(tmp[idx], tmp[idx + 2], 0xEE);
+        __m512d lo_1 = _mm512_shuffle_f64x2(tmp[idx + 4], tmp[idx + 6], 0x44);
+        __m512d hi_1 = _mm512_shuffle_f64x2(tmp[idx + 4], tmp[idx + 6], 0xEE);
+        row[idx] = _mm512_shuffle_f64x2(lo_0, lo_1, 0x88);
+        row[idx + 2] = _mm512_shuffle_f64x2(lo_0, lo_1, 0xDD);
+        row[idx + 4] = _mm512_shuffle_f64x2(hi_0, hi_1, 0x88);
+        row[idx + 6] = _mm512_shuffle_f64x2(hi_0, hi_1, 0xDD);
+    }
+
+    for (idx = 0; idx < m; ++idx) {
+        double *col = out + idx * ldb;
+        __m512d old = _mm512_setzero_pd(), value;
+        if (0 != beta)
+            old = _mm512_maskz_loadu_pd(mask_n, col);
+        if (single)
+            value = _mm512_castps_pd(_mm512_fmadd_ps(_mm512_castpd_ps(old),
+                        _mm512_set1_ps((float)beta),
+                        _mm512_mul_ps(_mm512_castpd_ps(row[idx]),
+                            _mm512_set1_ps((float)alpha))));
+        else
+            value = _mm512_fmadd_pd(old, _mm512_set1_pd(beta),
+                    _mm512_mul_pd(row[idx], _mm512_set1_pd(alpha)));
+        _mm512_mask_storeu_pd(col, mask_n, value);
+    }
+}
+
+
+TTC_MICRO_AVX512_TARGET TTC_MICRO_INLINE void
+ttc_micro_avx512_tile_d(
+        const void  *input,
+        uint64_t    lda,
+        void        *result,
+        uint64_t    ldb,
+        uint64_t    m,
+        uint64_t    n,
+        double      alpha,
+        double      beta
+        ) {
+    ttc_micro_avx512_tile_64(input, lda, result, ldb, m, n, alpha, beta,
+            false);
+}
+
+
+TTC_MICRO_AVX512_TARGET TTC_MICRO_INLINE void
+ttc_micro_avx512_tile_c(
+        const void  *input,
+        uint64_t    lda,
+        void        *result,
+        uint64_t    ldb,
+        uint64_t    m,
+        uint64_t    n,
+        double      alpha,
+        double      beta
+        ) {
+    ttc_micro_avx512_tile_64(input, lda, result, ldb, m, n, alpha, beta,
+            true);
+}
+
+
+/**
+ * @brief AVX-512 tile of 4 x 4 double complex numbers.
+ *
+ */
+TTC_MICRO_AVX512_TARGET TTC_MICRO_INLINE void
+ttc_micro_avx512_tile_z(
+        const void  *input,
+        uint64_t    lda,
+        void        *result,
+        uint64_t    ldb,
+        uint64_t    m,
+        uint64_t    n,
+        double      alpha,
+        double      beta
+        ) {
+    const double *in = (const double *)input;
+    double *out = (double *)result;
+    const __mmask8 mask_m = (__mmask8)((1u << (2 * m)) - 1);
+    const __mmask8 mask_n = (__mmask8)((1u << (2 * n)) - 1);
+    __m512d row[4], tmp[4];
+    uint32_t idx;
+
+    for (idx = 0; idx < 4; ++idx)
+        row[idx] = idx >= n ? _mm512_setzero_pd()
+            : _mm512_maskz_loadu_pd(mask_m, in + 2 * idx * lda);
+
+    __m512d lo_0 = _mm512_shuffle_f64x2(row[0], row[1], 0x44);
+    __m512d hi_0 = _mm512_shuffle_f64x2(row[0], row[1], 0xEE);
+    __m512d lo_1 = _mm512_shuffle_f64x2(row[2], row[3], 0x44);
+    __m512d hi_1 = _mm512_shuffle_f64x2(row[2], row[3], 0xEE);
+    tmp[0] = _mm512_shuffle_f64x2(lo_0, lo_1, 0x88);
+    tmp[1] = _mm512_shuffle_f64x2(lo_0, lo_1, 0xDD);
+    tmp[2] = _mm512_shuffle_f64x2(hi_0, hi_1, 0x88);
+    tmp[3] = _mm512_shuffle_f64x2(hi_0, hi_1, 0xDD);
+
+    for (idx = 0; idx < m; ++idx) {
+        double *col = out + 2 * idx * ldb;
+        __m512d value = _mm512_mul_pd(tmp[idx], _mm512_set1_pd(alpha));
+        if (0 != beta)
+            value = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask_n, col),
+                    _mm512_set1_pd(beta), value);
+        _mm512_mask_storeu_pd(col, mask_n, value);
+    }
+}
+
+
+
+/* ======== Internal kernel ======== */
+
+TTC_MICRO_DEF_KERNEL(avx2_s, TTC_MICRO_AVX2_TARGET, 8, 4,
+        ttc_micro_avx2_tile_s)
+TTC_MICRO_DEF_KERNEL(avx2_d, TTC_MICRO_AVX2_TARGET, 4, 8,
+        ttc_micro_avx2_tile_d)
+TTC_MICRO_DEF_KERNEL(avx2_c, TTC_MICRO_AVX2_TARGET, 4, 8,
+        ttc_micro_avx2_tile_c)
+TTC_MICRO_DEF_KERNEL(avx2_z, TTC_MICRO_AVX2_TARGET, 2, 16,
+        ttc_micro_avx2_tile_z)
+TTC_MICRO_DEF_KERNEL(avx512_s, TTC_MICRO_AVX512_TARGET, 16, 4,
+        ttc_micro_avx512_tile_s)
+TTC_MICRO_DEF_KERNEL(avx512_d, TTC_MICRO_AVX512_TARGET, 8, 8,
+        ttc_micro_avx512_tile_d)
+TTC_MICRO_DEF_KERNEL(avx512_c, TTC_MICRO_AVX512_TARGET, 8, 8,
+        ttc_micro_avx512_tile_c)
+TTC_MICRO_DEF_KERNEL(avx512_z, TTC_MICRO_AVX512_TARGET, 4, 16,
+        ttc_micro_avx512_tile_z)
+
+TTC_MICRO_DEF_SKINNY(skinny_s, TTC_MICRO_AVX2_TARGET, float, 1)
+TTC_MICRO_DEF_SKINNY(skinny_d, TTC_MICRO_AVX2_TARGET, double, 1)
+TTC_MICRO_DEF_SKINNY(skinny_c, TTC_MICRO_AVX2_TARGET, float, 2)
+TTC_MICRO_DEF_SKINNY(skinny_z, TTC_MICRO_AVX2_TARGET, double, 2)
+
+#endif
+
+
+
+/* ======== Function definition ======== */
+
+ttc_micro_isa_e
+ttc_micro_isa(
+        ) {
+    // Detected once, every thread computes the same value
+    static int32_t cached = -1;
+    int32_t known = __atomic_load_n(&cached, __ATOMIC_RELAXED);
+    if (known >= 0)
+        return (ttc_micro_isa_e)known;
+
+    ttc_micro_isa_e isa = TTC_MICRO_NONE;
+#ifdef TTC_MICRO_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        isa = TTC_MICRO_AVX512;
+    else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        isa = TTC_MICRO_AVX2;
+#endif
+
+    // The environment may only lower the instruction set
+    const char *env = getenv(TTC_MICRO_ENV);
+    if (NULL != env) {
+        if (0 == strcmp(env, "none"))
+            isa = TTC_MICRO_NONE;
+        else if (0 == strcmp(env, "avx2") && isa > TTC_MICRO_AVX2)
+            isa = TTC_MICRO_AVX2;
+    }
+
+    __atomic_store_n(&cached, (int32_t)isa, __ATOMIC_RELAXED);
+    return isa;
+}
+
+
+ttc_micro_fn
+ttc_micro_select(
+        ttc_datatype_e  datatype
+        ) {
+#ifdef TTC_MICRO_X86
+    switch (ttc_micro_isa()) {
+        case TTC_MICRO_AVX512:
+            switch (datatype) {
+                case TTC_TYPE_DEFAULT:
+                case TTC_TYPE_S:
+                    return ttc_micro_avx512_s;
+                case TTC_TYPE_D:
+                    return ttc_micro_avx512_d;
+                case TTC_TYPE_C:
+                    return ttc_micro_avx512_c;
+                case TTC_TYPE_Z:
+                    return ttc_micro_avx512_z;
+                default:
+                    return NULL;
+            }
+        case TTC_MICRO_AVX2:
+            switch (datatype) {
+                case TTC_TYPE_DEFAULT:
+                case TTC_TYPE_S:
+                    return ttc_micro_avx2_s;
+                case TTC_TYPE_D:
+                    return ttc_micro_avx2_d;
+                case TTC_TYPE_C:
+                    return ttc_micro_avx2_c;
+                case TTC_TYPE_Z:
+                    return ttc_micro_avx2_z;
+                default:
+                    return NULL;
+            }
+        default:
+            return NULL;
+    }
+#else
+    (void)datatype;
+    return NULL;
+#endif
+}
+
+
+ttc_micro_fn
+ttc_micro_skinny(
+        ttc_datatype_e  datatype
+        ) {
+#ifdef TTC_MICRO_X86
+    // The kernels are vectorized by the compiler, AVX2 already has the
+    // permutations for interleaving loads and stores
+    if (TTC_MICRO_NONE == ttc_micro_isa())
+        return NULL;
+    switch (datatype) {
+        case TTC_TYPE_DEFAULT:
+        case TTC_TYPE_S:
+            return ttc_micro_skinny_s;
+        case TTC_TYPE_D:
+            return ttc_micro_skinny_d;
+        case TTC_TYPE_C:
+            return ttc_micro_skinny_c;
+        case TTC_TYPE_Z:
+            return ttc_micro_skinny_z;
+        default:
+            return NULL;
+    }
+#else
+    (void)datatype;
+    return NULL;
+#endif
+}
@@ -0,0 +1,251 @@
+#include "ttc_c_model.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "tensor_util.h"
+#include "ttc_c.h"
+#include "ttc_c_util.h"
+#include "ttc_c_tune.h"
+#include "ttc_c_hw.h"
+#include "ttc_c_engine.h"
+#include "ttc_c_micro.h"
+
+
+
+/* ======== Internal function ======== */
+
+void
+ttc_model_runs(
+        const ttc_param_s   *param,
+        double              *run_in,
+        double              *run_out
+        );
+
+
+
+/* ======== Function definition ======== */
+
+int32_t
+ttc_estimate(
+        ttc_handler_s       *handler,
+        const ttc_param_s   *param,
+        ttc_estimate_s      *estimate
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_estimate");
+    DEBUG_INFO_OUTPUT("Estimating a transposition.");
+    // Parameter check
+    if (NULL == handler) {
+        DEBUG_ERR_OUTPUT("handler is not initialized.");
+        return -1;
+    }
+    if (NULL == param || NULL == param->perm || NULL == param->size) {
+        DEBUG_ERR_OUTPUT("param is not well initialized.");
+        return -1;
+    }
+    if (NULL == estimate) {
+        DEBUG_ERR_OUTPUT("estimate is not initialized.");
+        return -1;
+    }
+
+    // An existing plan keeps its engine and has no setup cost
+    ttc_plan_s *plan = ttc_lookup_plan(handler, param);
+    DEBUG_SET_NAMESPACE("ttc_estimate");
+    if (NULL == plan) {
+        ttc_model_select(handler, param, estimate);
+        return 0;
+    }
+
+    DEBUG_INFO_OUTPUT("Estimating an existing plan.");
+    ttc_hw_bandwidth(&handler->hw);
+    ttc_model_predict(&handler->hw, &handler->options, param,
+            __atomic_load_n(&plan->engine, __ATOMIC_RELAXED), estimate);
+    estimate->setup = 0.0;
+    const uint64_t num_calls = __atomic_load_n(&plan->num_calls,
+            __ATOMIC_RELAXED);
+    double exec_time;
+    __atomic_load(&plan->exec_time, &exec_time, __ATOMIC_RELAXED);
+    if (0 != num_calls) {
+        estimate->time = exec_time / num_calls;
+        estimate->bandwidth = ttc_param_bytes(param) / estimate->time / 1e9;
+    }
+
+    return 0;
+}
+
+
+void
+ttc_model_predict(
+        const ttc_hw_s      *hw,
+        const ttc_opt_s     *options,
+        const ttc_param_s   *param,
+        ttc_engine_e        engine,
+        ttc_estimate_s      *estimate
+        ) {
+    // The passes have long runs, which the model below rates well, unlike
+    // the scattered single pass
+    ttc_engine_split_s split;
+    if (TTC_ENGINE_MULTIPASS == engine
+        && 0 == ttc_engine_split(param, &split)) {
+        ttc_estimate_s pass;
+        estimate->engine = engine;
+        estimate->bytes = 0.0;
+        estimate->time = 0.0;
+        estimate->setup = 0.0;
+        uint32_t idx;
+        for (idx = 0; idx < 2; ++idx) {
+            ttc_model_predict(hw, options, &split.pass[idx],
+                    TTC_ENGINE_GENERIC, &pass);
+            estimate->bytes += pass.bytes;
+            estimate->time += pass.time;
+        }
+        estimate->bandwidth = ttc_param_bytes(param) / estimate->time / 1e9;
+        return;
+    }
+
+    double elem = 1.0;
+    uint32_t idx;
+    for (idx = 0; idx < param->dim; ++idx)
+        elem *= param->size[idx];
+
+    double bytes = ttc_param_bytes(param);
+    double bytes_in = elem * ttc_type_size(param->datatype, false);
+    double bytes_out = bytes - bytes_in;
+
+    // Runs shorter than a cache line waste the rest of the line
+    double eff_in = 1.0, eff_out = 1.0;
+    double eff_engine = TTC_MODEL_COPY_EFF;
+    if (TTC_ENGINE_COPY != engine) {
+        double run_in, run_out;
+        ttc_model_runs(param, &run_in, &run_out);
+        eff_in = run_in * ttc_type_size(param->datatype, false)
+            / TTC_MODEL_LINE_SIZE;
+        eff_out = run_out * ttc_type_size(param->datatype, true)
+            / TTC_MODEL_LINE_SIZE;
+        eff_in = eff_in > 1.0 ? 1.0 : eff_in;
+        eff_out = eff_out > 1.0 ? 1.0 : eff_out;
+        eff_engine = TTC_ENGINE_JIT == engine ? TTC_MODEL_JIT_EFF
+            : ttc_engine_is_rows(param) ? TTC_MODEL_ROW_EFF
+            : NULL != ttc_micro_select(param->datatype)
+            ? TTC_MODEL_MICRO_EFF : TTC_MODEL_GENERIC_EFF;
+
+        // The skinny kernels interleave the short side, so that both
+        // tensors are read and written in whole lines
+        if (TTC_ENGINE_JIT != engine && ttc_engine_is_skinny(param)) {
+            eff_in = eff_out = 1.0;
+            eff_engine = TTC_MODEL_SKINNY_EFF;
+        }
+    }
+
+    // The kernels of TTC run with the threads of the options, the built-in
+    // engines with the OpenMP threads (all the cores) if available
+    uint32_t threads = 1;
+    if (TTC_ENGINE_JIT == engine && NULL != options)
+        threads = options->num_threads;
+#ifdef _OPENMP
+    else if (TTC_ENGINE_JIT != engine)
+        threads = 0;
+#endif
+    double bandwidth = ttc_hw_copy_bandwidth(hw, threads);
+
+    estimate->engine = engine;
+    estimate->bytes = bytes;
+    estimate->time = (bytes_in / eff_in + bytes_out / eff_out)
+        / (bandwidth * 1e9 * eff_engine);
+    estimate->bandwidth = bytes / estimate->time / 1e9;
+    estimate->setup = 0.0;
+    if (TTC_ENGINE_JIT == engine)
+        estimate->setup = NULL == options || 0 == options->time_budget
+            ? TTC_MODEL_JIT_SETUP : options->time_budget / 1e3;
+}
+
+
+ttc_engine_e
+ttc_model_select(
+        ttc_handler_s       *handler,
+        const ttc_param_s   *param,
+        ttc_estimate_s      *chosen
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_model_select");
+    const ttc_opt_s *options = &handler->options;
+    ttc_engine_e engine = options->engine;
+    ttc_estimate_s estimate;
+
+    if (TTC_ARCH_CUDA == options->arch)
+        engine = TTC_ENGINE_JIT;
+    else if (TTC_ENGINE_JIT != engine && ttc_engine_is_copy(param))
+        engine = TTC_ENGINE_COPY;
+    else if (TTC_ENGINE_JIT != engine && TTC_ENGINE_RECURSIVE != engine
+            && (ttc_engine_is_rows(param) || ttc_engine_is_skinny(param)))
+        engine = TTC_ENGINE_GENERIC;
+    else if (TTC_ENGINE_COPY == engine || (TTC_ENGINE_MULTIPASS == engine
+            && !ttc_engine_is_multipass(param)))
+        engine = TTC_ENGINE_GENERIC;
+    else if (TTC_ENGINE_AUTO == engine) {
+        // A kernel of TTC is a single pass as well, so it suffers the same
+        // scattered runs
+        if (NULL != ttc_tune_lookup(handler, param))
+            engine = TTC_ENGINE_JIT;
+        else if (ttc_engine_is_multipass(param))
+            engine = TTC_ENGINE_MULTIPASS;
+        else {
+            // The generation pays off if it is amortized by the calls
+            ttc_estimate_s jit;
+            ttc_hw_bandwidth(&handler->hw);
+            ttc_model_predict(&handler->hw, options, param, TTC_ENGINE_JIT,
+                    &jit);
+            ttc_model_predict(&handler->hw, options, param,
+                    TTC_ENGINE_GENERIC, &estimate);
+            engine = (estimate.time - jit.time) * TTC_MODEL_JIT_CALLS
+                > jit.setup ? TTC_ENGINE_JIT : TTC_ENGINE_GENERIC;
+        }
+    }
+    DEBUG_SET_NAMESPACE("ttc_model_select");
+
+    // The kernels of TTC address the tensors with `int` offsets
+    if (TTC_ENGINE_JIT == engine && TTC_ARCH_CUDA != options->arch
+        && ttc_engine_is_large(param))
+        engine = TTC_ENGINE_GENERIC;
+    DEBUG_INFO_OUTPUT(TTC_ENGINE_JIT == engine ? "Chose JIT engine."
+            : TTC_ENGINE_COPY == engine ? "Chose copy engine."
+            : TTC_ENGINE_RECURSIVE == engine ? "Chose recursive engine."
+            : TTC_ENGINE_MULTIPASS == engine ? "Chose multi-pass engine."
+            : "Chose generic engine.");
+
+    if (NULL != chosen) {
+        ttc_hw_bandwidth(&handler->hw);
+        ttc_model_predict(&handler->hw, options, param, engine, chosen);
+    }
+
+    return engine;
+}
+
+
+
+/* ======== Internal function definition ======== */
+
+/**
+ * @brief Function for getting the contiguous runs of a transposition.
+ *
+ * @details The leading dimensions kept in place by the permutation are
+ * merged if there is no padding, otherwise the input runs along its first
+ * dimension and the output along the input dimension `perm[0]`.
+ *
+ */
+void
+ttc_model_runs(
+        const ttc_param_s   *param,
+        double              *run_in,
+        double              *run_out
+        ) {
+    *run_in = param->size[0];
+    *run_out = param->size[param->perm[0]];
+    if (0 != param->perm[0] || NULL != param->lda || NULL != param->ldb)
+        return;
+
+    uint32_t idx;
+    for (idx = 1; idx < param->dim && idx == param->perm[idx]; ++idx)
+        *run_in *= param->size[idx];
+    *run_out = *run_in;
+}
@@ -0,0 +1,999 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "ttc_c_tune.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <errno.h>
+#include <unistd.h>
+#include <dlfcn.h>
+
+#include "tensor_util.h"
+#include "ttc_c.h"
+#include "ttc_c_util.h"
+#include "ttc_c_hw.h"
+#include "ttc_c_model.h"
+#include "ttc_c_engine.h"
+
+
+
+/* ======== Internal macro ======== */
+
+#define TTC_TUNE_LINE_SIZE      TTC_GEN_BUF_SIZE
+
+
+/* ======== Internal function ======== */
+
+int32_t
+ttc_tune_parse_line(
+        char        *line,
+        ttc_tune_s  *tune
+        );
+
+
+int32_t
+ttc_tune_parse_array(
+        char        **parse_ptr,
+        uint32_t    **arr,
+        uint32_t    *length
+        );
+
+
+void
+ttc_tune_print_array(
+        FILE            *target_file,
+        const uint32_t  *arr,
+        uint32_t        length
+        );
+
+
+bool
+ttc_tune_match(
+        const ttc_tune_s    *tune,
+        const ttc_param_s   *param
+        );
+
+
+double
+ttc_tune_search(
+        const ttc_opt_s     *options,
+        const ttc_hw_s      *hw,
+        const ttc_param_s   *param,
+        const void          *input,
+        void                *result,
+        ttc_tune_s          *best,
+        uint32_t            *loop_perm,
+        uint32_t            mask
+        );
+
+
+void *
+ttc_retune_run(
+        void    *retune
+        );
+
+
+
+/* ======== Function definition ======== */
+
+int32_t
+ttc_autotune(
+        ttc_handler_s       *handler,
+        const ttc_param_s   *param,
+        const void          *input,
+        void                *result
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_autotune");
+    DEBUG_INFO_OUTPUT("Tuning a plan.");
+    // Parameter check
+    if (NULL == handler) {
+        DEBUG_ERR_OUTPUT("handler is not initialized.");
+        return -1;
+    }
+    if (NULL == param || NULL == param->perm || NULL == param->size) {
+        DEBUG_ERR_OUTPUT("param is not well initialized.");
+        return -1;
+    }
+    if (NULL == input || NULL == result) {
+        DEBUG_ERR_OUTPUT("input or result is not initialized.");
+        return -1;
+    }
+    if (TTC_ARCH_CUDA == handler->options.arch) {
+        DEBUG_ERR_OUTPUT("CUDA plans cannot be tuned on host buffers.");
+        return -1;
+    }
+    if (ttc_engine_is_large(param)) {
+        DEBUG_ERR_OUTPUT("The tensors are too large for the kernels of TTC.");
+        return -1;
+    }
+
+    uint32_t loop_perm[param->dim];
+    ttc_tune_s best;
+    double best_time = ttc_tune_search(&handler->options, &handler->hw, param,
+            input, result, &best, loop_perm, TTC_TUNE_STATUS_MASK);
+    DEBUG_SET_NAMESPACE("ttc_autotune");
+    if (best_time < 0.0) {
+        DEBUG_ERR_OUTPUT("No candidate can be created.");
+        return -1;
+    }
+
+    // Replace the plan in handler with the winner
+    DEBUG_INFO_OUTPUT("Creating the plan of the best candidate.");
+    ttc_plan_s *best_plan
+        = ttc_tune_create_plan(&handler->options, param, &best);
+    DEBUG_SET_NAMESPACE("ttc_autotune");
+    if (NULL == best_plan) {
+        DEBUG_ERR_OUTPUT("Cannot create the plan of the best candidate.");
+        return -1;
+    }
+
+    ttc_plan_s *old_plan = ttc_lookup_plan(handler, param);
+    if (NULL != old_plan) {
+        ttc_detach_plan(handler, old_plan);
+        ttc_release_plan(old_plan);
+    }
+    ttc_attach_plan(handler, best_plan);
+
+    // Save the winner
+    int32_t ret = ttc_tune_insert(handler, &best, true);
+    DEBUG_SET_NAMESPACE("ttc_autotune");
+    if (0 != ret) {
+        DEBUG_ERR_OUTPUT("Cannot insert tuning record.");
+        return ret;
+    }
+
+    const char *path = NULL == handler->options.tune_db
+        ? TTC_TUNE_DB_DEFAULT : handler->options.tune_db;
+    if (0 != ttc_tune_save(path, &best)) {
+        DEBUG_SET_NAMESPACE("ttc_autotune");
+        DEBUG_WARN_OUTPUT("Cannot save tuning record, "
+                "it is only kept in the handler.");
+    }
+
+    return 0;
+}
+
+
+double
+ttc_tune_eval(
+        const ttc_opt_s     *options,
+        const ttc_param_s   *param,
+        const ttc_tune_s    *tune,
+        const void          *input,
+        void                *result,
+        char                *flush
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_tune_eval");
+    DEBUG_INFO_OUTPUT("Evaluating a candidate.");
+
+    ttc_plan_s *plan = ttc_tune_create_plan(options, param, tune);
+    DEBUG_SET_NAMESPACE("ttc_tune_eval");
+    if (NULL == plan) {
+        DEBUG_WARN_OUTPUT("Cannot create candidate plan.");
+        return -1.0;
+    }
+
+    double hot_time = ttc_tune_time_plan(plan, input, result, NULL);
+    double cold_time = ttc_tune_time_plan(plan, input, result, flush);
+    ttc_release_plan(plan);
+    if (hot_time < 0.0 || cold_time < 0.0)
+        return -1.0;
+
+    // Hot and cold cache are weighted equally
+    return 0.5 * (hot_time + cold_time);
+}
+
+
+double
+ttc_tune_search(
+        const ttc_opt_s     *options,
+        const ttc_hw_s      *hw,
+        const ttc_param_s   *param,
+        const void          *input,
+        void                *result,
+        ttc_tune_s          *best,
+        uint32_t            *loop_perm,
+        uint32_t            mask
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_tune_search");
+    DEBUG_INFO_OUTPUT("Searching the best configuration.");
+
+    char *flush = (char *)malloc(TTC_TUNE_FLUSH_SIZE);
+    if (NULL == flush) {
+        DEBUG_ERR_OUTPUT(strerror(errno));
+        return -1.0;
+    }
+
+    // Initial configuration: the options
+    uint32_t dim = param->dim;
+    uint32_t identity[dim];
+    uint32_t idx;
+    for (idx = 0; idx < dim; ++idx)
+        identity[idx] = idx;
+
+    best->datatype      = param->datatype;
+    best->dim           = dim;
+    best->perm          = param->perm;
+    best->size          = param->size;
+    best->loop_perm     = param->loop_perm;
+    best->num_threads   = options->num_threads;
+    best->blocking[0]   = 0;
+    best->blocking[1]   = 0;
+    best->pref_dist     = -1;
+    best->status        = options->status & TTC_TUNE_STATUS_MASK;
+    best->max_impl      = 1;
+    best->bandwidth     = 0.0;
+    best->next          = NULL;
+
+    double best_time
+        = ttc_tune_eval(options, param, best, input, result, flush);
+
+    // Candidate values of every tuned dimension
+    const uint32_t blockings[][2]
+        = { { 0, 0 }, { 8, 8 }, { 16, 16 }, { 8, 16 }, { 16, 8 } };
+    const int32_t pref_dists[] = { -1, 0, 2, 5, 8 };
+    const uint32_t *loop_perms[] = { NULL, identity, param->perm };
+    // All the cores, and the fewest threads saturating the memory
+    const uint32_t num_threads[] = { options->num_threads, hw->num_cores,
+        ttc_hw_threads(hw) };
+
+    // Sweep the dimensions one after another (coordinate descent), each
+    // candidate differs from the best one in a single value.
+    uint32_t sweep;
+    for (sweep = 0; sweep < 5; ++sweep) {
+        uint32_t num_cand = 0 == sweep ? 2
+            : 1 == sweep ? sizeof(blockings) / sizeof(blockings[0])
+            : 2 == sweep ? sizeof(pref_dists) / sizeof(pref_dists[0])
+            : 3 == sweep ? sizeof(loop_perms) / sizeof(loop_perms[0])
+            : sizeof(num_threads) / sizeof(num_threads[0]);
+
+        // The fixed status bits are not swept
+        if (0 == sweep && 0 == (mask & TTC_USE_STM_STORE))
+            continue;
+
+        uint32_t cand_idx;
+        for (cand_idx = 0; cand_idx < num_cand; ++cand_idx) {
+            ttc_tune_s cand = *best;
+            if (0 == sweep)
+                cand.status = 0 == cand_idx ? 0 : TTC_USE_STM_STORE;
+            else if (1 == sweep) {
+                cand.blocking[0] = blockings[cand_idx][0];
+                cand.blocking[1] = blockings[cand_idx][1];
+            }
+            else if (2 == sweep)
+                cand.pref_dist = pref_dists[cand_idx];
+            else if (3 == sweep)
+                cand.loop_perm = (uint32_t *)loop_perms[cand_idx];
+            else
+                cand.num_threads = num_threads[cand_idx];
+
+            // Skip the configuration already measured
+            if (cand.status == best->status
+                && cand.blocking[0] == best->blocking[0]
+                && cand.blocking[1] == best->blocking[1]
+                && cand.pref_dist == best->pref_dist
+                && cand.num_threads == best->num_threads
+                && (cand.loop_perm == best->loop_perm
+                    || (NULL != cand.loop_perm && NULL != best->loop_perm
+                        && uint32cmp(cand.loop_perm, best->loop_perm, dim))))
+                continue;
+
+            double cand_time
+                = ttc_tune_eval(options, param, &cand, input, result, flush);
+            DEBUG_SET_NAMESPACE("ttc_tune_search");
+            if (cand_time >= 0.0
+                && (best_time < 0.0 || cand_time < best_time)) {
+                DEBUG_INFO_OUTPUT("Found a faster candidate.");
+                *best = cand;
+                best_time = cand_time;
+            }
+        }
+    }
+    free(flush);
+
+    // The loop order must outlive the local candidates
+    if (NULL != best->loop_perm) {
+        memcpy(loop_perm, best->loop_perm, sizeof(uint32_t) * dim);
+        best->loop_perm = loop_perm;
+    }
+    if (best_time >= 0.0)
+        best->bandwidth = ttc_param_bytes(param) / best_time * 1e-9;
+
+    return best_time;
+}
+
+
+double
+ttc_tune_time_plan(
+        ttc_plan_s  *plan,
+        const void  *input,
+        void        *result,
+        char        *flush
+        ) {
+    double min_time = -1.0;
+
+    uint32_t rep;
+    for (rep = 0; rep < TTC_TUNE_REPEAT; ++rep) {
+        if (NULL != flush)
+            memset(flush, rep, TTC_TUNE_FLUSH_SIZE);
+
+        double start = get_wtime();
+        if (0 != ttc_exec_plan(plan, input, result, TTC_STORE_AUTO))
+            return -1.0;
+        double elapsed = get_wtime() - start;
+
+        if (min_time < 0.0 || elapsed < min_time)
+            min_time = elapsed;
+    }
+
+    return min_time;
+}
+
+
+ttc_plan_s *
+ttc_tune_create_plan(
+        const ttc_opt_s     *options,
+        const ttc_param_s   *param,
+        const ttc_tune_s    *tune
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_tune_create_plan");
+    DEBUG_INFO_OUTPUT("Creating a plan with a tuning record.");
+
+    // The arrays in options are not released by ttc_create_plan, so they can
+    // point to local objects.
+    ttc_opt_s tune_options = *options;
+    uint32_t blocking[2] = { tune->blocking[0], tune->blocking[1] };
+    uint32_t pref_dist = (uint32_t)tune->pref_dist;
+
+    tune_options.max_impl = tune->max_impl;
+    tune_options.time_budget = 0;
+    tune_options.grid = 0;
+    if (0 != tune->num_threads)
+        tune_options.num_threads = tune->num_threads;
+    if (0 != blocking[0] && 0 != blocking[1]) {
+        tune_options.blockings = blocking;
+        tune_options.blockings_len = 2;
+    }
+    if (tune->pref_dist >= 0) {
+        tune_options.pref_dist = &pref_dist;
+        tune_options.pref_dist_len = 1;
+    }
+    tune_options.status = (options->status & ~TTC_TUNE_STATUS_MASK)
+        | (tune->status & TTC_TUNE_STATUS_MASK);
+
+    ttc_param_s tune_param = *param;
+    if (NULL != tune->loop_perm)
+        tune_param.loop_perm = tune->loop_perm;
+
+    ttc_plan_s *new_plan = ttc_create_plan(&tune_options, &tune_param);
+    DEBUG_SET_NAMESPACE("ttc_tune_create_plan");
+    if (NULL == new_plan) {
+        DEBUG_ERR_OUTPUT("Cannot create plan.");
+        return NULL;
+    }
+
+    // Keep the signature of the requested parameter
+    if (tune_param.loop_perm != param->loop_perm) {
+        free(new_plan->param.loop_perm);
+        new_plan->param.loop_perm = NULL;
+        if (NULL != param->loop_perm) {
+            new_plan->param.loop_perm
+                = (uint32_t *)malloc(sizeof(uint32_t) * param->dim);
+            if (NULL == new_plan->param.loop_perm) {
+                DEBUG_ERR_OUTPUT(strerror(errno));
+                ttc_release_plan(new_plan);
+                return NULL;
+            }
+            memcpy(new_plan->param.loop_perm, param->loop_perm,
+                    sizeof(uint32_t) * param->dim);
+        }
+    }
+
+    return new_plan;
+}
+
+
+int32_t
+ttc_retune_check(
+        const ttc_handler_s *handler,
+        const ttc_plan_s    *base,
+        ttc_plan_s          *plan
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_retune_check");
+    // Parameter check
+    if (NULL == handler || NULL == base || NULL == plan)
+        return -1;
+
+    // Only check at 16, 32, 64, ... calls to keep the executions cheap, the
+    // built-in engines and the shared tile kernels are not tuned
+    const uint64_t num_calls = __atomic_load_n(&plan->num_calls,
+            __ATOMIC_RELAXED);
+    if (0 == handler->options.retune
+        || NULL != __atomic_load_n(&plan->retune, __ATOMIC_ACQUIRE)
+        || TTC_ENGINE_JIT != __atomic_load_n(&plan->engine, __ATOMIC_RELAXED)
+        || NULL != plan->tile || num_calls < TTC_RETUNE_MIN_CALLS
+        || 0 != (num_calls & (num_calls - 1)))
+        return 0;
+
+    // Best bandwidth of the comparable plans and tuning records
+    double best_bandwidth = 0.0;
+    const ttc_plan_s *cmp_plan = handler->plans;
+    for (; NULL != cmp_plan; cmp_plan = cmp_plan->next) {
+        if (cmp_plan == plan || TTC_RETUNE_MIN_CALLS
+                > __atomic_load_n(&cmp_plan->num_calls, __ATOMIC_RELAXED)
+            || cmp_plan->param.datatype != plan->param.datatype
+            || cmp_plan->param.dim != plan->param.dim)
+            continue;
+        double bandwidth = ttc_plan_bandwidth(cmp_plan);
+        if (bandwidth > best_bandwidth)
+            best_bandwidth = bandwidth;
+    }
+
+    const ttc_tune_s *cmp_tune = handler->tunes;
+    for (; NULL != cmp_tune; cmp_tune = cmp_tune->next)
+        if (cmp_tune->datatype == plan->param.datatype
+            && cmp_tune->dim == plan->param.dim
+            && cmp_tune->bandwidth > best_bandwidth)
+            best_bandwidth = cmp_tune->bandwidth;
+
+    if (ttc_plan_bandwidth(plan) * 100.0
+        >= best_bandwidth * handler->options.retune)
+        return 0;
+
+    // Start a re-tuning job
+    DEBUG_INFO_OUTPUT("Starting a re-tuning job.");
+    ttc_retune_s *job = (ttc_retune_s *)malloc(sizeof(ttc_retune_s));
+    if (NULL == job) {
+        DEBUG_ERR_OUTPUT(strerror(errno));
+        return errno;
+    }
+    job->mask = ttc_retune_options(&handler->options, plan, base != plan,
+            &job->options);
+    job->hw = &handler->hw;
+    job->plan = plan;
+    job->dlhandler = NULL;
+
+    // The job claims the plan before its thread starts, so that a call of
+    // the plan on another thread cannot start a second one
+    void *empty = NULL;
+    if (!__atomic_compare_exchange_n(&plan->retune, &empty, job, false,
+                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        DEBUG_INFO_OUTPUT("Another call started the job.");
+        free(job);
+        return 0;
+    }
+
+    int32_t ret = pthread_create(&job->thread, NULL, ttc_retune_run, job);
+    if (0 != ret) {
+        DEBUG_ERR_OUTPUT(strerror(ret));
+        __atomic_store_n(&plan->retune, NULL, __ATOMIC_RELEASE);
+        free(job);
+        return ret;
+    }
+
+    return 0;
+}
+
+
+uint32_t
+ttc_retune_options(
+        const ttc_opt_s     *options,
+        const ttc_plan_s    *plan,
+        bool                variant,
+        ttc_opt_s           *result
+        ) {
+    // The status follows the kernel, which a re-tuning thread may replace
+    const uint32_t status = __atomic_load_n(&plan->status, __ATOMIC_RELAXED);
+    *result = *options;
+    result->tune_db = NULL;
+    // The store variant of a base plan has the opposite stores, which a
+    // change of the plan's stores would make identical
+    if (variant || NULL != plan->store_plan) {
+        result->status = status;
+        return 0;
+    }
+
+    result->status = (status & ~TTC_TUNE_STATUS_MASK)
+        | (options->status & TTC_TUNE_STATUS_MASK);
+    return TTC_TUNE_STATUS_MASK;
+}
+
+
+void *
+ttc_retune_run(
+        void    *retune
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_retune_run");
+    DEBUG_INFO_OUTPUT("Re-tuning a plan.");
+    ttc_retune_s *job = (ttc_retune_s *)retune;
+    ttc_plan_s *plan = job->plan;
+    const ttc_param_s *param = &plan->param;
+
+    // Scratch buffers covering the padded tensors
+    size_t input_len = 1, result_len = 1;
+    uint32_t idx;
+    for (idx = 0; idx < param->dim; ++idx) {
+        input_len *= NULL == param->lda
+            ? param->size[idx] : (size_t)param->lda[idx];
+        result_len *= NULL == param->ldb
+            ? param->size[param->perm[idx]] : (size_t)param->ldb[idx];
+    }
+    void *input = calloc(input_len, ttc_type_size(param->datatype, false));
+    void *result = calloc(result_len, ttc_type_size(param->datatype, true));
+    char *flush = (char *)malloc(TTC_TUNE_FLUSH_SIZE);
+    if (NULL == input || NULL == result || NULL == flush) {
+        DEBUG_ERR_OUTPUT(strerror(errno));
+        free(input);
+        free(result);
+        free(flush);
+        return NULL;
+    }
+
+    // Time the current kernel on a private plan, the statistics of the plan
+    // are updated by the executing thread
+    ttc_plan_s current = { .param = *param, .dlhandler = NULL,
+        .fn = __atomic_load_n(&plan->fn, __ATOMIC_ACQUIRE), .fn_cuda = NULL,
+        .num_calls = 0, .exec_time = 0.0, .retune = NULL,
+        .body_size = plan->body_size, .next = NULL };
+    double current_time = 0.5
+        * (ttc_tune_time_plan(&current, input, result, NULL)
+            + ttc_tune_time_plan(&current, input, result, flush));
+    free(flush);
+
+    uint32_t loop_perm[param->dim];
+    ttc_tune_s best;
+    double best_time = ttc_tune_search(&job->options, job->hw, param, input,
+            result, &best, loop_perm, job->mask);
+    free(input);
+    free(result);
+    DEBUG_SET_NAMESPACE("ttc_retune_run");
+    if (best_time < 0.0 || best_time >= TTC_RETUNE_MIN_GAIN * current_time) {
+        DEBUG_INFO_OUTPUT("No faster kernel is found.");
+        return NULL;
+    }
+
+    // Replace the kernel, the library is kept by the job
+    ttc_plan_s *new_plan = ttc_tune_create_plan(&job->options, param, &best);
+    DEBUG_SET_NAMESPACE("ttc_retune_run");
+    if (NULL == new_plan) {
+        DEBUG_ERR_OUTPUT("Cannot create the re-tuned plan.");
+        return NULL;
+    }
+    DEBUG_INFO_OUTPUT("Replacing the kernel of the plan.");
+    job->dlhandler = new_plan->dlhandler;
+    __atomic_store_n(&plan->fn, new_plan->fn, __ATOMIC_RELEASE);
+    __atomic_store_n(&plan->status, new_plan->status, __ATOMIC_RELAXED);
+    new_plan->dlhandler = NULL;
+    ttc_release_plan(new_plan);
+
+    return NULL;
+}
+
+
+void
+ttc_retune_release(
+        void    *retune
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_retune_release");
+    if (NULL == retune)
+        return;
+
+    DEBUG_INFO_OUTPUT("Waiting for the re-tuning thread.");
+    ttc_retune_s *job = (ttc_retune_s *)retune;
+    pthread_join(job->thread, NULL);
+
+    if (NULL != job->dlhandler && 0 != dlclose(job->dlhandler))
+        DEBUG_ERR_OUTPUT("Cannot close dlhandler.");
+    free(job);
+}
+
+
+double
+ttc_plan_bandwidth(
+        const ttc_plan_s    *plan
+        ) {
+    if (NULL == plan)
+        return 0.0;
+
+    double exec_time;
+    __atomic_load(&plan->exec_time, &exec_time, __ATOMIC_RELAXED);
+    if (exec_time <= 0.0)
+        return 0.0;
+
+    return ttc_param_bytes(&plan->param)
+        * __atomic_load_n(&plan->num_calls, __ATOMIC_RELAXED) / exec_time
+        * 1e-9;
+}
+
+
+ttc_tune_s *
+ttc_tune_lookup(
+        const ttc_handler_s *handler,
+        const ttc_param_s   *param
+        ) {
+    if (NULL == handler || NULL == param)
+        return NULL;
+
+    ttc_tune_s *lookup = handler->tunes;
+    for (; NULL != lookup; lookup = lookup->next)
+        if (ttc_tune_match(lookup, param))
+            return lookup;
+
+    return NULL;
+}
+
+
+ttc_tune_s *
+ttc_tune_transfer(
+        const ttc_handler_s *handler,
+        const ttc_param_s   *param
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_tune_transfer");
+    if (NULL == handler || NULL == param)
+        return NULL;
+
+    // The nearest size with the same permutation
+    ttc_tune_s *nearest = NULL;
+    double nearest_dist = TTC_TUNE_NEAR_MAX;
+    ttc_tune_s *tune = handler->tunes;
+    for (; NULL != tune; tune = tune->next) {
+        if (tune->dim != param->dim || tune->datatype != param->datatype
+            || !uint32cmp(tune->perm, param->perm, tune->dim))
+            continue;
+        double dist = 0.0;
+        uint32_t idx;
+        for (idx = 0; idx < param->dim; ++idx)
+            dist += fabs(log((double)tune->size[idx] / param->size[idx]));
+        if (dist <= nearest_dist) {
+            nearest = tune;
+            nearest_dist = dist;
+        }
+    }
+    if (NULL == nearest)
+        return NULL;
+
+    // A full search pays off if its expected gain over the calls exceeds
+    // its cost
+    ttc_estimate_s estimate;
+    ttc_model_predict(&handler->hw, &handler->options, param, TTC_ENGINE_JIT,
+            &estimate);
+    double gain = estimate.time * TTC_MODEL_JIT_CALLS * TTC_TUNE_NEAR_GAIN
+        * (nearest_dist < 1.0 ? nearest_dist : 1.0);
+    if (gain > estimate.setup) {
+        DEBUG_INFO_OUTPUT("A full search is worth its cost.");
+        return NULL;
+    }
+
+    DEBUG_INFO_OUTPUT("Transferring the record of a near size.");
+    return nearest;
+}
+
+
+bool
+ttc_tune_match(
+        const ttc_tune_s    *tune,
+        const ttc_param_s   *param
+        ) {
+    return tune->dim == param->dim
+        && tune->datatype == param->datatype
+        && uint32cmp(tune->perm, param->perm, tune->dim)
+        && uint32cmp(tune->size, param->size, tune->dim);
+}
+
+
+int32_t
+ttc_tune_insert(
+        ttc_handler_s       *handler,
+        const ttc_tune_s    *tune,
+        bool                replace
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_tune_insert");
+    // Parameter check
+    if (NULL == handler || NULL == tune) {
+        DEBUG_ERR_OUTPUT("handler or tune is not initialized.");
+        return -1;
+    }
+
+    ttc_param_s sig = ttc_default_param();
+    sig.datatype = tune->datatype;
+    sig.dim = tune->dim;
+    sig.perm = tune->perm;
+    sig.size = tune->size;
+
+    ttc_tune_s *target = ttc_tune_lookup(handler, &sig);
+    if (NULL != target && !replace && target->bandwidth >= tune->bandwidth)
+        return 0;
+
+    // Create a new record with its own arrays
+    ttc_tune_s *new_tune = (ttc_tune_s *)malloc(sizeof(ttc_tune_s));
+    if (NULL == new_tune) {
+        DEBUG_ERR_OUTPUT(strerror(errno));
+        return errno;
+    }
+    *new_tune = *tune;
+    new_tune->loop_perm = NULL;
+    new_tune->next = NULL;
+
+    uint32_t arr_len = NULL == tune->loop_perm ? 2 : 3;
+    new_tune->perm = (uint32_t *)malloc(sizeof(uint32_t) * tune->dim * arr_len);
+    if (NULL == new_tune->perm) {
+        DEBUG_ERR_OUTPUT(strerror(errno));
+        free(new_tune);
+        return errno;
+    }
+    new_tune->size = new_tune->perm + tune->dim;
+    memcpy(new_tune->perm, tune->perm, sizeof(uint32_t) * tune->dim);
+    memcpy(new_tune->size, tune->size, sizeof(uint32_t) * tune->dim);
+    if (NULL != tune->loop_perm) {
+        new_tune->loop_perm = new_tune->size + tune->dim;
+        memcpy(new_tune->loop_perm, tune->loop_perm,
+                sizeof(uint32_t) * tune->dim);
+    }
+
+    // Replace the existing record or prepend the new one
+    if (NULL != target) {
+        new_tune->next = target->next;
+        free(target->perm);
+        *target = *new_tune;
+        free(new_tune);
+    }
+    else {
+        new_tune->next = handler->tunes;
+        handler->tunes = new_tune;
+    }
+
+    return 0;
+}
+
+
+void
+ttc_tune_release(
+        ttc_tune_s  *tune
+        ) {
+    while (NULL != tune) {
+        ttc_tune_s *next = tune->next;
+        // size and loop_perm share the memory of perm
+        free(tune->perm);
+        free(tune);
+        tune = next;
+    }
+}
+
+
+int32_t
+ttc_tune_load(
+        ttc_handler_s   *handler,
+        const char      *path
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_tune_load");
+    DEBUG_INFO_OUTPUT("Loading tuning database.");
+    // Parameter check
+    if (NULL == handler || NULL == path) {
+        DEBUG_ERR_OUTPUT("handler or path is not initialized.");
+        return -1;
+    }
+
+    FILE *db_file = fopen(path, "r");
+    if (NULL == db_file) {
+        DEBUG_INFO_OUTPUT("Tuning database does not exist.");
+        return -1;
+    }
+
+    int32_t count = 0;
+    char line[TTC_TUNE_LINE_SIZE];
+    while (NULL != fgets(line, TTC_TUNE_LINE_SIZE, db_file)) {
+        if ('#' == line[0] || '\n' == line[0])
+            continue;
+
+        ttc_tune_s tune;
+        if (0 != ttc_tune_parse_line(line, &tune)) {
+            DEBUG_SET_NAMESPACE("ttc_tune_load");
+            DEBUG_WARN_OUTPUT("Skipping malformed line.");
+            continue;
+        }
+
+        if (0 == ttc_tune_insert(handler, &tune, false))
+            ++count;
+        free(tune.perm);
+        free(tune.size);
+        free(tune.loop_perm);
+    }
+
+    fclose(db_file);
+
+    return count;
+}
+
+
+int32_t
+ttc_tune_save(
+        const char          *path,
+        const ttc_tune_s    *tune
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_tune_save");
+    DEBUG_INFO_OUTPUT("Saving tuning record.");
+    // Parameter check
+    if (NULL == path || NULL == tune) {
+        DEBUG_ERR_OUTPUT("path or tune is not initialized.");
+        return -1;
+    }
+
+    bool exist = 0 == access(path, F_OK);
+    FILE *db_file = fopen(path, "a");
+    if (NULL == db_file) {
+        DEBUG_ERR_OUTPUT("Cannot open tuning database.");
+        return -1;
+    }
+
+    if (!exist)
+        fprintf(db_file, TTC_TUNE_DB_HEADER);
+
+    fprintf(db_file, "%d,", tune->datatype);
+    ttc_tune_print_array(db_file, tune->perm, tune->dim);
+    fprintf(db_file, ",");
+    ttc_tune_print_array(db_file, tune->size, tune->dim);
+    fprintf(db_file, ",");
+    ttc_tune_print_array(db_file, tune->loop_perm, tune->dim);
+    fprintf(db_file, ",%u,", tune->num_threads);
+    if (0 != tune->blocking[0] && 0 != tune->blocking[1])
+        fprintf(db_file, "%ux%u,", tune->blocking[0], tune->blocking[1]);
+    else
+        fprintf(db_file, TTC_TUNE_DB_NONE ",");
+    if (tune->pref_dist >= 0)
+        fprintf(db_file, "%d,", tune->pref_dist);
+    else
+        fprintf(db_file, TTC_TUNE_DB_NONE ",");
+    fprintf(db_file, "%u,%f,%u\n", tune->status, tune->bandwidth,
+            tune->max_impl);
+
+    fclose(db_file);
+
+    return 0;
+}
+
+
+void
+ttc_tune_print_array(
+        FILE            *target_file,
+        const uint32_t  *arr,
+        uint32_t        length
+        ) {
+    if (NULL == arr) {
+        fprintf(target_file, TTC_TUNE_DB_NONE);
+        return;
+    }
+
+    uint32_t idx;
+    for (idx = 0; idx < length; ++idx)
+        fprintf(target_file, 0 == idx ? "%u" : ":%u", arr[idx]);
+}
+
+
+int32_t
+ttc_tune_parse_array(
+        char        **parse_ptr,
+        uint32_t    **arr,
+        uint32_t    *length
+        ) {
+    *arr = NULL;
+    char *end_ptr = *parse_ptr;
+
+    // Empty value
+    if ('-' == *end_ptr) {
+        *parse_ptr = end_ptr + 1;
+        return ',' == **parse_ptr ? 0 : -1;
+    }
+
+    // Count the elements
+    uint32_t count = 1;
+    for (; ',' != *end_ptr && '\0' != *end_ptr; ++end_ptr)
+        if (':' == *end_ptr)
+            ++count;
+    if (0 != *length && count != *length)
+        return -1;
+
+    *arr = (uint32_t *)malloc(sizeof(uint32_t) * count);
+    if (NULL == *arr)
+        return -1;
+
+    uint32_t idx;
+    for (idx = 0; idx < count; ++idx) {
+        (*arr)[idx] = strtoul(*parse_ptr, &end_ptr, 10);
+        if (end_ptr == *parse_ptr) {
+            free(*arr);
+            *arr = NULL;
+            return -1;
+        }
+        *parse_ptr = end_ptr + (':' == *end_ptr ? 1 : 0);
+    }
+    *length = count;
+
+    return ',' == **parse_ptr ? 0 : -1;
+}
+
+
+int32_t
+ttc_tune_parse_line(
+        char        *line,
+        ttc_tune_s  *tune
+        ) {
+    tune->perm = NULL;
+    tune->size = NULL;
+    tune->loop_perm = NULL;
+    tune->next = NULL;
+    tune->dim = 0;
+
+    char *parse_ptr = line, *end_ptr;
+
+    // datatype
+    tune->datatype = (ttc_datatype_e)strtol(parse_ptr, &end_ptr, 10);
+    if (end_ptr == parse_ptr || ',' != *end_ptr)
+        return -1;
+    parse_ptr = end_ptr + 1;
+
+    // perm, size and loop_perm
+    if (0 != ttc_tune_parse_array(&parse_ptr, &tune->perm, &tune->dim)
+        || NULL == tune->perm)
+        goto parse_error;
+    ++parse_ptr;
+    if (0 != ttc_tune_parse_array(&parse_ptr, &tune->size, &tune->dim)
+        || NULL == tune->size)
+        goto parse_error;
+    ++parse_ptr;
+    if (0 != ttc_tune_parse_array(&parse_ptr, &tune->loop_perm, &tune->dim))
+        goto parse_error;
+    ++parse_ptr;
+
+    // num_threads
+    tune->num_threads = strtoul(parse_ptr, &end_ptr, 10);
+    if (end_ptr == parse_ptr || ',' != *end_ptr)
+        goto parse_error;
+    parse_ptr = end_ptr + 1;
+
+    // blocking
+    tune->blocking[0] = tune->blocking[1] = 0;
+    if ('-' == *parse_ptr)
+        ++parse_ptr;
+    else if (2 != sscanf(parse_ptr, "%ux%u", &tune->blocking[0],
+                &tune->blocking[1]))
+        goto parse_error;
+    parse_ptr = strchr(parse_ptr, ',');
+    if (NULL == parse_ptr)
+        goto parse_error;
+    ++parse_ptr;
+
+    // pref_dist
+    tune->pref_dist = -1;
+    if ('-' == *parse_ptr)
+        ++parse_ptr;
+    else {
+        tune->pref_dist = strtol(parse_ptr, &end_ptr, 10);
+        if (end_ptr == parse_ptr)
+            goto parse_error;
+        parse_ptr = end_ptr;
+    }
+    if (',' != *parse_ptr)
+        goto parse_error;
+    ++parse_ptr;
+
+    // status, bandwidth and the optional max_impl
+    tune->max_impl = 1;
+    if (2 > sscanf(parse_ptr, "%u,%lf,%u", &tune->status, &tune->bandwidth,
+                &tune->max_impl))
+        goto parse_error;
+    tune->status &= TTC_TUNE_STATUS_MASK;
+
+    return 0;
+
+parse_error:
+    free(tune->perm);
+    free(tune->size);
+    free(tune->loop_perm);
+    tune->perm = tune->size = tune->loop_perm = NULL;
+    return -1;
+}
@@ -1,3 +1,5 @@
+#define _GNU_SOURCE         // For dladdr
+
 #include "ttc_c_util.h"
 
 #include <stdlib.h>
@@ -9,10 +11,22 @@
 #include <errno.h>
 #include <unistd.h>
 #include <dlfcn.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
 #include <sys/wait.h>
 
 #include "tensor_util.h"
 #include "ttc_c.h"
+#include "ttc_c_tune.h"
+#include "ttc_c_model.h"
+#include "ttc_c_engine.h"
+
+
+
+/* ======== Internal variable ======== */
+
+static pthread_mutex_t ttc_gen_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 
 
@@ -105,6 +119,22 @@ ttc_gen_type_macro(
         );
 
 
+int32_t
+ttc_run_ttc_budget(
+        const ttc_opt_s     *options,
+        const ttc_param_s   *param,
+        char                header_file_name[]
+        );
+
+
+int32_t
+ttc_budget_keep(
+        const ttc_opt_s     *options,
+        const char          *header_file_name,
+        bool                restore
+        );
+
+
 
 /* ======== Function definition ======== */
 
@@ -128,59 +158,409 @@ ttc_plan(
 
     // Look up handler
     DEBUG_INFO_OUTPUT("Checking plan existence.");
-    ttc_plan_s *tail = handler->plans;
-    if (NULL != handler->plans) {
-        ttc_plan_s *lookup = handler->plans;
-        while (NULL != lookup) {
-            ttc_param_s *cmp = &lookup->param;
-            uint32_t dim = cmp->dim;
-
-            // Compare signature members
-            // Compare dim
-            if (param->dim == dim
-                // Compare datatype
-                && param->datatype == cmp->datatype
-                // Compare perm
-                && uint32cmp(param->perm, cmp->perm, dim)
-                // Compare size
-                && uint32cmp(param->size, cmp->size, dim)
-                // Compare loop_perm
-                && ((NULL == param->loop_perm && NULL == cmp->loop_perm)
-                    || (NULL != param->loop_perm && NULL != cmp->loop_perm
-                        && uint32cmp(param->loop_perm, cmp->loop_perm, dim)))
-                ) {
-                // If all match, return this plan
-                DEBUG_INFO_OUTPUT("Matched a existed plan.");
-                return lookup;
-            }
-
-            if (NULL == lookup->next)
-                tail = lookup;
-            lookup = lookup->next;
-        }
+    ttc_plan_s *lookup = ttc_lookup_plan(handler, param);
+    DEBUG_SET_NAMESPACE("ttc_plan");
+    if (NULL != lookup) {
+        DEBUG_INFO_OUTPUT("Matched a existed plan.");
+        return lookup;
     }
 
 
-    // Create new plan and attach it to the handler
-    DEBUG_INFO_OUTPUT("Creating a new plan.");
-    ttc_plan_s *new_plan = ttc_create_plan(&handler->options, param);
+    // Create new plan and attach it to the handler, a tuning record of the
+    // signature is preferred to the implementation search, and the
+    // performance model may choose a built-in engine instead of TTC
+    ttc_plan_s *new_plan = NULL;
+    ttc_tune_s *tune = ttc_tune_lookup(handler, param);
+    if (NULL != tune && TTC_ARCH_CUDA != handler->options.arch
+        && !ttc_engine_is_large(param)) {
+        DEBUG_INFO_OUTPUT("Creating a new plan with a tuning record.");
+        new_plan = ttc_tune_create_plan(&handler->options, param, tune);
+        DEBUG_SET_NAMESPACE("ttc_plan");
+    }
+    ttc_engine_e engine = NULL == new_plan
+        ? ttc_model_select(handler, param, NULL) : TTC_ENGINE_JIT;
     DEBUG_SET_NAMESPACE("ttc_plan");
+    if (TTC_ENGINE_JIT != engine) {
+        DEBUG_INFO_OUTPUT("Creating a new plan with a built-in engine.");
+        new_plan = ttc_alloc_plan(param);
+        if (NULL != new_plan)
+            new_plan->engine = engine;
+    }
+    else if (NULL == new_plan && TTC_ARCH_CUDA != handler->options.arch
+            && 0 == handler->options.grid
+            && NULL != (tune = ttc_tune_transfer(handler, param))) {
+        // The configuration of a near size is likely the best one as well,
+        // so only its first implementation is generated
+        DEBUG_INFO_OUTPUT("Creating a new plan with a near tuning record.");
+        ttc_tune_s near_tune = *tune;
+        near_tune.max_impl = 1;
+        new_plan = ttc_tune_create_plan(&handler->options, param, &near_tune);
+    }
+    DEBUG_SET_NAMESPACE("ttc_plan");
+    if (NULL == new_plan && 0 != handler->options.grid
+            && NULL != (new_plan = ttc_grid_share(handler, param)))
+        DEBUG_INFO_OUTPUT("Created a new plan with a shared tile kernel.");
+    DEBUG_SET_NAMESPACE("ttc_plan");
+    if (NULL == new_plan) {
+        // Forking threads costs more than moving a small tensor
+        DEBUG_INFO_OUTPUT("Creating a new plan.");
+        ttc_opt_s options = handler->options;
+        if (ttc_param_bytes(param) <= TTC_SMALL_BYTES)
+            options.num_threads = 1;
+        new_plan = ttc_create_plan(&options, param);
+    }
+    DEBUG_SET_NAMESPACE("ttc_plan");
+    if (NULL == new_plan && TTC_ARCH_CUDA != handler->options.arch
+            && param->dim <= TTC_ENGINE_MAX_DIM) {
+        // TTC or the compiler is unavailable, the built-in engines still
+        // produce a correct result on the host
+        DEBUG_WARN_OUTPUT("JIT failed, falling back to a built-in engine.");
+        new_plan = ttc_alloc_plan(param);
+        DEBUG_SET_NAMESPACE("ttc_plan");
+        if (NULL != new_plan)
+            new_plan->engine = ttc_engine_is_copy(&new_plan->param)
+                ? TTC_ENGINE_COPY
+                : ttc_engine_is_multipass(&new_plan->param)
+                ? TTC_ENGINE_MULTIPASS : TTC_ENGINE_GENERIC;
+    }
     if (NULL == new_plan) {
         DEBUG_ERR_OUTPUT("Cannot create a new plan.");
         return NULL;
     }
 
+    // A fixed blocking may suit the sizes badly, so the first calls of an
+    // automatic generic plan time it against the recursive kernel
+    if (TTC_ENGINE_AUTO == handler->options.engine
+        && TTC_ENGINE_GENERIC == new_plan->engine
+        && ttc_param_bytes(param) > TTC_SMALL_BYTES
+        && ttc_engine_is_blocked(param))
+        new_plan->num_probes = TTC_MODEL_PROBE_CALLS;
+
     // Attach new plan to the tail of exist plan in handler
     DEBUG_INFO_OUTPUT("Attaching the new plan to the handler.");
-    if (NULL == handler->plans)
-        handler->plans = new_plan;
-    else
-        tail->next = new_plan;
+    ttc_attach_plan(handler, new_plan);
 
     return new_plan;
 }
 
 
+ttc_plan_s *
+ttc_lookup_plan(
+        const ttc_handler_s *handler,
+        const ttc_param_s   *param
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_lookup_plan");
+    // Parameter check
+    if (NULL == handler) {
+        DEBUG_ERR_OUTPUT("handler is not initialized.");
+        return NULL;
+    }
+    if (NULL == param || NULL == param->perm || NULL == param->size) {
+        DEBUG_ERR_OUTPUT("param is not well initialized.");
+        return NULL;
+    }
+
+    ttc_plan_s *lookup = handler->plans;
+    while (NULL != lookup) {
+        ttc_param_s *cmp = &lookup->param;
+        uint32_t dim = cmp->dim;
+
+        // Compare signature members
+        // Compare dim
+        if (param->dim == dim
+            // Compare datatype
+            && param->datatype == cmp->datatype
+            // Compare perm
+            && uint32cmp(param->perm, cmp->perm, dim)
+            // Compare size
+            && uint32cmp(param->size, cmp->size, dim)
+            // Compare loop_perm
+            && ((NULL == param->loop_perm && NULL == cmp->loop_perm)
+                || (NULL != param->loop_perm && NULL != cmp->loop_perm
+                    && uint32cmp(param->loop_perm, cmp->loop_perm, dim)))
+            ) {
+            // If all match, return this plan
+            return lookup;
+        }
+
+        lookup = lookup->next;
+    }
+
+    return NULL;
+}
+
+
+void
+ttc_attach_plan(
+        ttc_handler_s   *handler,
+        ttc_plan_s      *plan
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_attach_plan");
+    // Parameter check
+    if (NULL == handler || NULL == plan)
+        return;
+
+    plan->next = NULL;
+    if (NULL == handler->plans) {
+        handler->plans = plan;
+        return;
+    }
+
+    ttc_plan_s *tail = handler->plans;
+    while (NULL != tail->next)
+        tail = tail->next;
+    tail->next = plan;
+}
+
+
+void
+ttc_detach_plan(
+        ttc_handler_s   *handler,
+        ttc_plan_s      *plan
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_detach_plan");
+    // Parameter check
+    if (NULL == handler || NULL == plan)
+        return;
+
+    ttc_plan_s **link = &handler->plans;
+    while (NULL != *link && plan != *link)
+        link = &(*link)->next;
+
+    if (NULL != *link) {
+        *link = plan->next;
+        plan->next = NULL;
+    }
+}
+
+
+ttc_plan_s *
+ttc_plan_variant(
+        const ttc_opt_s *options,
+        ttc_plan_s      *plan,
+        ttc_residency_e residency
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_plan_variant");
+    // Parameter check, only the kernels of TTC have variants
+    if (NULL == options || NULL == plan || TTC_ENGINE_JIT != plan->engine
+        || (TTC_RES_HOT != residency && TTC_RES_COLD != residency))
+        return plan;
+
+    ttc_plan_s **variant
+        = TTC_RES_HOT == residency ? &plan->hot_plan : &plan->cold_plan;
+    if (NULL != *variant)
+        return *variant;
+
+    // Hot: TTC measures with tensors in cache and avoids streaming stores.
+    // Cold: streaming stores bypass the cache for the output.
+    DEBUG_INFO_OUTPUT("Creating a variant of the plan.");
+    ttc_opt_s variant_options = *options;
+    variant_options.status &= ~(TTC_HOT_A | TTC_HOT_B | TTC_USE_STM_STORE);
+    variant_options.status |= TTC_RES_HOT == residency
+        ? TTC_HOT_A | TTC_HOT_B : TTC_USE_STM_STORE;
+
+    *variant = ttc_create_plan(&variant_options, &plan->param);
+    DEBUG_SET_NAMESPACE("ttc_plan_variant");
+    if (NULL == *variant) {
+        DEBUG_WARN_OUTPUT("Cannot create the variant, using the plan.");
+        return plan;
+    }
+
+    return *variant;
+}
+
+
+ttc_plan_s *
+ttc_plan_store(
+        const ttc_opt_s *options,
+        ttc_plan_s      *plan,
+        ttc_store_e     store
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_plan_store");
+    // Parameter check, only the kernels generated by TTC have variants, a
+    // registered kernel is used as it is
+    if (NULL == options || NULL == plan || TTC_ENGINE_JIT != plan->engine
+        || NULL == plan->dlhandler
+        || (TTC_STORE_CACHED != store && TTC_STORE_STREAM != store))
+        return plan;
+
+    // The status follows the kernel, which a re-tuning thread may replace
+    const bool stream = 0 != (__atomic_load_n(&plan->status,
+                __ATOMIC_RELAXED) & TTC_USE_STM_STORE);
+    if ((TTC_STORE_STREAM == store) == stream)
+        return plan;
+
+    // A re-tuning of the plan may have given it the stores of the variant
+    if (NULL != plan->store_plan)
+        return (TTC_STORE_STREAM == store) == (0 != (__atomic_load_n(
+                        &plan->store_plan->status, __ATOMIC_RELAXED)
+                    & TTC_USE_STM_STORE)) ? plan->store_plan : plan;
+
+    DEBUG_INFO_OUTPUT("Creating a store variant of the plan.");
+    ttc_opt_s variant_options = *options;
+    variant_options.status &= ~TTC_USE_STM_STORE;
+    if (!stream)
+        variant_options.status |= TTC_USE_STM_STORE;
+
+    plan->store_plan = ttc_create_plan(&variant_options, &plan->param);
+    DEBUG_SET_NAMESPACE("ttc_plan_store");
+    if (NULL == plan->store_plan) {
+        DEBUG_WARN_OUTPUT("Cannot create the variant, using the plan.");
+        return plan;
+    }
+
+    return plan->store_plan;
+}
+
+
+ttc_plan_s *
+ttc_plan_align(
+        const ttc_opt_s *options,
+        ttc_plan_s      *plan,
+        const void      *input,
+        const void      *result
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_plan_align");
+    // Parameter check, only the kernels generated by TTC have variants, a
+    // registered kernel is used as it is, the probe of a built-in plan may
+    // change its engine
+    if (NULL == options || NULL == plan
+        || TTC_ENGINE_JIT != __atomic_load_n(&plan->engine, __ATOMIC_RELAXED)
+        || NULL == plan->dlhandler || TTC_ARCH_CUDA == options->arch)
+        return plan;
+
+    // Every row of both tensors, and every tile of a grid plan, starts at a
+    // multiple of the vector width if the first one does
+    const ttc_param_s *param = &plan->param;
+    const uint64_t align = TTC_ARCH_AVX512 == options->arch
+        || TTC_ARCH_KNC == options->arch ? 64
+        : TTC_ARCH_POWER == options->arch ? 16 : 32;
+    const uint64_t in_size = ttc_type_size(param->datatype, false);
+    const uint64_t out_size = ttc_type_size(param->datatype, true);
+    const uint64_t row_a = NULL == param->lda ? param->size[0]
+        : (uint64_t)param->lda[0];
+    const uint64_t row_b = NULL == param->ldb ? param->size[param->perm[0]]
+        : (uint64_t)param->ldb[0];
+    bool aligned = 0 == (uintptr_t)input % align
+        && 0 == (uintptr_t)result % align
+        && (param->dim < 2 || (0 == row_a * in_size % align
+                && 0 == row_b * out_size % align));
+    if (NULL != plan->tile)
+        aligned = aligned && 0 == plan->tile[0] * in_size % align
+            && 0 == plan->tile[param->perm[0]] * out_size % align;
+
+    // The status follows the kernel, which a re-tuning thread may replace
+    const uint32_t status = __atomic_load_n(&plan->status, __ATOMIC_RELAXED);
+    if (aligned == (0 == (status & TTC_NO_ALIGN)))
+        return plan;
+    if (NULL != plan->align_plan)
+        return plan->align_plan;
+
+    // The other bits of the variant are the ones of the plan, e.g. of a
+    // residency or store variant
+    DEBUG_INFO_OUTPUT("Creating an alignment variant of the plan.");
+    ttc_opt_s variant_options = *options;
+    variant_options.status = status ^ TTC_NO_ALIGN;
+
+    plan->align_plan = ttc_create_plan(&variant_options, &plan->param);
+    DEBUG_SET_NAMESPACE("ttc_plan_align");
+    if (NULL != plan->align_plan)
+        return plan->align_plan;
+    if (aligned) {
+        DEBUG_WARN_OUTPUT("Cannot create the variant, using the plan.");
+        return plan;
+    }
+
+    // The aligned kernel faults on the unaligned call, a built-in engine
+    // is stored as the variant instead
+    if (param->dim > TTC_ENGINE_MAX_DIM) {
+        DEBUG_ERR_OUTPUT("Cannot create the variant.");
+        return NULL;
+    }
+    DEBUG_WARN_OUTPUT("Cannot create the variant, using a built-in engine.");
+    ttc_plan_s *builtin = ttc_alloc_plan(param);
+    DEBUG_SET_NAMESPACE("ttc_plan_align");
+    if (NULL == builtin) {
+        DEBUG_ERR_OUTPUT("Cannot create the built-in plan.");
+        return NULL;
+    }
+    builtin->engine = ttc_engine_is_copy(&builtin->param) ? TTC_ENGINE_COPY
+        : ttc_engine_is_multipass(&builtin->param)
+        ? TTC_ENGINE_MULTIPASS : TTC_ENGINE_GENERIC;
+    plan->align_plan = builtin;
+
+    return plan->align_plan;
+}
+
+
+void
+ttc_gen_lock(
+        ) {
+    pthread_mutex_lock(&ttc_gen_mutex);
+}
+
+
+void
+ttc_gen_unlock(
+        ) {
+    pthread_mutex_unlock(&ttc_gen_mutex);
+}
+
+
+uint32_t
+ttc_type_size(
+        ttc_datatype_e  datatype,
+        bool            output
+        ) {
+    switch (datatype) {
+        case TTC_TYPE_D:
+        case TTC_TYPE_C:
+            return 8;
+        case TTC_TYPE_Z:
+            return 16;
+        case TTC_TYPE_SD:
+            return output ? 8 : 4;
+        case TTC_TYPE_DS:
+            return output ? 4 : 8;
+        case TTC_TYPE_CZ:
+            return output ? 16 : 8;
+        case TTC_TYPE_ZC:
+            return output ? 8 : 16;
+        default:
+            return 4;
+    }
+}
+
+
+double
+ttc_param_bytes(
+        const ttc_param_s   *param
+        ) {
+    if (NULL == param || NULL == param->size)
+        return 0.0;
+
+    double elem = 1.0;
+    uint32_t idx;
+    for (idx = 0; idx < param->dim; ++idx)
+        elem *= param->size[idx];
+
+    // The output is read as well when beta is not zero
+    bool update;
+    if (TTC_TYPE_DEFAULT == param->datatype
+        || TTC_TYPE_S == param->datatype
+        || TTC_TYPE_C == param->datatype
+        || TTC_TYPE_DS == param->datatype
+        || TTC_TYPE_ZC == param->datatype
+       )
+        update = param->beta.s > 0;
+    else
+        update = param->beta.d > 0;
+
+    return elem * (ttc_type_size(param->datatype, false)
+            + ttc_type_size(param->datatype, true) * (update ? 2 : 1));
+}
+
+
 #define TTC_PLAN_NULL_CHECK(ptr, str)       \
     if (NULL == ptr) {                      \
         DEBUG_ERR_OUTPUT(str);              \
@@ -214,7 +594,131 @@ ttc_create_plan(
 
 
     // Create new plan
+    ttc_plan_s *new_plan = ttc_alloc_plan(param);
+    DEBUG_SET_NAMESPACE("ttc_create_plan");
+    if (NULL == new_plan) {
+        DEBUG_ERR_OUTPUT("Cannot allocate the new plan.");
+        return NULL;
+    }
+    new_plan->status = options->status;
+
+    // Odd sizes would push the whole kernel into its remainder code, so the
+    // kernel covers an aligned main body of the padded tensors. A grid plan
+    // runs a single-threaded kernel of a tile in parallel instead, its
+    // extents are the tile's so that TTC sees the same arguments whatever
+    // the size is.
+    ttc_opt_s body_options = *options;
+    ttc_param_s body = *param;
+    uint32_t body_size[param->dim], tile[param->dim];
+    int32_t body_lda[param->dim], body_ldb[param->dim];
+    if (TTC_ARCH_CUDA != options->arch && 0 != options->grid
+        && ttc_grid_tile(param, options->grid, tile, body_size)) {
+        DEBUG_INFO_OUTPUT("Tiling the tensor.");
+        uint32_t idx;
+        for (idx = 0; idx < param->dim; ++idx) {
+            body_lda[idx] = tile[idx];
+            body_ldb[idx] = tile[param->perm[idx]];
+        }
+        body_options.num_threads = 1;
+        body.size = tile;
+        body.lda = body_lda;
+        body.ldb = body_ldb;
+        TTC_PLAN_SET_ARRAY(new_plan->tile, tile, uint32_t,
+                "ttc_plan_s::tile");
+        TTC_PLAN_SET_ARRAY(new_plan->body_size, body_size, uint32_t,
+                "ttc_plan_s::body_size");
+    }
+    else if (TTC_ARCH_CUDA != options->arch
+            && ttc_body_size(param, body_size)) {
+        DEBUG_INFO_OUTPUT("Splitting a main body from the remainder.");
+        ttc_body_extents(param, body_lda, body_ldb);
+        body.size = body_size;
+        body.lda = body_lda;
+        body.ldb = body_ldb;
+        TTC_PLAN_SET_ARRAY(new_plan->body_size, body_size, uint32_t,
+                "ttc_plan_s::body_size");
+    }
+
+    // Here: Database support will be involved in the future.
+    //
+    //
+    // Initialize member: dlhandler
+    // The generated files are shared by all the plans of a signature, so only
+    // one plan is generated at a time.
+    ttc_gen_lock();
+
+    // Run TTC and locate header file
+    char seek_buf[TTC_GEN_BUF_SIZE];
+    DEBUG_INFO_OUTPUT("Running TTC.");
+    int32_t search_ret = 0 == options->time_budget
+        ? ttc_run_ttc(&body_options, &body, seek_buf, 0.0)
+        : ttc_run_ttc_budget(&body_options, &body, seek_buf);
+    if (0 != search_ret) {
+        DEBUG_SET_NAMESPACE("ttc_create_plan");
+        DEBUG_ERR_OUTPUT("TTC failed to generate a kernel.");
+        ttc_gen_unlock();
+        ttc_release_plan(new_plan);
+        return NULL;
+    }
+    DEBUG_SET_NAMESPACE("ttc_create_plan");
+
+    // Generating and loading shared library
+    DEBUG_INFO_OUTPUT("Generating code.");
+    char target_prefix[TTC_GEN_BUF_SIZE];
+    char target_suffix[TTC_GEN_BUF_SIZE];
+    int ret
+        = ttc_gen_code(&body_options, &body, seek_buf, target_prefix,
+                target_suffix);
+    DEBUG_SET_NAMESPACE("ttc_create_plan");
+    if (0 != ret) {
+        DEBUG_ERR_OUTPUT("Cannot generate code.");
+        ttc_gen_unlock();
+        ttc_release_plan(new_plan);
+        return NULL;
+    }
+
+    DEBUG_INFO_OUTPUT("Compiling code.");
+    new_plan->dlhandler
+        = ttc_gen_lib(&body_options, target_prefix, target_suffix);
+    DEBUG_SET_NAMESPACE("ttc_create_plan");
+    ttc_gen_unlock();
+    if(NULL == new_plan->dlhandler) {
+        DEBUG_ERR_OUTPUT("Cannot generate shared library.");
+        ttc_release_plan(new_plan);
+        return NULL;
+    }
+
+    if (TTC_ARCH_CUDA == options->arch) {
+        DEBUG_INFO_OUTPUT("Locating function symbol (CUDA): " TTC_FUNC_SYMBOL);
+        new_plan->fn_cuda = dlsym(new_plan->dlhandler, TTC_FUNC_SYMBOL);
+        TTC_PLAN_NULL_CHECK(new_plan->fn_cuda, "Cannot locate symbol: "
+                TTC_FUNC_SYMBOL);
+    }
+    else {
+        DEBUG_INFO_OUTPUT("Locating function symbol: " TTC_FUNC_SYMBOL);
+        new_plan->fn = dlsym(new_plan->dlhandler, TTC_FUNC_SYMBOL);
+        TTC_PLAN_NULL_CHECK(new_plan->fn, "Cannot locate symbol: "
+                TTC_FUNC_SYMBOL);
+    }
+
+    new_plan->next = NULL;
+
+    return new_plan;
+}
+
+
+ttc_plan_s *
+ttc_alloc_plan(
+        const ttc_param_s   *param
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_alloc_plan");
     DEBUG_INFO_OUTPUT("Allocating memory for the new plan.");
+    // Parameter check
+    if (NULL == param || NULL == param->perm || NULL == param->size) {
+        DEBUG_ERR_OUTPUT("param is not well initialized.");
+        return NULL;
+    }
+
     ttc_plan_s *new_plan = (ttc_plan_s *)malloc(sizeof(ttc_plan_s));
     if (NULL == new_plan) {
         DEBUG_ERR_OUTPUT(strerror(errno));
@@ -231,10 +735,27 @@ ttc_create_plan(
     new_plan->dlhandler         = NULL;
     new_plan->fn                = NULL;
     new_plan->fn_cuda           = NULL;
+    new_plan->num_calls         = 0;
+    new_plan->exec_time         = 0.0;
+    new_plan->retune            = NULL;
+    new_plan->hot_plan          = NULL;
+    new_plan->cold_plan         = NULL;
+    new_plan->store_plan        = NULL;
+    new_plan->align_plan        = NULL;
+    new_plan->status            = 0;
+    new_plan->engine            = TTC_ENGINE_JIT;
+    new_plan->num_probes        = 0;
+    new_plan->probe_time[0]     = 0.0;
+    new_plan->probe_time[1]     = 0.0;
+    new_plan->scratch           = NULL;
+    new_plan->body_size         = NULL;
+    new_plan->tile              = NULL;
     new_plan->next              = NULL;
 
     DEBUG_INFO_OUTPUT("Setting ttc_plan_s::param::datatype.");
     new_plan->param.datatype = param->datatype;
+    new_plan->param.residency = TTC_RES_NONE;
+    new_plan->param.store = TTC_STORE_AUTO;
 
     // Initialize member: param.alpha
     if (TTC_TYPE_DEFAULT == param->datatype
@@ -298,26 +819,49 @@ ttc_create_plan(
     DEBUG_INFO_OUTPUT("Setting ttc_plan_s::param::dim.");
     new_plan->param.dim = param->dim;
 
-    // Here: Database support will be involved in the future.
-    //
-    //
-    // Initialize member: dlhandler
+    return new_plan;
+}
+
+
+int32_t
+ttc_run_ttc(
+        const ttc_opt_s     *options,
+        const ttc_param_s   *param,
+        char                header_file_name[],
+        double              deadline
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_run_ttc");
+    DEBUG_INFO_OUTPUT("Running TTC.");
+    // Parameter check
+    if (NULL == options) {
+        DEBUG_ERR_OUTPUT("options is not well initialized.");
+        return -1;
+    }
+    if (NULL == param || NULL == param->perm || NULL == param->size) {
+        DEBUG_ERR_OUTPUT("param is not well initialized.");
+        return -1;
+    }
+    if (NULL == header_file_name) {
+        DEBUG_ERR_OUTPUT("header_file_name is not initialized.");
+        return -1;
+    }
+
     // Create ttc process
     DEBUG_INFO_OUTPUT("Parent process: Creating pipe.");
     int32_t ttc_pipe[2];
     if (0 != pipe(ttc_pipe)) {
         DEBUG_ERR_OUTPUT("Parent process: "
                 "Cannot create pipe.");
-        ttc_release_plan(new_plan);
-        return NULL;
+        return -1;
     }
 
     DEBUG_INFO_OUTPUT("Parent process: Forking.");
     int32_t pid = fork();
     if (-1 == pid) {
         DEBUG_ERR_OUTPUT("Parent process: Fork failed.");
-        ttc_release_plan(new_plan);
-        return NULL;
+        close(ttc_pipe[TTC_PIPE_RD]);
+        close(ttc_pipe[TTC_PIPE_WR]);
+        return -1;
     }
     else if (0 == pid) {
         DEBUG_INFO_OUTPUT("Child process: Child starts.");
@@ -340,6 +884,11 @@ ttc_create_plan(
 #endif
 
 
+        // Use a new process group, so that the compilers started by TTC
+        // can be stopped together with it.
+        if (0.0 != deadline)
+            setpgid(0, 0);
+
         // Redirect standard output
         close(ttc_pipe[TTC_PIPE_RD]);
         if (-1 == dup2(ttc_pipe[TTC_PIPE_WR], STDOUT_FILENO)) {
@@ -366,80 +915,196 @@ ttc_create_plan(
     DEBUG_INFO_OUTPUT("Parent process: "
             "Waiting for child process.");
     int32_t ttc_result;
-    waitpid(pid, &ttc_result, 0);
+    if (0.0 == deadline)
+        waitpid(pid, &ttc_result, 0);
+    else {
+        struct timespec poll_interval = { 0, TTC_POLL_INTERVAL_NS };
+        while (0 == waitpid(pid, &ttc_result, WNOHANG)) {
+            if (get_wtime() > deadline) {
+                DEBUG_WARN_OUTPUT("Parent process: "
+                        "Time budget exceeded, stopping TTC.");
+                kill(-pid, SIGKILL);
+                kill(pid, SIGKILL);
+                waitpid(pid, &ttc_result, 0);
+                close(ttc_pipe[TTC_PIPE_RD]);
+                return TTC_ERR_TIMEOUT;
+            }
+            nanosleep(&poll_interval, NULL);
+        }
+    }
     DEBUG_INFO_OUTPUT("Parent process: "
             "Checking result of child process.");
     if (!WIFEXITED(ttc_result)) {
         DEBUG_ERR_OUTPUT("TTC exits abnormally.");
-        ttc_release_plan(new_plan);
-        return NULL;
+        close(ttc_pipe[TTC_PIPE_RD]);
+        return -1;
     }
     else if (0 != WEXITSTATUS(ttc_result)) {
         DEBUG_ERR_OUTPUT("TTC exit code indicates error.");
-        ttc_release_plan(new_plan);
-        return NULL;
+        close(ttc_pipe[TTC_PIPE_RD]);
+        return -1;
     }
 
     // Locate header file
-    char seek_buf[TTC_GEN_BUF_SIZE];
     DEBUG_INFO_OUTPUT("Locating the header file name.");
-    if (0 != ttc_locate_header(ttc_pipe[TTC_PIPE_RD], seek_buf)) {
+    if (0 != ttc_locate_header(ttc_pipe[TTC_PIPE_RD], header_file_name)) {
         DEBUG_ERR_OUTPUT("Cannot locate header file name.");
-        ttc_release_plan(new_plan);
-        return NULL;
+        close(ttc_pipe[TTC_PIPE_RD]);
+        return -1;
     }
 
     // Close input pipe
     DEBUG_INFO_OUTPUT("Shutting down input pipe.");
     close(ttc_pipe[TTC_PIPE_RD]);
 
-    // Generating and loading shared library
-    DEBUG_INFO_OUTPUT("Generating code.");
-    DEBUG_INFO_OUTPUT("Change directory to " TTC_DIR_GEN_CODE);
-    chdir(TTC_DIR_GEN_CODE);
+    return 0;
+}
 
-    char target_prefix[TTC_GEN_BUF_SIZE];
-    char target_suffix[TTC_GEN_BUF_SIZE];
-    int ret
-        = ttc_gen_code(options, param, seek_buf, target_prefix, target_suffix);
-    DEBUG_SET_NAMESPACE("ttc_create_plan");
-    if (0 != ret) {
-        DEBUG_ERR_OUTPUT("Cannot generate code.");
-        DEBUG_INFO_OUTPUT("Change directory to " TTC_DIR_BACK_GEN);
-        chdir(TTC_DIR_BACK_GEN);
-        ttc_release_plan(new_plan);
-        return NULL;
-    }
 
-    DEBUG_INFO_OUTPUT("Compiling code.");
-    new_plan->dlhandler = ttc_gen_lib(options, target_prefix, target_suffix);
-    DEBUG_SET_NAMESPACE("ttc_create_plan");
-    if(NULL == new_plan->dlhandler) {
-        DEBUG_ERR_OUTPUT("Cannot generate shared library.");
-        DEBUG_INFO_OUTPUT("Change directory to " TTC_DIR_BACK_GEN);
-        chdir(TTC_DIR_BACK_GEN);
-        ttc_release_plan(new_plan);
-        return NULL;
+int32_t
+ttc_run_ttc_budget(
+        const ttc_opt_s     *options,
+        const ttc_param_s   *param,
+        char                header_file_name[]
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_run_ttc_budget");
+    DEBUG_INFO_OUTPUT("Running TTC within the time budget.");
+
+    double start = get_wtime();
+    double deadline = start + options->time_budget * 1e-3;
+
+    // TTC ranks the candidates (loop orders, blockings and prefetch
+    // distances) with its performance model, --maxImplementations=<n> only
+    // measures the first n of them. Growing n stage by stage spends the
+    // budget on the most promising candidates first.
+    ttc_opt_s stage_options = *options;
+    char stage_buf[TTC_GEN_BUF_SIZE];
+    uint32_t stage_impl = 1;
+    double stage_time = 0.0;
+    bool found = false, kept = false;
+
+    bool last_stage = false;
+    while (!last_stage) {
+        // The last stage measures max_impl candidates, or all of them (0) if
+        // max_impl is not set.
+        stage_options.max_impl = stage_impl;
+        if (0 != options->max_impl && stage_impl >= options->max_impl) {
+            stage_options.max_impl = options->max_impl;
+            last_stage = true;
+        }
+        else if (0 == options->max_impl && stage_impl > TTC_BUDGET_MAX_STAGE) {
+            stage_options.max_impl = 0;
+            last_stage = true;
+        }
+
+        // The next stage measures about TTC_BUDGET_GROWTH times more
+        // candidates, don't start it if it cannot finish in time.
+        double stage_start = get_wtime();
+        if (found
+            && stage_start + stage_time * TTC_BUDGET_GROWTH > deadline) {
+            DEBUG_INFO_OUTPUT("Next stage cannot finish in time.");
+            break;
+        }
+
+        int32_t ret = ttc_run_ttc(&stage_options, param, stage_buf,
+                found ? deadline : 0.0);
+        DEBUG_SET_NAMESPACE("ttc_run_ttc_budget");
+        if (0 != ret) {
+            if (TTC_ERR_TIMEOUT != ret)
+                DEBUG_ERR_OUTPUT("TTC failed in a search stage.");
+            break;
+        }
+
+        strcpy(header_file_name, stage_buf);
+        found = true;
+        stage_time = get_wtime() - stage_start;
+        stage_impl *= TTC_BUDGET_GROWTH;
+
+        // The next stage writes to the same files, and may be killed while
+        // writing them
+        kept = 0 == ttc_budget_keep(options, header_file_name, false);
+        DEBUG_SET_NAMESPACE("ttc_run_ttc_budget");
+        if (!kept) {
+            DEBUG_WARN_OUTPUT("Cannot keep the files of the winner.");
+            break;
+        }
     }
-    DEBUG_INFO_OUTPUT("Change directory to " TTC_DIR_BACK_GEN);
-    chdir(TTC_DIR_BACK_GEN);
 
-    if (TTC_ARCH_CUDA == options->arch) {
-        DEBUG_INFO_OUTPUT("Locating function symbol (CUDA): " TTC_FUNC_SYMBOL);
-        new_plan->fn_cuda = dlsym(new_plan->dlhandler, TTC_FUNC_SYMBOL);
-        TTC_PLAN_NULL_CHECK(new_plan->fn_cuda, "Cannot locate symbol: "
-                TTC_FUNC_SYMBOL);
+    if (kept && 0 != ttc_budget_keep(options, header_file_name, true)) {
+        DEBUG_SET_NAMESPACE("ttc_run_ttc_budget");
+        DEBUG_ERR_OUTPUT("Cannot restore the files of the winner.");
+        return -1;
     }
-    else {
-        DEBUG_INFO_OUTPUT("Locating function symbol: " TTC_FUNC_SYMBOL);
-        new_plan->fn = dlsym(new_plan->dlhandler, TTC_FUNC_SYMBOL);
-        TTC_PLAN_NULL_CHECK(new_plan->fn, "Cannot locate symbol: "
-                TTC_FUNC_SYMBOL);
+
+    return found ? 0 : -1;
+}
+
+
+/**
+ * @brief Function for keeping the files TTC generated in a search stage.
+ *
+ * @details The header (and for CUDA the source) of the winner are copied
+ * next to it with the suffix TTC_BUDGET_KEEP, and the copies are moved back
+ * when `restore` is set.
+ *
+ * @return The status, 0 if succeed, -1 if a file cannot be copied or moved.
+ *
+ */
+int32_t
+ttc_budget_keep(
+        const ttc_opt_s     *options,
+        const char          *header_file_name,
+        bool                restore
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_budget_keep");
+    const size_t name_len = strlen(header_file_name);
+    if (name_len < 2) {
+        DEBUG_ERR_OUTPUT("The header file name is not valid.");
+        return -1;
     }
 
-    new_plan->next = NULL;
+    const char *suffixes[2] = { "h", "cu" };
+    const uint32_t num_files = TTC_ARCH_CUDA == options->arch ? 2 : 1;
+    uint32_t idx;
+    for (idx = 0; idx < num_files; ++idx) {
+        char file_name[TTC_GEN_BUF_SIZE], kept_name[TTC_GEN_BUF_SIZE];
+        snprintf(file_name, sizeof(file_name), TTC_DIR_GEN_CODE "%.*s%s",
+                (int32_t)(name_len - 1), header_file_name, suffixes[idx]);
+        int32_t length = snprintf(kept_name, sizeof(kept_name),
+                "%s" TTC_BUDGET_KEEP, file_name);
+        if (length < 0 || (size_t)length >= sizeof(kept_name)) {
+            DEBUG_ERR_OUTPUT("The header file name is too long.");
+            return -1;
+        }
 
-    return new_plan;
+        if (restore) {
+            if (0 != rename(kept_name, file_name)) {
+                DEBUG_ERR_OUTPUT(strerror(errno));
+                return -1;
+            }
+            continue;
+        }
+
+        FILE *source = fopen(file_name, "rb");
+        FILE *target = NULL == source ? NULL : fopen(kept_name, "wb");
+        char copy_buf[TTC_GEN_BUF_SIZE];
+        size_t num_read = 0;
+        bool copied = NULL != target;
+        while (copied
+            && 0 != (num_read = fread(copy_buf, 1, sizeof(copy_buf), source)))
+            copied = num_read == fwrite(copy_buf, 1, num_read, target);
+        copied = copied && !ferror(source);
+        if (NULL != source)
+            fclose(source);
+        if (NULL != target && 0 != fclose(target))
+            copied = false;
+        if (!copied) {
+            DEBUG_ERR_OUTPUT("Cannot copy a generated file.");
+            return -1;
+        }
+    }
+
+    return 0;
 }
 
 
@@ -454,6 +1119,25 @@ ttc_release_plan(
         return 0;
 
     // Release resource
+    // Release member: retune, it may still be using the plan
+    DEBUG_INFO_OUTPUT("Releasing ttc_plan_s::retune.");
+    ttc_retune_release(plan->retune);
+    DEBUG_SET_NAMESPACE("ttc_release_plan");
+
+    // Release member: hot_plan, cold_plan, store_plan and align_plan
+    DEBUG_INFO_OUTPUT("Releasing ttc_plan_s variants.");
+    ttc_release_plan(plan->hot_plan);
+    ttc_release_plan(plan->cold_plan);
+    ttc_release_plan(plan->store_plan);
+    ttc_release_plan(plan->align_plan);
+    DEBUG_SET_NAMESPACE("ttc_release_plan");
+
+    // Release member: scratch
+    DEBUG_INFO_OUTPUT("Releasing ttc_plan_s::scratch.");
+    free(plan->scratch);
+    free(plan->body_size);
+    free(plan->tile);
+
     // Release member: param
     DEBUG_INFO_OUTPUT("Releasing ttc_plan_s::param.");
     free(plan->param.lda);
@@ -478,14 +1162,19 @@ ttc_release_plan(
 
 int32_t
 ttc_exec_plan(
-        const ttc_plan_s    *plan,
-        const void          *input,
-        void                *result
+        ttc_plan_s  *plan,
+        const void  *input,
+        void        *result,
+        ttc_store_e store
         ) {
     DEBUG_SET_NAMESPACE("ttc_exec_plan");
     DEBUG_INFO_OUTPUT("Executing plan.");
-    // Parameter check
-    if (NULL == plan || NULL == plan->fn) {
+    // Parameter check, fn may be replaced by a re-tuning thread, the engine
+    // by a probe
+    __typeof__(plan->fn) fn
+        = NULL == plan ? NULL : __atomic_load_n(&plan->fn, __ATOMIC_ACQUIRE);
+    if (NULL == plan || (NULL == fn && TTC_ENGINE_JIT
+                == __atomic_load_n(&plan->engine, __ATOMIC_RELAXED))) {
         DEBUG_ERR_OUTPUT("plan is not well initialized.");
         return -1;
     }
@@ -498,12 +1187,332 @@ ttc_exec_plan(
         return -1;
     }
 
+    // A probing plan alternates between the blocked and the recursive
+    // kernel, starting with the blocked one. Concurrent calls may run the
+    // same kernel, every finished call counts as a probe.
+    ttc_engine_e engine = __atomic_load_n(&plan->engine, __ATOMIC_ACQUIRE);
+    const uint32_t probe = __atomic_load_n(&plan->num_probes,
+            __ATOMIC_ACQUIRE);
+    if (0 != probe)
+        engine = 1 == probe % 2 ? TTC_ENGINE_RECURSIVE : TTC_ENGINE_GENERIC;
+
+    // The built-in engines choose their stores per call
+    ttc_param_s exec_param = plan->param;
+    exec_param.store = store;
+
     // Execute plan
-    DEBUG_INFO_OUTPUT("Calling ttc_plan_s::fn.");
-    plan->fn(input, result, &plan->param.alpha, &plan->param.beta,
-            plan->param.lda, plan->param.ldb);
+    int32_t ret = 0;
+    double start = get_wtime();
+    if (TTC_ENGINE_GENERIC == engine) {
+        DEBUG_INFO_OUTPUT("Calling the generic engine.");
+        ret = ttc_engine_generic(&exec_param, input, result);
+    }
+    else if (TTC_ENGINE_RECURSIVE == engine) {
+        DEBUG_INFO_OUTPUT("Calling the recursive engine.");
+        ret = ttc_engine_recursive(&exec_param, input, result);
+    }
+    else if (TTC_ENGINE_MULTIPASS == engine) {
+        // The call takes the scratch tensor of the plan, or allocates its
+        // own while another call holds it, and hands it back for the next
+        // calls
+        DEBUG_INFO_OUTPUT("Calling the multi-pass engine.");
+        void *scratch = __atomic_exchange_n(&plan->scratch, NULL,
+                __ATOMIC_ACQUIRE);
+        if (NULL == scratch)
+            scratch = malloc(ttc_engine_scratch(&plan->param));
+        if (NULL == scratch) {
+            DEBUG_WARN_OUTPUT("Cannot allocate the scratch, single pass.");
+            ret = ttc_engine_generic(&exec_param, input, result);
+        }
+        else {
+            ret = ttc_engine_multipass(&exec_param, scratch, input, result);
+            void *empty = NULL;
+            if (!__atomic_compare_exchange_n(&plan->scratch, &empty,
+                        scratch, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+                free(scratch);
+        }
+    }
+    else if (TTC_ENGINE_COPY == engine) {
+        DEBUG_INFO_OUTPUT("Calling the copy engine.");
+        ret = ttc_engine_copy(&exec_param, input, result);
+    }
+    else if (NULL != plan->body_size) {
+        DEBUG_INFO_OUTPUT("Calling ttc_plan_s::fn on the main body.");
+        ret = ttc_exec_body(plan, input, result);
+    }
+    else {
+        DEBUG_INFO_OUTPUT("Calling ttc_plan_s::fn.");
+        fn(input, result, &plan->param.alpha, &plan->param.beta,
+                plan->param.lda, plan->param.ldb);
+    }
+    // The statistics are shared by the calls of all the threads
+    double elapsed = get_wtime() - start, total;
+    __atomic_load(&plan->exec_time, &total, __ATOMIC_RELAXED);
+    double sum = total + elapsed;
+    while (!__atomic_compare_exchange(&plan->exec_time, &total, &sum, true,
+                __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        sum = total + elapsed;
+    __atomic_add_fetch(&plan->num_calls, 1, __ATOMIC_RELAXED);
+
+    // The time is recorded before the probe is counted, so that the call
+    // counting the last probe sees the times of all the counted ones
+    if (0 != probe) {
+        double *best = &plan->probe_time[TTC_ENGINE_RECURSIVE == engine];
+        double seen;
+        __atomic_load(best, &seen, __ATOMIC_ACQUIRE);
+        while ((0.0 == seen || elapsed < seen)
+            && !__atomic_compare_exchange(best, &seen, &elapsed, true,
+                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+        uint32_t left = __atomic_load_n(&plan->num_probes, __ATOMIC_RELAXED);
+        while (0 != left
+            && !__atomic_compare_exchange_n(&plan->num_probes, &left,
+                left - 1, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+        if (1 == left) {
+            double time[2];
+            __atomic_load(&plan->probe_time[0], &time[0], __ATOMIC_ACQUIRE);
+            __atomic_load(&plan->probe_time[1], &time[1], __ATOMIC_ACQUIRE);
+            engine = time[1] < time[0] ? TTC_ENGINE_RECURSIVE
+                : TTC_ENGINE_GENERIC;
+            __atomic_store_n(&plan->engine, engine, __ATOMIC_RELEASE);
+            DEBUG_INFO_OUTPUT(TTC_ENGINE_RECURSIVE == engine
+                    ? "Probe chose the recursive engine."
+                    : "Probe chose the generic engine.");
+        }
+    }
 
-    return 0;
+    return ret;
+}
+
+
+bool
+ttc_body_size(
+        const ttc_param_s   *param,
+        uint32_t            *size
+        ) {
+    if (NULL == param || NULL == param->perm || NULL == param->size
+        || param->dim < 2 || param->dim > TTC_ENGINE_MAX_DIM
+        || 0 == param->perm[0] || param->perm[0] >= param->dim)
+        return false;
+
+    uint32_t elem_size = ttc_type_size(param->datatype, false);
+    if (ttc_type_size(param->datatype, true) > elem_size)
+        elem_size = ttc_type_size(param->datatype, true);
+    const uint32_t align = TTC_BODY_BYTES / elem_size;
+    const uint32_t perm = param->perm[0];
+    memcpy(size, param->size, sizeof(uint32_t) * param->dim);
+    size[0] = size[0] / align * align;
+    size[perm] = size[perm] / align * align;
+
+    return 0 != size[0] && 0 != size[perm]
+        && (size[0] != param->size[0] || size[perm] != param->size[perm]);
+}
+
+
+bool
+ttc_grid_tile(
+        const ttc_param_s   *param,
+        uint32_t            edge,
+        uint32_t            *tile,
+        uint32_t            *body
+        ) {
+    if (NULL == param || NULL == param->perm || NULL == param->size
+        || 0 == edge || param->dim < 2 || param->dim > TTC_ENGINE_MAX_DIM
+        || param->perm[0] >= param->dim)
+        return false;
+
+    // The transposed plane comes first, the other dimensions fill the rest
+    uint32_t order[param->dim];
+    uint32_t num = 0, idx;
+    order[num++] = 0;
+    if (0 != param->perm[0])
+        order[num++] = param->perm[0];
+    for (idx = 1; idx < param->dim; ++idx)
+        if (param->perm[0] != idx)
+            order[num++] = idx;
+
+    uint64_t elems = 1;
+    for (idx = 0; idx < param->dim; ++idx) {
+        const uint32_t dim_idx = order[idx];
+        uint64_t span = idx < 2 ? edge : TTC_GRID_ELEMS / elems;
+        span = span > edge ? edge : span < 1 ? 1 : span;
+        uint32_t extent = (uint32_t)span;
+        if (param->size[dim_idx] < span)
+            for (extent = 1; extent * 2 <= param->size[dim_idx]; )
+                extent *= 2;
+        tile[dim_idx] = extent;
+        body[dim_idx] = param->size[dim_idx] / extent * extent;
+        elems *= extent;
+    }
+
+    return true;
+}
+
+
+ttc_plan_s *
+ttc_grid_share(
+        const ttc_handler_s *handler,
+        const ttc_param_s   *param
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_grid_share");
+    // Parameter check
+    if (NULL == handler || NULL == param || NULL == param->perm
+        || NULL == param->size || TTC_ARCH_CUDA == handler->options.arch)
+        return NULL;
+
+    uint32_t tile[param->dim], body_size[param->dim];
+    if (!ttc_grid_tile(param, handler->options.grid, tile, body_size))
+        return NULL;
+
+    // A kernel generated with beta reads the output, one without ignores it,
+    // the plans clamp a negative beta to 0
+    bool single = TTC_TYPE_DEFAULT == param->datatype
+        || TTC_TYPE_S == param->datatype || TTC_TYPE_C == param->datatype
+        || TTC_TYPE_DS == param->datatype || TTC_TYPE_ZC == param->datatype;
+    bool update = single ? param->beta.s > 0 : param->beta.d > 0;
+
+    const ttc_plan_s *cmp = handler->plans;
+    for (; NULL != cmp; cmp = cmp->next) {
+        if (TTC_ENGINE_JIT == cmp->engine && NULL != cmp->tile
+            && param->dim == cmp->param.dim
+            && param->datatype == cmp->param.datatype
+            && update == (single ? cmp->param.beta.s > 0
+                : cmp->param.beta.d > 0)
+            && uint32cmp(param->perm, cmp->param.perm, param->dim)
+            && uint32cmp(tile, cmp->tile, param->dim)
+            && ((NULL == param->loop_perm && NULL == cmp->param.loop_perm)
+                || (NULL != param->loop_perm && NULL != cmp->param.loop_perm
+                    && uint32cmp(param->loop_perm, cmp->param.loop_perm,
+                        param->dim))))
+            break;
+    }
+    Dl_info info;
+    if (NULL == cmp || 0 == dladdr((void *)cmp->fn, &info))
+        return NULL;
+
+    DEBUG_INFO_OUTPUT("Sharing the tile kernel of a plan.");
+    ttc_plan_s *new_plan = ttc_alloc_plan(param);
+    DEBUG_SET_NAMESPACE("ttc_grid_share");
+    if (NULL == new_plan)
+        return NULL;
+    TTC_PLAN_SET_ARRAY(new_plan->tile, tile, uint32_t, "ttc_plan_s::tile");
+    TTC_PLAN_SET_ARRAY(new_plan->body_size, body_size, uint32_t,
+            "ttc_plan_s::body_size");
+    new_plan->status = cmp->status;
+
+    // Another reference to the library, so that the kernel outlives the plan
+    // it was generated for. The file is removed, but the path still names
+    // the loaded library.
+    new_plan->dlhandler = dlopen(info.dli_fname, RTLD_NOW);
+    TTC_PLAN_NULL_CHECK(new_plan->dlhandler, dlerror());
+    new_plan->fn = dlsym(new_plan->dlhandler, TTC_FUNC_SYMBOL);
+    TTC_PLAN_NULL_CHECK(new_plan->fn, "Cannot locate symbol: "
+            TTC_FUNC_SYMBOL);
+
+    return new_plan;
+}
+
+
+void
+ttc_body_extents(
+        const ttc_param_s   *param,
+        int32_t             *lda,
+        int32_t             *ldb
+        ) {
+    uint32_t idx;
+    for (idx = 0; idx < param->dim; ++idx) {
+        lda[idx] = NULL == param->lda ? (int32_t)param->size[idx]
+            : param->lda[idx];
+        ldb[idx] = NULL == param->ldb
+            ? (int32_t)param->size[param->perm[idx]] : param->ldb[idx];
+    }
+}
+
+
+int32_t
+ttc_exec_body(
+        const ttc_plan_s    *plan,
+        const void          *input,
+        void                *result
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_exec_body");
+    const ttc_param_s *param = &plan->param;
+    const uint32_t *body = plan->body_size;
+    int32_t lda[param->dim], ldb[param->dim];
+    ttc_body_extents(param, lda, ldb);
+    __typeof__(plan->fn) fn = __atomic_load_n(&plan->fn, __ATOMIC_ACQUIRE);
+
+    // Strides of the input dimensions in both tensors
+    uint64_t stride_a[param->dim], stride_b[param->dim];
+    uint64_t stride = 1;
+    uint32_t idx;
+    for (idx = 0; idx < param->dim; ++idx) {
+        stride_a[idx] = stride;
+        stride *= lda[idx];
+    }
+    for (idx = 0, stride = 1; idx < param->dim; ++idx) {
+        stride_b[param->perm[idx]] = stride;
+        stride *= ldb[idx];
+    }
+    const size_t in_size = ttc_type_size(param->datatype, false);
+    const size_t out_size = ttc_type_size(param->datatype, true);
+
+    if (NULL == plan->tile)
+        fn(input, result, &param->alpha, &param->beta, lda, ldb);
+    else {
+        DEBUG_INFO_OUTPUT("Transposing the body tile by tile.");
+        const uint32_t *tile = plan->tile;
+        uint64_t num_tiles = 1;
+        for (idx = 0; idx < param->dim; ++idx)
+            num_tiles *= body[idx] / tile[idx];
+
+        // Neighbouring tiles stay in the same cache domain
+        int32_t domains[TTC_ENGINE_MAX_TEAM];
+        _Pragma("omp parallel if(num_tiles > 1)")
+        {
+            int64_t pos, end;
+            ttc_engine_share((int64_t)num_tiles, domains, &pos, &end);
+            for (; pos < end; ++pos) {
+                uint64_t rest = pos, off_a = 0, off_b = 0;
+                uint32_t dim_idx;
+                for (dim_idx = 0; dim_idx < param->dim; ++dim_idx) {
+                    const uint64_t count = body[dim_idx] / tile[dim_idx];
+                    const uint64_t start = rest % count * tile[dim_idx];
+                    rest /= count;
+                    off_a += start * stride_a[dim_idx];
+                    off_b += start * stride_b[dim_idx];
+                }
+                fn((const char *)input + off_a * in_size,
+                        (char *)result + off_b * out_size, &param->alpha,
+                        &param->beta, lda, ldb);
+            }
+        }
+    }
+
+    // The slabs are sub-tensors of the same extents, the one of dimension d
+    // starts after the body along d and stays within it along the
+    // dimensions before d
+    uint32_t size[param->dim];
+    memcpy(size, param->size, sizeof(uint32_t) * param->dim);
+    ttc_param_s slab = *param;
+    slab.size = size;
+    slab.lda = lda;
+    slab.ldb = ldb;
+    slab.loop_perm = NULL;
+
+    int32_t ret = 0;
+    for (idx = 0; 0 == ret && idx < param->dim; ++idx) {
+        if (body[idx] < param->size[idx]) {
+            DEBUG_INFO_OUTPUT("Transposing a remainder slab.");
+            size[idx] = param->size[idx] - body[idx];
+            ret = ttc_engine_generic(&slab,
+                    (const char *)input + body[idx] * stride_a[idx] * in_size,
+                    (char *)result + body[idx] * stride_b[idx] * out_size);
+        }
+        size[idx] = body[idx];
+    }
+
+    return ret;
 }
 
 
@@ -531,9 +1540,14 @@ ttc_exec_plan_cuda(
 
     // Execute plan
     DEBUG_INFO_OUTPUT("Calling ttc_plan_s::fn_cuda.");
-    int32_t total_size = 1;
-    int32_t idx = plan->param.dim - 1;
-    for (; idx >= 0; total_size *= plan->param.size[idx], --idx);
+    // The wrapper copies as many elements in and out, the larger tensor
+    // bounds both
+    const ttc_param_s *param = &plan->param;
+    const size_t elem_a = ttc_engine_extent(param, false)
+        / ttc_type_size(param->datatype, false);
+    const size_t elem_b = ttc_engine_extent(param, true)
+        / ttc_type_size(param->datatype, true);
+    const int64_t total_size = (int64_t)(elem_a > elem_b ? elem_a : elem_b);
     plan->fn_cuda(input, result, &plan->param.alpha, &plan->param.beta,
             plan->param.lda, plan->param.ldb, plan->param.size, total_size);
 
@@ -1038,7 +2052,7 @@ ttc_gen_code_avx(
     }
 
     char gen_buf[TTC_GEN_BUF_SIZE];
-    sprintf(gen_buf, "%s.%s", target_prefix, target_suffix);
+    sprintf(gen_buf, TTC_DIR_GEN_CODE "%s.%s", target_prefix, target_suffix);
     FILE *target_file = fopen(gen_buf, "wc");
     if (NULL == target_file) {
         DEBUG_ERR_OUTPUT("Cannot create .cpp file.");
@@ -1052,9 +2066,14 @@ ttc_gen_code_avx(
         || TTC_TYPE_CZ == param->datatype || TTC_TYPE_ZC == param->datatype)
         fprintf(target_file, "#include <complex.h>\n");
 
-    // Function declaration
+    // Function declaration, the symbol name can be overridden at compile
+    // time (e.g. -D TTC_FUNC_NAME=...) when several kernels are linked into
+    // one binary.
+    fprintf(target_file, "\n#ifndef " TTC_FUNC_NAME_MACRO "\n"
+            "#define " TTC_FUNC_NAME_MACRO " " TTC_FUNC_SYMBOL "\n"
+            "#endif\n");
     fprintf(target_file, "\nextern \"C\" {\n"
-            "    void transpose(const void *, void *,\n"
+            "    int " TTC_FUNC_NAME_MACRO "(const void *, void *,\n"
             "        const void *, const void *,\n"
             "        const int *, const int *);\n}\n\n");
 
@@ -1066,7 +2085,8 @@ ttc_gen_code_avx(
     }
 
     // Function definition
-    fprintf(target_file, "void transpose(const void *input, void *result,\n"
+    fprintf(target_file, "int " TTC_FUNC_NAME_MACRO "(const void *input, "
+            "void *result,\n"
             "const void *alpha, const void *beta,\n"
             "const int *lda, const int *ldb) {\n"
             "    %s<", target_prefix);
@@ -1092,7 +2112,8 @@ ttc_gen_code_avx(
     fprintf(target_file, ">((const TENSOR_IN_T *)input,\n"
             "        (TENSOR_OUT_T *)result,\n"
             "        *(ALPHA_T *)alpha, BETA_PARAM\n"
-            "        lda, ldb);\n}");
+            "        lda, ldb);\n"
+            "    return 0;\n}");
 
     DEBUG_INFO_OUTPUT(".cpp file generation finished.");
     fclose(target_file);
@@ -1127,7 +2148,8 @@ ttc_gen_code_cuda(
     // For storing the target file's name, it is also used for generating the
     // transpose function's name in --dataType=zc case.
     char gen_buf[TTC_GEN_BUF_SIZE];
-    sprintf(gen_buf, "lib%s.%s", target_prefix, target_suffix);
+    sprintf(gen_buf, TTC_DIR_GEN_CODE "lib%s.%s", target_prefix,
+            target_suffix);
     FILE *target_file = fopen(gen_buf, "wc");
     if (NULL == target_file) {
         DEBUG_ERR_OUTPUT("Cannot create .cu file.");
@@ -1166,7 +2188,7 @@ ttc_gen_code_cuda(
             "    int transpose(const void *, void *,\n"
             "            const void *, const void *,\n"
             "            const int *, const int *,\n"
-            "            const int *, int);\n\n");
+            "            const int *, long long);\n\n");
     // TTC generated .h file doesn't include cuComplex.h, which leads to type
     // undefined. Here using function delcaration instead of include .h file.
     fprintf(target_file, "    void %s(const TENSOR_IN_T *,\n"
@@ -1177,9 +2199,11 @@ ttc_gen_code_cuda(
     fprintf(target_file, "int transpose(const void *input, void *result,\n"
             "        const void *alpha, const void *beta,\n"
             "        const int *lda, const int *ldb,\n"
-            "        const int *size, int total_size) {\n"
-            "    size_t input_size = total_size * sizeof(TENSOR_IN_T);\n"
-            "    size_t result_size = total_size * sizeof(TENSOR_OUT_T);\n"
+            "        const int *size, long long total_size) {\n"
+            "    size_t input_size = (size_t)total_size\n"
+            "        * sizeof(TENSOR_IN_T);\n"
+            "    size_t result_size = (size_t)total_size\n"
+            "        * sizeof(TENSOR_OUT_T);\n"
             "    TENSOR_IN_T *dev_input = NULL;\n"
             "    TENSOR_OUT_T *dev_result = NULL;\n"
             "    cudaError_t err;\n\n"
@@ -1228,110 +2252,177 @@ ttc_gen_lib(
         return NULL;
     }
 
+    // The commands are built with snprintf, a prefix too long for them
+    // fails instead of overflowing the buffers
     char cmd_buf[TTC_GEN_BUF_SIZE];
     cmd_buf[0] = '\0';
 
-    if (TTC_ARCH_DEFAULT == options->arch) {
-        DEBUG_INFO_OUTPUT("Default architecture.");
-
-        // Compiling
-        sprintf(cmd_buf, "%s -o %s.o %s.%s", TTC_ARCH_DEF_CMPL,
-                target_prefix, target_prefix, target_suffix);
-        DEBUG_INFO_OUTPUT(cmd_buf);
-        system(cmd_buf);
-
-        // Linking
-        sprintf(cmd_buf, "%s -o lib%s.so %s.o", TTC_ARCH_DEF_LINK,
-                target_prefix, target_prefix);
-        DEBUG_INFO_OUTPUT(cmd_buf);
-        system(cmd_buf);
-    }
-    else if (TTC_ARCH_AVX == options->arch) {
-        DEBUG_INFO_OUTPUT("AVX architecture.");
-        const char *cmpl = TTC_CMP_GXX == options->compiler ?
-            TTC_ARCH_AVX_GXX_CMPL : TTC_ARCH_AVX_ICPC_CMPL;
-        const char *link = TTC_CMP_GXX == options->compiler ?
-            TTC_ARCH_AVX_GXX_LINK : TTC_ARCH_AVX_ICPC_LINK;
-
-        // Compiling
-        sprintf(cmd_buf, "%s -o %s.o %s.%s", cmpl,
-                target_prefix, target_prefix, target_suffix);
-        DEBUG_INFO_OUTPUT(cmd_buf);
-        system(cmd_buf);
-
-        // Linking
-        sprintf(cmd_buf, "%s -o lib%s.so %s.o", link,
-                target_prefix, target_prefix);
-        DEBUG_INFO_OUTPUT(cmd_buf);
-        system(cmd_buf);
+    // Every library gets its own name, dlopen would return an already loaded
+    // library of the same name instead of the regenerated one. The plans of
+    // several threads may be generated at once.
+    static uint32_t lib_count = 0;
+    char lib_name[TTC_GEN_BUF_SIZE];
+    int32_t length = snprintf(lib_name, sizeof(lib_name), "lib%s.%u.so",
+            target_prefix, __atomic_fetch_add(&lib_count, 1,
+                __ATOMIC_RELAXED));
+    if (length < 0 || (size_t)length >= sizeof(lib_name)) {
+        DEBUG_ERR_OUTPUT("The library name is too long.");
+        return NULL;
     }
-    else if (TTC_ARCH_AVX512 == options->arch) {
-        DEBUG_INFO_OUTPUT("AVX512 architecture.");
-
-        // Compiling
-        sprintf(cmd_buf, "%s -o %s.o %s.%s", TTC_ARCH_AVX512_CMPL,
-                target_prefix, target_prefix, target_suffix);
-        DEBUG_INFO_OUTPUT(cmd_buf);
-        system(cmd_buf);
 
-        // Linking
-        sprintf(cmd_buf, "%s -o lib%s.so %s.o", TTC_ARCH_AVX512_LINK,
-                target_prefix, target_prefix);
-        DEBUG_INFO_OUTPUT(cmd_buf);
-        system(cmd_buf);
-    }
-    else if (TTC_ARCH_KNC == options->arch) {
-        DEBUG_INFO_OUTPUT("KNC architecture.");
+    if (TTC_ARCH_CUDA != options->arch) {
+        const char *cmpl = ttc_cmpl_cmd(options);
+        const char *link = ttc_link_cmd(options);
+        DEBUG_SET_NAMESPACE("ttc_gen_lib");
+        if (NULL == cmpl || NULL == link) {
+            DEBUG_ERR_OUTPUT("The architecture is currently not supported.");
+            return NULL;
+        }
 
         // Compiling
-        sprintf(cmd_buf, "%s -o %s.o %s.%s", TTC_ARCH_KNC_CMPL,
-                target_prefix, target_prefix, target_suffix);
+        length = snprintf(cmd_buf, sizeof(cmd_buf), TTC_CD_GEN_CODE
+                "%s -o %s.o %s.%s", cmpl, target_prefix, target_prefix,
+                target_suffix);
+        if (length < 0 || (size_t)length >= sizeof(cmd_buf)) {
+            DEBUG_ERR_OUTPUT("The command is too long.");
+            return NULL;
+        }
         DEBUG_INFO_OUTPUT(cmd_buf);
         system(cmd_buf);
 
         // Linking
-        sprintf(cmd_buf, "%s -o lib%s.so %s.o", TTC_ARCH_KNC_LINK,
-                target_prefix, target_prefix);
+        length = snprintf(cmd_buf, sizeof(cmd_buf), TTC_CD_GEN_CODE
+                "%s -o %s %s.o", link, lib_name, target_prefix);
+        if (length < 0 || (size_t)length >= sizeof(cmd_buf)) {
+            DEBUG_ERR_OUTPUT("The command is too long.");
+            return NULL;
+        }
         DEBUG_INFO_OUTPUT(cmd_buf);
         system(cmd_buf);
     }
-    else if (TTC_ARCH_CUDA == options->arch) {
+    else {
         DEBUG_INFO_OUTPUT("CUDA architecture.");
 
         // Compiling
-        sprintf(cmd_buf, "%s -o %s.o %s.%s", TTC_ARCH_CUDA_CMPL,
-                target_prefix, target_prefix, target_suffix);
+        length = snprintf(cmd_buf, sizeof(cmd_buf), TTC_CD_GEN_CODE
+                "%s -o %s.o %s.%s", TTC_ARCH_CUDA_CMPL, target_prefix,
+                target_prefix, target_suffix);
+        if (length < 0 || (size_t)length >= sizeof(cmd_buf)) {
+            DEBUG_ERR_OUTPUT("The command is too long.");
+            return NULL;
+        }
         DEBUG_INFO_OUTPUT(cmd_buf);
         system(cmd_buf);
-        sprintf(cmd_buf, "%s -o lib%s.o lib%s.%s", TTC_ARCH_CUDA_CMPL,
-                target_prefix, target_prefix, target_suffix);
+        length = snprintf(cmd_buf, sizeof(cmd_buf), TTC_CD_GEN_CODE
+                "%s -o lib%s.o lib%s.%s", TTC_ARCH_CUDA_CMPL, target_prefix,
+                target_prefix, target_suffix);
+        if (length < 0 || (size_t)length >= sizeof(cmd_buf)) {
+            DEBUG_ERR_OUTPUT("The command is too long.");
+            return NULL;
+        }
         DEBUG_INFO_OUTPUT(cmd_buf);
         system(cmd_buf);
 
         // Linking
-        sprintf(cmd_buf, "%s -o lib%s.so %s.o lib%s.o", TTC_ARCH_CUDA_LINK,
-                target_prefix, target_prefix, target_prefix);
+        length = snprintf(cmd_buf, sizeof(cmd_buf), TTC_CD_GEN_CODE
+                "%s -o %s %s.o lib%s.o", TTC_ARCH_CUDA_LINK, lib_name,
+                target_prefix, target_prefix);
+        if (length < 0 || (size_t)length >= sizeof(cmd_buf)) {
+            DEBUG_ERR_OUTPUT("The command is too long.");
+            return NULL;
+        }
         DEBUG_INFO_OUTPUT(cmd_buf);
         system(cmd_buf);
     }
-    else {
-        DEBUG_ERR_OUTPUT("The architecture is currently not supported.");
-        return NULL;
-    }
 
     // Loading shared library
     DEBUG_INFO_OUTPUT("Loading shared library.");
-    sprintf(cmd_buf, "./lib%s.so", target_prefix);
+    length = snprintf(cmd_buf, sizeof(cmd_buf), TTC_DIR_GEN_CODE "%s",
+            lib_name);
+    if (length < 0 || (size_t)length >= sizeof(cmd_buf)) {
+        DEBUG_ERR_OUTPUT("The library path is too long.");
+        return NULL;
+    }
     void *dlhandler = dlopen(cmd_buf, RTLD_NOW);
     if (NULL == dlhandler) {
         DEBUG_ERR_OUTPUT(dlerror());
         return NULL;
     }
 
+    // The mapping outlives the file, so that the libraries do not pile up.
+    // Opening the same path again finds the loaded library by its name.
+    if (0 != unlink(cmd_buf))
+        DEBUG_WARN_OUTPUT("Cannot remove the library file.");
+
     return dlhandler;
 }
 
 
+const char *
+ttc_cmpl_cmd(
+        const ttc_opt_s *options
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_cmpl_cmd");
+    // Parameter check
+    if (NULL == options) {
+        DEBUG_ERR_OUTPUT("Parameter options is not initialized.");
+        return NULL;
+    }
+
+    switch (options->arch) {
+    case TTC_ARCH_DEFAULT:
+        DEBUG_INFO_OUTPUT("Default architecture.");
+        return TTC_ARCH_DEF_CMPL;
+    case TTC_ARCH_AVX:
+        DEBUG_INFO_OUTPUT("AVX architecture.");
+        return TTC_CMP_GXX == options->compiler ?
+            TTC_ARCH_AVX_GXX_CMPL : TTC_ARCH_AVX_ICPC_CMPL;
+    case TTC_ARCH_AVX512:
+        DEBUG_INFO_OUTPUT("AVX512 architecture.");
+        return TTC_ARCH_AVX512_CMPL;
+    case TTC_ARCH_KNC:
+        DEBUG_INFO_OUTPUT("KNC architecture.");
+        return TTC_ARCH_KNC_CMPL;
+    case TTC_ARCH_CUDA:
+        DEBUG_INFO_OUTPUT("CUDA architecture.");
+        return TTC_ARCH_CUDA_CMPL;
+    default:
+        DEBUG_ERR_OUTPUT("The architecture is currently not supported.");
+        return NULL;
+    }
+}
+
+
+const char *
+ttc_link_cmd(
+        const ttc_opt_s *options
+        ) {
+    DEBUG_SET_NAMESPACE("ttc_link_cmd");
+    // Parameter check
+    if (NULL == options) {
+        DEBUG_ERR_OUTPUT("Parameter options is not initialized.");
+        return NULL;
+    }
+
+    switch (options->arch) {
+    case TTC_ARCH_DEFAULT:
+        return TTC_ARCH_DEF_LINK;
+    case TTC_ARCH_AVX:
+        return TTC_CMP_GXX == options->compiler ?
+            TTC_ARCH_AVX_GXX_LINK : TTC_ARCH_AVX_ICPC_LINK;
+    case TTC_ARCH_AVX512:
+        return TTC_ARCH_AVX512_LINK;
+    case TTC_ARCH_KNC:
+        return TTC_ARCH_KNC_LINK;
+    case TTC_ARCH_CUDA:
+        return TTC_ARCH_CUDA_LINK;
+    default:
+        DEBUG_ERR_OUTPUT("The architecture is currently not supported.");
+        return NULL;
+    }
+}
+
+
 int32_t
 ttc_gen_type_macro(
         const ttc_opt_s     *options,
@@ -0,0 +1,134 @@
+/**
+ * @file engine-test.c
+ *
+ * @brief Test example for the built-in engine of TTC C API.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "test-util.h"
+#include "ttc_c.h"
+
+
+int32_t
+main() {
+    uint32_t total_num = 0, error_num = 0;
+    const ttc_datatype_e types[] = { TTC_TYPE_S, TTC_TYPE_D, TTC_TYPE_C,
+        TTC_TYPE_Z, TTC_TYPE_SD, TTC_TYPE_DS, TTC_TYPE_CZ, TTC_TYPE_ZC };
+    const char *names[] = { "S", "D", "C", "Z", "SD", "DS", "CZ", "ZC" };
+
+
+    set_scope("Engine test");
+    uint32_t idx;
+    for (idx = 0; idx < sizeof(types) / sizeof(types[0]); ++idx) {
+        TEST_INFO_OUTPUT(names[idx]);
+        ++total_num;
+        if (0 != engine_test(types[idx], TTC_ENGINE_GENERIC)) {
+            TEST_ERR_OUTPUT("Generic engine test failed.");
+            ++error_num;
+        }
+        else {
+            TEST_SUCC_OUTPUT("Generic engine test succeed.");
+        }
+
+        ++total_num;
+        if (0 != engine_test(types[idx], TTC_ENGINE_RECURSIVE)) {
+            TEST_ERR_OUTPUT("Recursive engine test failed.");
+            ++error_num;
+        }
+        else {
+            TEST_SUCC_OUTPUT("Recursive engine test succeed.");
+        }
+
+        ++total_num;
+        if (0 != multipass_test(types[idx])) {
+            TEST_ERR_OUTPUT("Multi-pass engine test failed.");
+            ++error_num;
+        }
+        else {
+            TEST_SUCC_OUTPUT("Multi-pass engine test succeed.");
+        }
+
+        ++total_num;
+        if (0 != conflict_test(types[idx])) {
+            TEST_ERR_OUTPUT("Cache conflict test failed.");
+            ++error_num;
+        }
+        else {
+            TEST_SUCC_OUTPUT("Cache conflict test succeed.");
+        }
+
+        ++total_num;
+        if (0 != store_test(types[idx])) {
+            TEST_ERR_OUTPUT("Store hint test failed.");
+            ++error_num;
+        }
+        else {
+            TEST_SUCC_OUTPUT("Store hint test succeed.");
+        }
+
+        ++total_num;
+        if (0 != inplace_test(types[idx])) {
+            TEST_ERR_OUTPUT("In-place test failed.");
+            ++error_num;
+        }
+        else {
+            TEST_SUCC_OUTPUT("In-place test succeed.");
+        }
+
+        ++total_num;
+        if (0 != wide_test(types[idx])) {
+            TEST_ERR_OUTPUT("64-bit parameter test failed.");
+            ++error_num;
+        }
+        else {
+            TEST_SUCC_OUTPUT("64-bit parameter test succeed.");
+        }
+    }
+
+    set_scope("Concurrent test");
+    ++total_num;
+    if (0 != concurrent_test()) {
+        TEST_ERR_OUTPUT("Concurrent execution test failed.");
+        ++error_num;
+    }
+    else {
+        TEST_SUCC_OUTPUT("Concurrent execution test succeed.");
+    }
+
+    set_scope("Tuning test");
+    ++total_num;
+    if (0 != tune_db_test()) {
+        TEST_ERR_OUTPUT("Tuning database test failed.");
+        ++error_num;
+    }
+    else {
+        TEST_SUCC_OUTPUT("Tuning database test succeed.");
+    }
+
+    ++total_num;
+    if (0 != transfer_test()) {
+        TEST_ERR_OUTPUT("Tuning record transfer test failed.");
+        ++error_num;
+    }
+    else {
+        TEST_SUCC_OUTPUT("Tuning record transfer test succeed.");
+    }
+
+    ++total_num;
+    if (0 != model_test()) {
+        TEST_ERR_OUTPUT("Performance model test failed.");
+        ++error_num;
+    }
+    else {
+        TEST_SUCC_OUTPUT("Performance model test succeed.");
+    }
+
+
+    printf("%sTest finished. TOTAL: %d, SUCCEED: %d, FAILED: %d%s\n",
+            CYN, total_num, total_num - error_num, error_num, RESET);
+
+    return 0 == error_num ? EXIT_SUCCESS : EXIT_FAILURE;
+}
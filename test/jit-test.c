@@ -29,6 +29,54 @@ main() {
     }
 
 
+    set_scope("Alignment test");
+    TEST_INFO_OUTPUT("Aligned and unaligned tensors.");
+    ++total_num;
+    if (0 != align_test()) {
+        TEST_ERR_OUTPUT("Alignment test failed.");
+        ++error_num;
+    }
+    else {
+        TEST_SUCC_OUTPUT("Alignment test succeed.");
+    }
+
+
+    set_scope("Alignment fallback test");
+    TEST_INFO_OUTPUT("Unaligned tensors without the unaligned variant.");
+    ++total_num;
+    if (0 != align_fail_test()) {
+        TEST_ERR_OUTPUT("Alignment fallback test failed.");
+        ++error_num;
+    }
+    else {
+        TEST_SUCC_OUTPUT("Alignment fallback test succeed.");
+    }
+
+
+    set_scope("Re-tuning test");
+    TEST_INFO_OUTPUT("Re-tuning an alignment variant.");
+    ++total_num;
+    if (0 != retune_test()) {
+        TEST_ERR_OUTPUT("Re-tuning test failed.");
+        ++error_num;
+    }
+    else {
+        TEST_SUCC_OUTPUT("Re-tuning test succeed.");
+    }
+
+
+    set_scope("Grid test");
+    TEST_INFO_OUTPUT("Sharing tile kernels with and without beta.");
+    ++total_num;
+    if (0 != grid_test()) {
+        TEST_ERR_OUTPUT("Grid test failed.");
+        ++error_num;
+    }
+    else {
+        TEST_SUCC_OUTPUT("Grid test succeed.");
+    }
+
+
     set_scope("Datatype test");
     TEST_INFO_OUTPUT("Data type test: single precision.");
     ++total_num;
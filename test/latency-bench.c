@@ -0,0 +1,108 @@
+/**
+ * @file latency-bench.c
+ *
+ * @brief Latency benchmark of small transpositions for TTC C API.
+ *
+ * @details Every size from 64 B to 64 KB is transposed repeatedly through
+ * ttc_transpose with a reused handler, and the calls per second are printed
+ * for a 2-D transpose and a 3-D transposition.
+ *
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "test-util.h"
+#include "ttc_c.h"
+
+
+#define BENCH_MIN_BYTES     64
+#define BENCH_MAX_BYTES     65536
+#define BENCH_TIME          0.2
+
+
+/**
+ * @brief Measure the calls per second of a transposition.
+ */
+static double
+bench_calls(
+        ttc_handler_s       *handler,
+        const ttc_param_s   *param,
+        const float         *input,
+        float               *result
+        ) {
+    // The first call creates the plan
+    if (0 != ttc_transpose(handler, param, input, result))
+        return 0.0;
+
+    uint64_t calls = 0, batch = 16;
+    double start = get_wtime(), elapsed = 0.0;
+    while (elapsed < BENCH_TIME) {
+        uint64_t idx;
+        for (idx = 0; idx < batch; ++idx)
+            ttc_transpose(handler, param, input, result);
+        calls += batch;
+        batch *= 2;
+        elapsed = get_wtime() - start;
+    }
+
+    return calls / elapsed;
+}
+
+
+int32_t
+main() {
+    set_scope("Latency benchmark");
+    ttc_handler_s *handler = ttc_init();
+    if (NULL == handler) {
+        TEST_ERR_OUTPUT("Cannot create handler.");
+        return EXIT_FAILURE;
+    }
+
+    float *input = (float *)malloc(BENCH_MAX_BYTES);
+    float *result = (float *)malloc(BENCH_MAX_BYTES);
+    if (NULL == input || NULL == result) {
+        TEST_ERR_OUTPUT("Cannot allocate memory for tensors.");
+        free(input);
+        free(result);
+        ttc_release(handler);
+        return EXIT_FAILURE;
+    }
+    uint32_t idx;
+    for (idx = 0; idx < BENCH_MAX_BYTES / sizeof(float); ++idx)
+        input[idx] = (float)idx;
+
+    printf("%10s %16s %16s\n", "bytes", "2-D calls/s", "3-D calls/s");
+    uint32_t bytes;
+    for (bytes = BENCH_MIN_BYTES; bytes <= BENCH_MAX_BYTES; bytes *= 2) {
+        // Split the elements into near square and near cubic shapes
+        uint32_t elem = bytes / sizeof(float), log_elem = 0;
+        while ((1u << log_elem) < elem)
+            ++log_elem;
+
+        ttc_param_s param = ttc_default_param();
+        uint32_t perm_2d[2] = { 1, 0 };
+        uint32_t size_2d[2]
+            = { 1u << (log_elem - log_elem / 2), 1u << (log_elem / 2) };
+        param.dim = 2;
+        param.perm = perm_2d;
+        param.size = size_2d;
+        double calls_2d = bench_calls(handler, &param, input, result);
+
+        uint32_t perm_3d[3] = { 2, 0, 1 };
+        uint32_t size_3d[3] = { 1u << (log_elem - 2 * (log_elem / 3)),
+            1u << (log_elem / 3), 1u << (log_elem / 3) };
+        param.dim = 3;
+        param.perm = perm_3d;
+        param.size = size_3d;
+        double calls_3d = bench_calls(handler, &param, input, result);
+
+        printf("%10u %16.0f %16.0f\n", bytes, calls_2d, calls_3d);
+    }
+
+    free(input);
+    free(result);
+    ttc_release(handler);
+
+    return EXIT_SUCCESS;
+}
@@ -8,9 +8,22 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <complex.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include "test-util.h"
 #include "ttc_c.h"
+#include "ttc_c_util.h"
+#include "ttc_c_tune.h"
+#include "ttc_c_hw.h"
+
+
+#define ENGINE_TEST_MAX_DIM 8
+#define ENGINE_TEST_THREADS 4
+#define ENGINE_TEST_CALLS   8
+
+
+char common_prefix[TEST_GEN_BUF_SIZE];
 
 
 void set_scope(const char *name) {
@@ -464,3 +477,1363 @@ no_transpose(
 
     return ret;
 }
+
+
+/**
+ * @brief Read a scalar of a tensor as double.
+ */
+static double
+engine_test_load(
+        const void  *tensor,
+        uint64_t    pos,
+        bool        single
+        ) {
+    return single ? ((const float *)tensor)[pos]
+        : ((const double *)tensor)[pos];
+}
+
+
+/**
+ * @brief Decode the scalars per element and the precision of both tensors.
+ */
+static void
+engine_test_type(
+        ttc_datatype_e  type,
+        uint32_t        *ncomp,
+        bool            *in_single,
+        bool            *out_single
+        ) {
+    *ncomp = TTC_TYPE_C == type || TTC_TYPE_Z == type
+        || TTC_TYPE_CZ == type || TTC_TYPE_ZC == type ? 2 : 1;
+    *in_single = TTC_TYPE_D != type && TTC_TYPE_Z != type
+        && TTC_TYPE_DS != type && TTC_TYPE_ZC != type;
+    *out_single = TTC_TYPE_D != type && TTC_TYPE_Z != type
+        && TTC_TYPE_SD != type && TTC_TYPE_CZ != type;
+}
+
+
+/**
+ * @brief Allocate the input, result and reference of a test, 64-byte
+ * aligned. A size of 0 leaves its pointer null.
+ */
+static int32_t
+engine_test_alloc(
+        uint64_t    in_bytes,
+        uint64_t    out_bytes,
+        uint64_t    expect_bytes,
+        void        **input,
+        void        **result,
+        void        **expect
+        ) {
+    *input = *result = *expect = NULL;
+    if ((0 != in_bytes && 0 != posix_memalign(input, 64, in_bytes))
+        || (0 != out_bytes && 0 != posix_memalign(result, 64, out_bytes))
+        || (0 != expect_bytes
+            && 0 != posix_memalign(expect, 64, expect_bytes))) {
+        TEST_ERR_OUTPUT("Cannot allocate memory for tensors.");
+        free(*input);
+        free(*result);
+        free(*expect);
+        *input = *result = *expect = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+
+/**
+ * @brief Create a handler running the given engine.
+ */
+static ttc_handler_s *
+engine_test_handler(
+        ttc_engine_e    engine
+        ) {
+    ttc_handler_s *handler = ttc_init();
+    if (NULL == handler
+        || 0 != ttc_set_opt(handler, TTC_OPT_ENGINE, &engine, 0)) {
+        TEST_ERR_OUTPUT("Cannot create handler.");
+        ttc_release(handler);
+        return NULL;
+    }
+
+    return handler;
+}
+
+
+/**
+ * @brief Set the alpha and beta of a parameter in the precision of its
+ * tensors.
+ */
+static void
+engine_test_scalars(
+        ttc_param_s     *param,
+        double          alpha,
+        double          beta
+        ) {
+    uint32_t ncomp;
+    bool in_single, out_single;
+    engine_test_type(param->datatype, &ncomp, &in_single, &out_single);
+    if (in_single)
+        param->alpha.s = alpha;
+    else
+        param->alpha.d = alpha;
+    if (out_single)
+        param->beta.s = beta;
+    else
+        param->beta.d = beta;
+}
+
+
+/**
+ * @brief Fill the scalars of a tensor with a pattern, or with 1.0.
+ */
+static void
+engine_test_fill(
+        void        *tensor,
+        uint64_t    num,
+        bool        single,
+        bool        pattern
+        ) {
+    uint64_t pos;
+    for (pos = 0; pos < num; ++pos) {
+        double value = pattern ? (double)(pos % 1000) / 8.0 : 1.0;
+        if (single)
+            ((float *)tensor)[pos] = value;
+        else
+            ((double *)tensor)[pos] = value;
+    }
+}
+
+
+/**
+ * @brief Compute the reference of a transposition in the order of the
+ * output. The `expect` holds the output before the call, the indices are
+ * counted like an odometer.
+ */
+static void
+engine_test_reference(
+        const ttc_param_s   *param,
+        const void          *input,
+        double              alpha,
+        double              beta,
+        double              *expect
+        ) {
+    uint32_t ncomp;
+    bool in_single, out_single;
+    engine_test_type(param->datatype, &ncomp, &in_single, &out_single);
+
+    const uint32_t dim = param->dim;
+    const uint32_t *perm = param->perm, *size = param->size;
+    uint64_t stride_a[ENGINE_TEST_MAX_DIM], stride_b[ENGINE_TEST_MAX_DIM];
+    uint32_t idx[ENGINE_TEST_MAX_DIM] = { 0 }, dim_idx, comp;
+    for (dim_idx = 0; dim_idx < dim; ++dim_idx) {
+        stride_a[dim_idx] = 0 == dim_idx ? 1 : stride_a[dim_idx - 1]
+            * (NULL != param->lda ? (uint32_t)param->lda[dim_idx - 1]
+                : size[dim_idx - 1]);
+        stride_b[dim_idx] = 0 == dim_idx ? 1 : stride_b[dim_idx - 1]
+            * (NULL != param->ldb ? (uint32_t)param->ldb[dim_idx - 1]
+                : size[perm[dim_idx - 1]]);
+    }
+    do {
+        uint64_t pos_a = 0, pos_b = 0;
+        for (dim_idx = 0; dim_idx < dim; ++dim_idx) {
+            pos_a += idx[dim_idx] * stride_a[perm[dim_idx]];
+            pos_b += idx[dim_idx] * stride_b[dim_idx];
+        }
+        for (comp = 0; comp < ncomp; ++comp)
+            expect[pos_b * ncomp + comp] = alpha
+                * engine_test_load(input, pos_a * ncomp + comp, in_single)
+                + beta * expect[pos_b * ncomp + comp];
+        for (dim_idx = 0; dim_idx < dim
+                && ++idx[dim_idx] == size[perm[dim_idx]]; ++dim_idx)
+            idx[dim_idx] = 0;
+    } while (dim_idx < dim);
+}
+
+
+/**
+ * @brief Compare the scalars of a result with the reference.
+ */
+static int32_t
+engine_test_compare(
+        const void      *result,
+        const double    *expect,
+        uint64_t        num,
+        bool            single
+        ) {
+    uint64_t pos;
+    for (pos = 0; pos < num; ++pos) {
+        double diff = engine_test_load(result, pos, single) - expect[pos];
+        if (diff > 1e-3 || diff < -1e-3) {
+            TEST_ERR_OUTPUT("Result mismatches the reference.");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+
+int32_t
+engine_test(
+        ttc_datatype_e  type,
+        ttc_engine_e    engine
+        ) {
+    uint32_t ncomp;
+    bool in_single, out_single;
+    engine_test_type(type, &ncomp, &in_single, &out_single);
+
+    uint32_t perms[7][TENSOR_DIM] = { { 1, 0, 2 }, { 2, 0, 1 }, { 0, 2, 1 },
+        { 2, 1, 0 }, { 0, 1, 2 }, { 2, 0, 1 }, { 1, 0, 2 } };
+    // The last two transpositions are skinny, the output or the input has a
+    // short dimension 0
+    uint32_t sizes[7][TENSOR_DIM] = { { 67, 45, 9 }, { 67, 45, 9 },
+        { 67, 45, 9 }, { 67, 45, 9 }, { 67, 45, 9 }, { 67, 45, 5 },
+        { 5, 67, 9 } };
+    int32_t lda[TENSOR_DIM] = { 70, 70, 9 };
+    int32_t ldb[TENSOR_DIM] = { 80, 80, 80 };
+    uint64_t num = 80 * 80 * 80 * ncomp;
+    double alpha = 2.0, beta = 0.5;
+
+    void *input, *result;
+    double *expect;
+    if (0 != engine_test_alloc(num * (in_single ? 4 : 8),
+                num * (out_single ? 4 : 8), num * sizeof(double), &input,
+                &result, (void **)&expect))
+        return -1;
+
+    int32_t ret = 0;
+    uint32_t test_idx;
+    for (test_idx = 0; 0 == ret && test_idx < 14; ++test_idx) {
+        bool padded = 1 == test_idx % 2;
+
+        // The leading dimensions and beta are not in the plan signature,
+        // every case needs its own handler
+        ttc_handler_s *handler = engine_test_handler(engine);
+        if (NULL == handler) {
+            ret = -1;
+            break;
+        }
+
+        // The beta of an unpadded transposition is left as 0
+        ttc_param_s param = ttc_default_param();
+        param.datatype = type;
+        param.dim = TENSOR_DIM;
+        param.perm = perms[test_idx / 2];
+        param.size = sizes[test_idx / 2];
+        param.lda = padded ? lda : NULL;
+        param.ldb = padded ? ldb : NULL;
+        engine_test_scalars(&param, alpha, padded ? beta : 0.0);
+
+        engine_test_fill(input, num, in_single, true);
+        engine_test_fill(result, num, out_single, false);
+        engine_test_fill(expect, num, false, false);
+        engine_test_reference(&param, input, alpha, padded ? beta : 0.0,
+                expect);
+
+        ret = ttc_transpose(handler, &param, input, result);
+        ttc_release(handler);
+        if (0 != ret) {
+            TEST_ERR_OUTPUT("Transpose failed.");
+            break;
+        }
+        ret = engine_test_compare(result, expect, num, out_single);
+    }
+
+    free(input);
+    free(result);
+    free(expect);
+
+    return ret;
+}
+
+
+int32_t
+multipass_test(
+        ttc_datatype_e  type
+        ) {
+    uint32_t ncomp;
+    bool in_single, out_single;
+    engine_test_type(type, &ncomp, &in_single, &out_single);
+
+    uint32_t perm[6] = { 5, 3, 1, 4, 2, 0 };
+    uint32_t size[6] = { 5, 6, 4, 6, 3, 7 };
+    // Padding the leading dimensions would make the passes too short
+    int32_t lda[6] = { 5, 6, 4, 8, 3, 7 };
+    int32_t ldb[6] = { 7, 6, 8, 3, 6, 5 };
+    uint64_t num = 7 * 6 * 8 * 3 * 6 * 5 * ncomp;
+    double alpha = 2.0, beta = 0.5;
+
+    void *input, *result;
+    double *expect;
+    if (0 != engine_test_alloc(num * (in_single ? 4 : 8),
+                num * (out_single ? 4 : 8), num * sizeof(double), &input,
+                &result, (void **)&expect))
+        return -1;
+
+    int32_t ret = 0;
+    uint32_t test_idx;
+    for (test_idx = 0; 0 == ret && test_idx < 2; ++test_idx) {
+        bool padded = 1 == test_idx;
+        ttc_handler_s *handler = engine_test_handler(TTC_ENGINE_MULTIPASS);
+        if (NULL == handler) {
+            ret = -1;
+            break;
+        }
+
+        ttc_param_s param = ttc_default_param();
+        param.datatype = type;
+        param.dim = 6;
+        param.perm = perm;
+        param.size = size;
+        param.lda = padded ? lda : NULL;
+        param.ldb = padded ? ldb : NULL;
+        engine_test_scalars(&param, alpha, padded ? beta : 0.0);
+
+        engine_test_fill(input, num, in_single, true);
+        engine_test_fill(result, num, out_single, false);
+        engine_test_fill(expect, num, false, false);
+        engine_test_reference(&param, input, alpha, padded ? beta : 0.0,
+                expect);
+
+        // The plan must not fall back to a single pass, except for complex
+        // doubles whose short runs still fill the cache lines
+        ttc_estimate_s estimate;
+        bool split = TTC_TYPE_Z != type && TTC_TYPE_CZ != type
+            && TTC_TYPE_ZC != type;
+        ret = ttc_transpose(handler, &param, input, result);
+        if (0 == ret && split
+            && (0 != ttc_estimate(handler, &param, &estimate)
+                || TTC_ENGINE_MULTIPASS != estimate.engine)) {
+            TEST_ERR_OUTPUT("The transposition is not split.");
+            ret = -1;
+        }
+        ttc_release(handler);
+        if (0 != ret) {
+            TEST_ERR_OUTPUT("Transpose failed.");
+            break;
+        }
+        ret = engine_test_compare(result, expect, num, out_single);
+    }
+
+    free(input);
+    free(result);
+    free(expect);
+
+    return ret;
+}
+
+
+/**
+ * @brief Struct for a thread of the concurrent test.
+ */
+typedef struct engine_test_thread {
+    ttc_handler_s       *handler;
+    const ttc_param_s   *param;
+    const void          *input;
+    void                *result;
+    int32_t             ret;
+} engine_test_thread_s;
+
+
+/**
+ * @brief Transpose repeatedly on one thread of the concurrent test.
+ */
+static void *
+engine_test_worker(
+        void    *arg
+        ) {
+    engine_test_thread_s *thread = (engine_test_thread_s *)arg;
+    uint32_t idx;
+    for (idx = 0; 0 == thread->ret && idx < ENGINE_TEST_CALLS; ++idx)
+        thread->ret = ttc_transpose(thread->handler, thread->param,
+                thread->input, thread->result);
+
+    return NULL;
+}
+
+
+int32_t
+concurrent_test(
+        ) {
+    // A multi-pass plan, and a generic one probing the recursive kernel
+    uint32_t perm[2][6] = { { 5, 3, 1, 4, 2, 0 }, { 1, 0 } };
+    uint32_t size[2][6] = { { 5, 6, 4, 6, 3, 7 }, { 320, 288 } };
+    uint32_t dim[2] = { 6, 2 };
+    ttc_engine_e engine[2] = { TTC_ENGINE_MULTIPASS, TTC_ENGINE_AUTO };
+    const uint64_t num = 320 * 288;
+
+    void *input, *result;
+    double *expect;
+    if (0 != engine_test_alloc(num * sizeof(float),
+                num * sizeof(float) * ENGINE_TEST_THREADS,
+                num * sizeof(double), &input, &result, (void **)&expect))
+        return -1;
+    engine_test_fill(input, num, true, true);
+
+    int32_t ret = 0;
+    uint32_t test_idx;
+    for (test_idx = 0; 0 == ret && test_idx < 2; ++test_idx) {
+        ttc_handler_s *handler = engine_test_handler(engine[test_idx]);
+        if (NULL == handler) {
+            ret = -1;
+            break;
+        }
+
+        ttc_param_s param = ttc_default_param();
+        param.datatype = TTC_TYPE_S;
+        param.dim = dim[test_idx];
+        param.perm = perm[test_idx];
+        param.size = size[test_idx];
+        engine_test_scalars(&param, 2.0, 0.0);
+        uint64_t elem = 1, pos;
+        for (pos = 0; pos < param.dim; ++pos)
+            elem *= param.size[pos];
+        engine_test_fill(expect, elem, false, false);
+        engine_test_reference(&param, input, 2.0, 0.0, expect);
+
+        // The plan exists before the threads run it, every thread writes its
+        // own result
+        engine_test_thread_s threads[ENGINE_TEST_THREADS];
+        pthread_t ids[ENGINE_TEST_THREADS];
+        uint32_t started = 0, idx;
+        ret = ttc_transpose(handler, &param, input, result);
+        for (; 0 == ret && started < ENGINE_TEST_THREADS; ++started) {
+            threads[started] = (engine_test_thread_s){ .handler = handler,
+                .param = &param, .input = input,
+                .result = (float *)result + started * num, .ret = 0 };
+            if (0 != pthread_create(&ids[started], NULL, engine_test_worker,
+                        &threads[started])) {
+                TEST_ERR_OUTPUT("Cannot create thread.");
+                ret = -1;
+                break;
+            }
+        }
+        for (idx = 0; idx < started; ++idx) {
+            pthread_join(ids[idx], NULL);
+            if (0 == ret && 0 != threads[idx].ret) {
+                TEST_ERR_OUTPUT("Transpose failed.");
+                ret = -1;
+            }
+        }
+        for (idx = 0; 0 == ret && idx < ENGINE_TEST_THREADS; ++idx)
+            ret = engine_test_compare((float *)result + idx * num, expect,
+                    elem, true);
+
+        // The probe must have counted all its calls
+        const ttc_plan_s *plan = ttc_lookup_plan(handler, &param);
+        if (0 == ret && (NULL == plan || 0 != plan->num_probes)) {
+            TEST_ERR_OUTPUT("The probe is not finished.");
+            ret = -1;
+        }
+        ttc_release(handler);
+    }
+
+    free(input);
+    free(result);
+    free(expect);
+
+    return ret;
+}
+
+int32_t
+conflict_test(
+        ttc_datatype_e  type
+        ) {
+    uint32_t ncomp;
+    bool in_single, out_single;
+    engine_test_type(type, &ncomp, &in_single, &out_single);
+    uint32_t out_size = (out_single ? 4 : 8) * ncomp;
+
+    // The output rows are 1 KiB or more apart
+    uint32_t perm[TENSOR_DIM] = { 1, 0, 2 };
+    uint32_t size[TENSOR_DIM] = { 256, 256, 2 };
+    int32_t ldb[TENSOR_DIM];
+    uint64_t num = 272 * 257 * 2 * ncomp;
+    double alpha = 2.0, beta = 0.5;
+
+    void *input, *result;
+    double *expect;
+    if (0 != engine_test_alloc(num * (in_single ? 4 : 8),
+                num * (out_single ? 4 : 8), num * sizeof(double), &input,
+                &result, (void **)&expect))
+        return -1;
+
+    int32_t ret = 0;
+    uint32_t test_idx;
+    for (test_idx = 0; 0 == ret && test_idx < 3; ++test_idx) {
+        bool update = 0 != test_idx, padded = 2 == test_idx;
+        ttc_handler_s *handler = engine_test_handler(TTC_ENGINE_GENERIC);
+        if (NULL == handler) {
+            ret = -1;
+            break;
+        }
+
+        ttc_param_s param = ttc_default_param();
+        param.datatype = type;
+        param.dim = TENSOR_DIM;
+        param.perm = perm;
+        param.size = size;
+        engine_test_scalars(&param, alpha, update ? beta : 0.0);
+
+        // The suggested rows are no longer a multiple of 1 KiB apart
+        if (padded) {
+            if (0 != ttc_suggest_ld(&param, NULL, ldb)
+                || ldb[0] < (int32_t)size[1] || ldb[1] < (int32_t)size[0]
+                || 0 == ldb[0] * out_size % 1024
+                || 0 == ldb[0] * ldb[1] * out_size % 1024) {
+                TEST_ERR_OUTPUT("Bad suggestion of leading dimensions.");
+                ttc_release(handler);
+                ret = -1;
+                break;
+            }
+            param.ldb = ldb;
+        }
+
+        engine_test_fill(input, num, in_single, true);
+        engine_test_fill(result, num, out_single, false);
+        engine_test_fill(expect, num, false, false);
+        engine_test_reference(&param, input, alpha, update ? beta : 0.0,
+                expect);
+
+        ret = ttc_transpose(handler, &param, input, result);
+        ttc_release(handler);
+        if (0 != ret) {
+            TEST_ERR_OUTPUT("Transpose failed.");
+            break;
+        }
+        ret = engine_test_compare(result, expect, num, out_single);
+    }
+
+    free(input);
+    free(result);
+    free(expect);
+
+    return ret;
+}
+
+
+int32_t
+store_test(
+        ttc_datatype_e  type
+        ) {
+    uint32_t ncomp;
+    bool in_single, out_single;
+    engine_test_type(type, &ncomp, &in_single, &out_single);
+
+    // Contiguous rows of at least 4 KiB, which may be streamed
+    uint32_t perm[TENSOR_DIM] = { 0, 2, 1 };
+    uint32_t size[TENSOR_DIM] = { 1024, 3, 5 };
+    uint64_t num = 1024 * 3 * 5 * ncomp;
+    double alpha = 2.0;
+    ttc_store_e stores[3]
+        = { TTC_STORE_AUTO, TTC_STORE_CACHED, TTC_STORE_STREAM };
+
+    void *input, *result;
+    double *expect;
+    if (0 != engine_test_alloc(num * (in_single ? 4 : 8),
+                num * (out_single ? 4 : 8), num * sizeof(double), &input,
+                &result, (void **)&expect))
+        return -1;
+    ttc_handler_s *handler = engine_test_handler(TTC_ENGINE_GENERIC);
+    if (NULL == handler) {
+        free(input);
+        free(result);
+        free(expect);
+        return -1;
+    }
+
+    ttc_param_s param = ttc_default_param();
+    param.datatype = type;
+    param.dim = TENSOR_DIM;
+    param.perm = perm;
+    param.size = size;
+    engine_test_scalars(&param, alpha, 0.0);
+
+    engine_test_fill(input, num, in_single, true);
+    engine_test_fill(expect, num, false, false);
+    engine_test_reference(&param, input, alpha, 0.0, expect);
+
+    // The hints share the plan of the handler
+    int32_t ret = 0;
+    uint32_t test_idx;
+    for (test_idx = 0; 0 == ret && test_idx < 3; ++test_idx) {
+        param.store = stores[test_idx];
+        engine_test_fill(result, num, out_single, false);
+
+        ret = ttc_transpose(handler, &param, input, result);
+        if (0 != ret) {
+            TEST_ERR_OUTPUT("Transpose failed.");
+            break;
+        }
+        ret = engine_test_compare(result, expect, num, out_single);
+    }
+
+    free(input);
+    free(result);
+    free(expect);
+    ttc_release(handler);
+
+    return ret;
+}
+
+
+int32_t
+align_test(
+        ) {
+    ttc_handler_s *handler = engine_test_handler(TTC_ENGINE_JIT);
+    ttc_handler_s *reference = engine_test_handler(TTC_ENGINE_GENERIC);
+    if (NULL == handler || NULL == reference) {
+        ttc_release(handler);
+        ttc_release(reference);
+        return -1;
+    }
+
+    ttc_param_s param = ttc_default_param();
+    param.dim = TENSOR_DIM;
+    uint32_t perm[TENSOR_DIM] = { 1, 0, 2 };
+    uint32_t size[TENSOR_DIM]
+        = { TENSOR_SIZE_0, TENSOR_SIZE_1, TENSOR_SIZE_2 };
+    param.perm = perm;
+    param.size = size;
+
+    // One spare element for the unaligned calls
+    const uint64_t bytes = sizeof(float) * (TENSOR_SIZE + 1);
+    float *input, *result, *expect;
+    if (0 != engine_test_alloc(bytes, bytes, bytes, (void **)&input,
+                (void **)&result, (void **)&expect)) {
+        ttc_release(handler);
+        ttc_release(reference);
+        return -1;
+    }
+    engine_test_fill(input, TENSOR_SIZE + 1, true, true);
+
+    // Aligned, unaligned and aligned again, on the same plan
+    int32_t ret = 0;
+    uint32_t offsets[3] = { 0, 1, 0 }, idx;
+    for (idx = 0; 0 == ret && idx < 3; ++idx) {
+        const uint32_t off = offsets[idx];
+        if (0 != ttc_transpose(handler, &param, input + off, result + off)
+            || 0 != ttc_transpose(reference, &param, input + off,
+                expect + off)) {
+            TEST_ERR_OUTPUT("Transpose failed.");
+            ret = -1;
+        }
+        else if (0 != memcmp(result + off, expect + off,
+                    sizeof(float) * TENSOR_SIZE)) {
+            TEST_ERR_OUTPUT("Result mismatches the reference.");
+            ret = -1;
+        }
+    }
+
+    free(input);
+    free(result);
+    free(expect);
+    ttc_release(handler);
+    ttc_release(reference);
+
+    return ret;
+}
+
+
+int32_t
+align_fail_test(
+        ) {
+    ttc_handler_s *handler = engine_test_handler(TTC_ENGINE_JIT);
+    ttc_handler_s *reference = engine_test_handler(TTC_ENGINE_GENERIC);
+    ttc_arch_e arch = TTC_ARCH_AVX;
+    ttc_compiler_e compiler = TTC_CMP_GXX;
+    if (NULL == handler || NULL == reference
+        || 0 != ttc_set_opt(handler, TTC_OPT_ARCH, &arch, 0)
+        || 0 != ttc_set_opt(handler, TTC_OPT_COMPILER, &compiler, 0)) {
+        TEST_ERR_OUTPUT("Cannot create handler.");
+        ttc_release(handler);
+        ttc_release(reference);
+        return -1;
+    }
+
+    // A small tensor of aligned rows, so that the aligned call runs the
+    // aligned kernel of the plan itself
+    ttc_param_s param = ttc_default_param();
+    param.dim = TENSOR_DIM;
+    uint32_t perm[TENSOR_DIM] = { 1, 0, 2 };
+    uint32_t size[TENSOR_DIM] = { 40, 32, 9 };
+    param.perm = perm;
+    param.size = size;
+    const uint64_t num = 40 * 32 * 9;
+    const uint64_t bytes = sizeof(float) * (num + 1);
+    float *input, *result, *expect;
+    if (0 != engine_test_alloc(bytes, bytes, bytes, (void **)&input,
+                (void **)&result, (void **)&expect)) {
+        ttc_release(handler);
+        ttc_release(reference);
+        return -1;
+    }
+    engine_test_fill(input, num + 1, true, true);
+
+    int32_t ret = 0;
+    ttc_plan_s *plan = NULL;
+    if (0 != ttc_transpose(handler, &param, input, result)
+        || NULL == (plan = ttc_lookup_plan(handler, &param))
+        || TTC_ENGINE_JIT != plan->engine
+        || 0 != (plan->status & TTC_NO_ALIGN)) {
+        TEST_ERR_OUTPUT("No aligned kernel is generated.");
+        ret = -1;
+    }
+
+    // The compiler icpc is not available, so the unaligned variant cannot
+    // be created, the unaligned call must not run the aligned kernel
+    compiler = TTC_CMP_ICPC;
+    if (0 == ret
+        && (0 != ttc_set_opt(handler, TTC_OPT_COMPILER, &compiler, 0)
+            || 0 != ttc_transpose(handler, &param, input + 1, result + 1)
+            || 0 != ttc_transpose(reference, &param, input + 1,
+                expect + 1))) {
+        TEST_ERR_OUTPUT("Transpose failed.");
+        ret = -1;
+    }
+    else if (0 == ret && 0 != memcmp(result + 1, expect + 1,
+                sizeof(float) * num)) {
+        TEST_ERR_OUTPUT("Result mismatches the reference.");
+        ret = -1;
+    }
+    else if (0 == ret && (NULL == plan->align_plan
+                || TTC_ENGINE_JIT == plan->align_plan->engine)) {
+        TEST_ERR_OUTPUT("The unaligned call does not run a built-in engine.");
+        ret = -1;
+    }
+
+    free(input);
+    free(result);
+    free(expect);
+    ttc_release(handler);
+    ttc_release(reference);
+
+    return ret;
+}
+
+
+int32_t
+retune_test(
+        ) {
+    ttc_handler_s *handler = engine_test_handler(TTC_ENGINE_JIT);
+    ttc_handler_s *reference = engine_test_handler(TTC_ENGINE_GENERIC);
+    ttc_arch_e arch = TTC_ARCH_AVX;
+    ttc_compiler_e compiler = TTC_CMP_GXX;
+    uint32_t retune = 50;
+    if (NULL == handler || NULL == reference
+        || 0 != ttc_set_opt(handler, TTC_OPT_ARCH, &arch, 0)
+        || 0 != ttc_set_opt(handler, TTC_OPT_COMPILER, &compiler, 0)
+        || 0 != ttc_set_opt(handler, TTC_OPT_RETUNE, &retune, 0)) {
+        TEST_ERR_OUTPUT("Cannot create handler.");
+        ttc_release(handler);
+        ttc_release(reference);
+        return -1;
+    }
+
+    ttc_param_s param = ttc_default_param();
+    param.dim = TENSOR_DIM;
+    uint32_t perm[TENSOR_DIM] = { 1, 0, 2 };
+    uint32_t size[TENSOR_DIM]
+        = { TENSOR_SIZE_0, TENSOR_SIZE_1, TENSOR_SIZE_2 };
+    param.perm = perm;
+    param.size = size;
+
+    // A record of another size, which no plan can reach
+    uint32_t record_size[TENSOR_DIM] = { 8, 8, 8 };
+    ttc_tune_s record = { .datatype = TTC_TYPE_DEFAULT, .dim = TENSOR_DIM,
+        .perm = perm, .size = record_size, .loop_perm = NULL,
+        .num_threads = 1, .blocking = { 0, 0 }, .pref_dist = -1,
+        .status = 0, .max_impl = 1, .bandwidth = 1e6, .next = NULL };
+
+    const uint64_t bytes = sizeof(float) * (TENSOR_SIZE + 1);
+    float *input, *result, *expect;
+    if (0 != ttc_tune_insert(handler, &record, true)
+        || 0 != engine_test_alloc(bytes, bytes, bytes, (void **)&input,
+            (void **)&result, (void **)&expect)) {
+        TEST_ERR_OUTPUT("Cannot prepare the test.");
+        ttc_release(handler);
+        ttc_release(reference);
+        return -1;
+    }
+    engine_test_fill(input, TENSOR_SIZE + 1, true, true);
+
+    // The unaligned calls run the variant until it is re-tuned
+    int32_t ret = 0;
+    uint32_t idx;
+    for (idx = 0; 0 == ret && idx < TTC_RETUNE_MIN_CALLS; ++idx)
+        ret = ttc_transpose(handler, &param, input + 1, result + 1);
+    ttc_plan_s *plan = 0 == ret ? ttc_lookup_plan(handler, &param) : NULL;
+    ttc_plan_s *variant = NULL == plan ? NULL : plan->align_plan;
+    ttc_retune_s *job = NULL == variant ? NULL
+        : (ttc_retune_s *)variant->retune;
+    if (NULL == job) {
+        TEST_ERR_OUTPUT("No re-tuning job is started on the variant.");
+        ret = -1;
+    }
+    else if (0 == (job->options.status & TTC_NO_ALIGN) || 0 != job->mask) {
+        TEST_ERR_OUTPUT("The job does not keep the status of the variant.");
+        ret = -1;
+    }
+
+    // The variant runs its kernel, replaced or not, while the job is still
+    // running. Releasing the job closes the library of a replaced kernel,
+    // after that only the status is checked.
+    if (0 == ret
+        && (0 != ttc_transpose(handler, &param, input + 1, result + 1)
+            || 0 != ttc_transpose(reference, &param, input + 1,
+                expect + 1))) {
+        TEST_ERR_OUTPUT("Transpose failed.");
+        ret = -1;
+    }
+    else if (0 == ret && 0 != memcmp(result + 1, expect + 1,
+                sizeof(float) * TENSOR_SIZE)) {
+        TEST_ERR_OUTPUT("Result mismatches the reference.");
+        ret = -1;
+    }
+    if (NULL != job) {
+        ttc_retune_release(job);
+        variant->retune = NULL;
+        if (0 == (variant->status & TTC_NO_ALIGN)) {
+            TEST_ERR_OUTPUT("The variant lost TTC_NO_ALIGN.");
+            ret = -1;
+        }
+    }
+
+    // Residency and store variants keep their stores and hot flags, as does
+    // a base plan with a store variant
+    ttc_plan_s other = { .status = TTC_USE_STM_STORE | TTC_HOT_A | TTC_HOT_B,
+        .store_plan = NULL };
+    ttc_opt_s options;
+    if (0 != ttc_retune_options(&handler->options, &other, true, &options)
+        || options.status != other.status) {
+        TEST_ERR_OUTPUT("The options of a variant are not kept.");
+        ret = -1;
+    }
+    other.store_plan = &other;
+    if (0 != ttc_retune_options(&handler->options, &other, false, &options)
+        || options.status != other.status) {
+        TEST_ERR_OUTPUT("The stores of a plan with a variant are tuned.");
+        ret = -1;
+    }
+
+    // A base plan takes the store bit from the handler, and keeps the rest
+    if (NULL != plan) {
+        ttc_opt_s handler_options = handler->options;
+        handler_options.status = TTC_USE_STM_STORE;
+        ttc_plan_s base = *plan;
+        base.store_plan = NULL;
+        const uint32_t status = base.status;
+        if (TTC_TUNE_STATUS_MASK != ttc_retune_options(&handler_options,
+                    &base, false, &options)
+            || options.status != ((status & ~TTC_USE_STM_STORE)
+                | TTC_USE_STM_STORE)) {
+            TEST_ERR_OUTPUT("The options of a base plan are not kept.");
+            ret = -1;
+        }
+    }
+
+    free(input);
+    free(result);
+    free(expect);
+    ttc_release(handler);
+    ttc_release(reference);
+
+    return ret;
+}
+
+
+int32_t
+grid_test(
+        ) {
+    ttc_handler_s *handler = engine_test_handler(TTC_ENGINE_JIT);
+    ttc_handler_s *reference = engine_test_handler(TTC_ENGINE_GENERIC);
+    ttc_arch_e arch = TTC_ARCH_AVX;
+    ttc_compiler_e compiler = TTC_CMP_GXX;
+    uint32_t grid = 32;
+    if (NULL == handler || NULL == reference
+        || 0 != ttc_set_opt(handler, TTC_OPT_ARCH, &arch, 0)
+        || 0 != ttc_set_opt(handler, TTC_OPT_COMPILER, &compiler, 0)
+        || 0 != ttc_set_opt(handler, TTC_OPT_GRID, &grid, 0)) {
+        TEST_ERR_OUTPUT("Cannot create handler.");
+        ttc_release(handler);
+        ttc_release(reference);
+        return -1;
+    }
+
+    // Both sizes have the tile 32 x 32 x 8 and edge slabs. The tensors are
+    // small and their rows aligned, so that the plans run their own kernels
+    // instead of variants.
+    uint32_t perm[TENSOR_DIM] = { 1, 0, 2 };
+    uint32_t sizes[3][TENSOR_DIM] = { { 40, 32, 9 }, { 32, 40, 9 },
+        { 32, 40, 9 } };
+    double betas[3] = { 0.0, 0.5, 0.0 };
+    const uint64_t num = 40 * 32 * 9;
+    float *input, *result, *expect;
+    if (0 != engine_test_alloc(sizeof(float) * num, sizeof(float) * num,
+                sizeof(float) * num, (void **)&input, (void **)&result,
+                (void **)&expect)) {
+        ttc_release(handler);
+        ttc_release(reference);
+        return -1;
+    }
+    engine_test_fill(input, num, true, true);
+
+    int32_t ret = 0;
+    uint32_t idx;
+    for (idx = 0; 0 == ret && idx < 3; ++idx) {
+        ttc_param_s param = ttc_default_param();
+        param.dim = TENSOR_DIM;
+        param.perm = perm;
+        param.size = sizes[idx];
+        param.alpha.s = 2.0;
+        param.beta.s = betas[idx];
+        engine_test_fill(result, num, true, false);
+        engine_test_fill(expect, num, true, false);
+        if (0 != ttc_transpose(handler, &param, input, result)
+            || 0 != ttc_transpose(reference, &param, input, expect)) {
+            TEST_ERR_OUTPUT("Transpose failed.");
+            ret = -1;
+        }
+        else if (0 != memcmp(result, expect, sizeof(float) * num)) {
+            TEST_ERR_OUTPUT("Result mismatches the reference.");
+            ret = -1;
+        }
+    }
+
+    free(input);
+    free(result);
+    free(expect);
+    ttc_release(handler);
+    ttc_release(reference);
+
+    return ret;
+}
+
+int32_t
+inplace_test(
+        ttc_datatype_e  type
+        ) {
+    uint32_t ncomp;
+    bool in_single, out_single;
+    engine_test_type(type, &ncomp, &in_single, &out_single);
+    uint32_t in_size = (in_single ? 4 : 8) * ncomp;
+    uint32_t out_size = (out_single ? 4 : 8) * ncomp;
+
+    // A plane of short cycles and a tensor of long ones, then the latter
+    // with an output shifted into the input, and an input shifted into the
+    // output
+    uint32_t perms[4][TENSOR_DIM] = { { 1, 0, 2 }, { 2, 0, 1 }, { 2, 0, 1 },
+        { 2, 0, 1 } };
+    uint32_t sizes[4][TENSOR_DIM] = { { 64, 64, 3 }, { 67, 45, 9 },
+        { 67, 45, 9 }, { 67, 45, 9 } };
+    uint32_t in_shifts[4] = { 0, 0, 0, 7 };
+    uint32_t out_shifts[4] = { 0, 0, 5, 0 };
+    uint64_t elem = 67 * 45 * 9;
+    double alpha = 2.0, beta = 0.5;
+
+    // Room for both precisions and the shift
+    uint32_t max_size = in_size > out_size ? in_size : out_size;
+    uint64_t buffer_num = (elem + 8) * max_size / in_size * ncomp;
+    char *buffer, *unused;
+    double *expect;
+    if (0 != engine_test_alloc((elem + 8) * max_size, 0,
+                elem * ncomp * sizeof(double), (void **)&buffer,
+                (void **)&unused, (void **)&expect))
+        return -1;
+    ttc_handler_s *handler = ttc_init();
+    if (NULL == handler) {
+        TEST_ERR_OUTPUT("Cannot create handler.");
+        free(buffer);
+        free(expect);
+        return -1;
+    }
+
+    int32_t ret = 0;
+    uint32_t test_idx;
+    for (test_idx = 0; 0 == ret && test_idx < 4; ++test_idx) {
+        void *input = buffer + in_shifts[test_idx] * in_size;
+        void *result = buffer + out_shifts[test_idx] * out_size;
+        bool update = 1 == test_idx || 3 == test_idx;
+        // beta scales the output, which is the input in place
+        update = update && in_size == out_size;
+
+        ttc_param_s param = ttc_default_param();
+        param.datatype = type;
+        param.dim = TENSOR_DIM;
+        param.perm = perms[test_idx];
+        param.size = sizes[test_idx];
+        engine_test_scalars(&param, alpha, update ? beta : 0.0);
+
+        // An updated element is the element at its position before the call
+        uint32_t *size = sizes[test_idx];
+        uint64_t num = (uint64_t)size[0] * size[1] * size[2] * ncomp, pos;
+        engine_test_fill(buffer, buffer_num, in_single, true);
+        for (pos = 0; pos < num; ++pos)
+            expect[pos] = update ? engine_test_load(result, pos, out_single)
+                : 0.0;
+        engine_test_reference(&param, input, alpha, update ? beta : 0.0,
+                expect);
+
+        ret = ttc_transpose(handler, &param, input, result);
+        if (0 != ret) {
+            TEST_ERR_OUTPUT("Transpose failed.");
+            break;
+        }
+        ret = engine_test_compare(result, expect, num, out_single);
+    }
+
+    free(buffer);
+    free(expect);
+    ttc_release(handler);
+
+    return ret;
+}
+
+
+int32_t
+wide_test(
+        ttc_datatype_e  type
+        ) {
+    uint32_t ncomp;
+    bool in_single, out_single;
+    engine_test_type(type, &ncomp, &in_single, &out_single);
+    uint32_t in_size = (in_single ? 4 : 8) * ncomp;
+    uint32_t out_size = (out_single ? 4 : 8) * ncomp;
+
+    // The output is padded along its dimension 1, the last leading
+    // dimensions only make the parameters wide. The reference reads the
+    // same transposition with 32-bit parameters.
+    uint32_t perm[TENSOR_DIM] = { 2, 0, 1 };
+    uint64_t size[TENSOR_DIM] = { 67, 45, 9 };
+    int64_t lda[TENSOR_DIM] = { 67, 45, (int64_t)1 << 33 };
+    int64_t ldb[TENSOR_DIM] = { 9, 70, (int64_t)1 << 33 };
+    uint32_t narrow_size[TENSOR_DIM] = { 67, 45, 9 };
+    int32_t narrow_lda[TENSOR_DIM] = { 67, 45, 9 };
+    int32_t narrow_ldb[TENSOR_DIM] = { 9, 70, 45 };
+    uint64_t elem_a = 67 * 45 * 9, elem_b = 9 * 70 * 45;
+    double alpha = 2.0, beta = 0.5;
+    ttc_engine_e jit = TTC_ENGINE_JIT;
+
+    uint32_t max_size = in_size > out_size ? in_size : out_size;
+    char *buffer, *output;
+    double *expect;
+    if (0 != engine_test_alloc((elem_b + 8) * max_size, elem_b * out_size,
+                elem_b * ncomp * sizeof(double), (void **)&buffer,
+                (void **)&output, (void **)&expect))
+        return -1;
+    ttc_handler_s *handler = engine_test_handler(TTC_ENGINE_GENERIC);
+    if (NULL == handler) {
+        free(buffer);
+        free(output);
+        free(expect);
+        return -1;
+    }
+
+    int32_t ret = 0;
+    uint32_t test_idx;
+    for (test_idx = 0; 0 == ret && test_idx < 3; ++test_idx) {
+        bool wide = 0 != test_idx, update = 1 == test_idx;
+        void *result = 2 == test_idx ? buffer + 5 * out_size : output;
+
+        ttc_param64_s param = { .datatype = type, .perm = perm,
+            .size = size, .dim = TENSOR_DIM,
+            .lda = wide ? lda : NULL, .ldb = wide ? ldb : NULL };
+        ttc_param_s narrow = ttc_default_param();
+        narrow.datatype = type;
+        narrow.dim = TENSOR_DIM;
+        narrow.perm = perm;
+        narrow.size = narrow_size;
+        narrow.lda = wide ? narrow_lda : NULL;
+        narrow.ldb = wide ? narrow_ldb : NULL;
+        engine_test_scalars(&narrow, alpha, update ? beta : 0.0);
+        param.alpha = narrow.alpha;
+        param.beta = narrow.beta;
+
+        // The padding of the output keeps the elements before the call
+        uint64_t num = (wide ? elem_b : elem_a) * ncomp, pos;
+        engine_test_fill(buffer, (elem_b + 8) * max_size / in_size * ncomp,
+                in_single, true);
+        engine_test_fill(output, elem_b * ncomp, out_single, false);
+        for (pos = 0; pos < num; ++pos)
+            expect[pos] = engine_test_load(result, pos, out_single);
+        engine_test_reference(&narrow, buffer, alpha, update ? beta : 0.0,
+                expect);
+
+        ret = ttc_transpose64(handler, &param, buffer, result);
+        if (0 != ret) {
+            TEST_ERR_OUTPUT("Transpose failed.");
+            break;
+        }
+        ret = engine_test_compare(result, expect, num, out_single);
+
+    }
+
+    // Only the parameters of the large tensor are needed for the estimate
+    uint32_t large_perm[TENSOR_DIM] = { 1, 0, 2 };
+    uint32_t large_size[TENSOR_DIM] = { 65536, 65536, 1 };
+    ttc_param_s large = ttc_default_param();
+    large.datatype = type;
+    large.dim = TENSOR_DIM;
+    large.perm = large_perm;
+    large.size = large_size;
+    ttc_estimate_s estimate;
+    if (0 == ret
+        && (0 != ttc_set_opt(handler, TTC_OPT_ENGINE, &jit, 0)
+            || 0 != ttc_estimate(handler, &large, &estimate)
+            || TTC_ENGINE_JIT == estimate.engine)) {
+        TEST_ERR_OUTPUT("A large tensor is predicted on a kernel of TTC.");
+        ret = -1;
+    }
+
+    free(buffer);
+    free(output);
+    free(expect);
+    ttc_release(handler);
+
+    return ret;
+}
+
+
+/**
+ * @brief Create a handler with the automatic engine, without tuning records
+ * and on an uncalibrated machine of the default bandwidth, so that the
+ * predictions do not depend on the machine running the test.
+ */
+static ttc_handler_s *
+engine_test_model_handler(
+        ) {
+    ttc_handler_s *handler = engine_test_handler(TTC_ENGINE_AUTO);
+    if (NULL == handler)
+        return NULL;
+
+    ttc_tune_release(handler->tunes);
+    handler->tunes = NULL;
+    ttc_hw_release(&handler->hw);
+    handler->hw.bandwidth = TTC_HW_BW_DEFAULT;
+
+    return handler;
+}
+
+
+int32_t
+tune_db_test(
+        ) {
+    char path[] = "/tmp/ttc-tune-XXXXXX";
+    int fd = mkstemp(path);
+    if (-1 == fd) {
+        TEST_ERR_OUTPUT("Cannot create tuning database.");
+        return -1;
+    }
+    close(fd);
+    // The database is written with its header line
+    unlink(path);
+
+    // A record of every field, then a slower one of the same signature
+    uint32_t perm[TENSOR_DIM] = { PERM_0, PERM_1, PERM_2 };
+    uint32_t size[TENSOR_DIM]
+        = { TENSOR_SIZE_0, TENSOR_SIZE_1, TENSOR_SIZE_2 };
+    uint32_t loop_perm[TENSOR_DIM] = { 2, 1, 0 };
+    ttc_tune_s tune = { .datatype = TTC_TYPE_S, .dim = TENSOR_DIM,
+        .perm = perm, .size = size, .loop_perm = loop_perm,
+        .num_threads = 4, .blocking = { 16, 8 }, .pref_dist = 5,
+        .status = TTC_USE_STM_STORE, .max_impl = 7, .bandwidth = 21.5,
+        .next = NULL };
+    ttc_tune_s slow = tune;
+    slow.loop_perm = NULL;
+    slow.num_threads = 2;
+    slow.bandwidth = 10.0;
+    int32_t ret = 0;
+    if (0 != ttc_tune_save(path, &tune) || 0 != ttc_tune_save(path, &slow)) {
+        TEST_ERR_OUTPUT("Cannot save tuning records.");
+        ret = -1;
+    }
+
+    // A line of an older database without max_impl, and a malformed line
+    FILE *db_file = 0 == ret ? fopen(path, "a") : NULL;
+    if (0 == ret && NULL == db_file) {
+        TEST_ERR_OUTPUT("Cannot open tuning database.");
+        ret = -1;
+    }
+    if (NULL != db_file) {
+        fprintf(db_file, "%d,1:0,32:16,-,0,-,-,0,3.5\n", TTC_TYPE_D);
+        fprintf(db_file, "%d,1:0,xyz\n", TTC_TYPE_D);
+        fclose(db_file);
+    }
+
+    ttc_handler_s *handler = 0 == ret ? engine_test_model_handler() : NULL;
+    if (0 == ret && NULL == handler)
+        ret = -1;
+    if (0 == ret && 3 != ttc_tune_load(handler, path)) {
+        TEST_ERR_OUTPUT("The tuning database is not loaded.");
+        ret = -1;
+    }
+
+    // The faster record of the signature is kept with all its fields
+    ttc_param_s param = ttc_default_param();
+    param.datatype = TTC_TYPE_S;
+    param.dim = TENSOR_DIM;
+    param.perm = perm;
+    param.size = size;
+    const ttc_tune_s *lookup = 0 == ret
+        ? ttc_tune_lookup(handler, &param) : NULL;
+    if (0 == ret && (NULL == lookup || NULL == lookup->loop_perm
+            || 0 != memcmp(lookup->loop_perm, loop_perm, sizeof(loop_perm))
+            || 4 != lookup->num_threads || 16 != lookup->blocking[0]
+            || 8 != lookup->blocking[1] || 5 != lookup->pref_dist
+            || TTC_USE_STM_STORE != lookup->status || 7 != lookup->max_impl
+            || 21.5 != lookup->bandwidth)) {
+        TEST_ERR_OUTPUT("The saved record is not loaded back.");
+        ret = -1;
+    }
+
+    // The missing max_impl defaults to 1, `-` to the choice of TTC
+    uint32_t old_perm[2] = { 1, 0 }, old_size[2] = { 32, 16 };
+    param.datatype = TTC_TYPE_D;
+    param.dim = 2;
+    param.perm = old_perm;
+    param.size = old_size;
+    lookup = 0 == ret ? ttc_tune_lookup(handler, &param) : NULL;
+    if (0 == ret && (NULL == lookup || 1 != lookup->max_impl
+            || NULL != lookup->loop_perm || 0 != lookup->num_threads
+            || 0 != lookup->blocking[0] || -1 != lookup->pref_dist
+            || 3.5 != lookup->bandwidth)) {
+        TEST_ERR_OUTPUT("The record without max_impl is not loaded.");
+        ret = -1;
+    }
+
+    ttc_release(handler);
+    unlink(path);
+
+    return ret;
+}
+
+
+int32_t
+transfer_test(
+        ) {
+    ttc_handler_s *handler = engine_test_model_handler();
+    if (NULL == handler)
+        return -1;
+
+    // Records of two sizes, and a large one
+    uint32_t perm[2] = { 1, 0 };
+    uint32_t sizes[3][2] = { { 1024, 1024 }, { 2048, 1024 },
+        { 16384, 16384 } };
+    ttc_tune_s tune = { .datatype = TTC_TYPE_S, .dim = 2, .perm = perm,
+        .loop_perm = NULL, .num_threads = 0, .blocking = { 0, 0 },
+        .pref_dist = -1, .status = 0, .max_impl = 1, .bandwidth = 10.0,
+        .next = NULL };
+    int32_t ret = 0;
+    uint32_t idx;
+    for (idx = 0; 0 == ret && idx < 3; ++idx) {
+        tune.size = sizes[idx];
+        if (0 != ttc_tune_insert(handler, &tune, false)) {
+            TEST_ERR_OUTPUT("Cannot insert tuning record.");
+            ret = -1;
+        }
+    }
+
+    // The nearest record is transferred, a size farther than
+    // TTC_TUNE_NEAR_MAX, another permutation or data type gets none. A
+    // distance of 0.38 on a tensor of 3 GB is worth a full search.
+    uint32_t query[6][2] = { { 1100, 1000 }, { 1900, 1024 }, { 4096, 4096 },
+        { 1100, 1000 }, { 1100, 1000 }, { 24000, 16384 } };
+    uint32_t other_perm[2] = { 0, 1 };
+    const uint32_t *expect[6] = { sizes[0], sizes[1], NULL, NULL, NULL,
+        NULL };
+    for (idx = 0; 0 == ret && idx < 6; ++idx) {
+        ttc_param_s param = ttc_default_param();
+        param.datatype = 4 == idx ? TTC_TYPE_D : TTC_TYPE_S;
+        param.dim = 2;
+        param.perm = 3 == idx ? other_perm : perm;
+        param.size = query[idx];
+        const ttc_tune_s *transfer = ttc_tune_transfer(handler, &param);
+        bool match = NULL == expect[idx] ? NULL == transfer
+            : NULL != transfer && 0 == memcmp(transfer->size, expect[idx],
+                    sizeof(uint32_t) * 2);
+        if (!match) {
+            TEST_ERR_OUTPUT("Wrong tuning record transferred.");
+            ret = -1;
+        }
+    }
+
+    ttc_release(handler);
+
+    return ret;
+}
+
+
+int32_t
+model_test(
+        ) {
+    ttc_handler_s *handler = engine_test_model_handler();
+    if (NULL == handler)
+        return -1;
+
+    // An identity copy, a batch of rows, a scattering 6-D permutation, a
+    // small transposition with a tuning record, a small one without and a
+    // large one amortizing the generation of a kernel
+    uint32_t perm[6][6] = { { 0, 1, 2 }, { 0, 2, 1 }, { 5, 3, 1, 4, 2, 0 },
+        { 1, 0 }, { 1, 0 }, { 1, 0 } };
+    uint32_t size[6][6] = { { 64, 32, 16 }, { 64, 32, 16 },
+        { 5, 6, 4, 6, 3, 7 }, { 64, 64 }, { 96, 64 }, { 8192, 8192 } };
+    uint32_t dim[6] = { 3, 3, 6, 2, 2, 2 };
+    ttc_engine_e engine[6] = { TTC_ENGINE_COPY, TTC_ENGINE_GENERIC,
+        TTC_ENGINE_MULTIPASS, TTC_ENGINE_JIT, TTC_ENGINE_GENERIC,
+        TTC_ENGINE_JIT };
+    ttc_tune_s tune = { .datatype = TTC_TYPE_S, .dim = 2, .perm = perm[3],
+        .size = size[3], .loop_perm = NULL, .num_threads = 0,
+        .blocking = { 0, 0 }, .pref_dist = -1, .status = 0, .max_impl = 1,
+        .bandwidth = 10.0, .next = NULL };
+    int32_t ret = 0;
+    if (0 != ttc_tune_insert(handler, &tune, false)) {
+        TEST_ERR_OUTPUT("Cannot insert tuning record.");
+        ret = -1;
+    }
+
+    uint32_t idx;
+    ttc_estimate_s estimate;
+    for (idx = 0; 0 == ret && idx < 6; ++idx) {
+        ttc_param_s param = ttc_default_param();
+        param.datatype = TTC_TYPE_S;
+        param.dim = dim[idx];
+        param.perm = perm[idx];
+        param.size = size[idx];
+        if (0 != ttc_estimate(handler, &param, &estimate)
+            || engine[idx] != estimate.engine || !(estimate.time > 0.0)
+            || (TTC_ENGINE_JIT == engine[idx]) != (estimate.setup > 0.0)) {
+            TEST_ERR_OUTPUT("Wrong engine chosen by the model.");
+            ret = -1;
+        }
+    }
+
+    // The plan of the rows keeps its engine and has no setup cost
+    void *input, *result, *expect;
+    uint64_t num = 64 * 32 * 16;
+    ttc_param_s param = ttc_default_param();
+    param.datatype = TTC_TYPE_S;
+    param.dim = dim[1];
+    param.perm = perm[1];
+    param.size = size[1];
+    if (0 == ret && 0 != engine_test_alloc(num * sizeof(float),
+                num * sizeof(float), 0, &input, &result, &expect))
+        ret = -1;
+    else if (0 == ret) {
+        engine_test_fill(input, num, true, true);
+        if (0 != ttc_transpose(handler, &param, input, result)
+            || 0 != ttc_estimate(handler, &param, &estimate)
+            || TTC_ENGINE_GENERIC != estimate.engine
+            || 0.0 != estimate.setup) {
+            TEST_ERR_OUTPUT("Wrong estimate of an existing plan.");
+            ret = -1;
+        }
+        free(input);
+        free(result);
+    }
+
+    ttc_release(handler);
+
+    return ret;
+}
@@ -37,7 +37,7 @@
 
 
 
-char common_prefix[TEST_GEN_BUF_SIZE];
+extern char common_prefix[TEST_GEN_BUF_SIZE];
 
 
 #ifdef __CPLUSPLUS
@@ -58,6 +58,67 @@ reuse_test(
         );
 
 
+/**
+ * @brief Alignment test.
+ *
+ * @details A kernel of TTC is called with aligned tensors, with tensors one
+ * element off the alignment and with aligned tensors again, and compared
+ * with the generic engine.
+ *
+ * @return The status, 0 if succeed, non-zero if failed.
+ */
+int32_t
+align_test(
+        );
+
+
+/**
+ * @brief Alignment test without the unaligned variant.
+ *
+ * @details After an aligned call has generated the aligned kernel of a plan,
+ * the compiler is switched to an unavailable one, so that the unaligned
+ * variant cannot be created. The unaligned call must run a built-in engine
+ * instead of the aligned kernel, and is compared with the generic engine.
+ *
+ * @return The status, 0 if succeed, non-zero if failed.
+ */
+int32_t
+align_fail_test(
+        );
+
+
+/**
+ * @brief Re-tuning test of an alignment variant.
+ *
+ * @details A tuning record of a much higher bandwidth makes the unaligned
+ * calls start a re-tuning job on the `--no-align` variant. The job must keep
+ * `TTC_NO_ALIGN` and must not sweep the store bit, the variant must keep it
+ * after the job, and the result must still match the generic engine. The
+ * residency and store variants, and a plan with a store variant, keep all
+ * their bits, any other plan only takes the store bit from the handler.
+ *
+ * @return The status, 0 if succeed, non-zero if failed.
+ */
+int32_t
+retune_test(
+        );
+
+
+/**
+ * @brief Grid plan test.
+ *
+ * @details Plans of two sizes with the same tile are created with beta 0,
+ * then with beta 0.5 and then with beta 0 again, and compared with the
+ * generic engine. A plan must only share the tile kernel of a plan whose
+ * beta is zero if and only if its own is.
+ *
+ * @return The status, 0 if succeed, non-zero if failed.
+ */
+int32_t
+grid_test(
+        );
+
+
 /**
  * @brief Data type test.
  *
@@ -122,6 +183,170 @@ no_beta_test(
         );
 
 
+/**
+ * @brief Built-in engine test.
+ *
+ * @details The transpositions are executed with the given engine and
+ * compared with a reference, for several permutations including skinny
+ * ones, with and without leading dimensions and beta.
+ *
+ * @param[in] type      Tensor data type to be tested.
+ * @param[in] engine    TTC_ENGINE_GENERIC or TTC_ENGINE_RECURSIVE.
+ *
+ * @return The status, 0 if succeed, non-zero if failed.
+ */
+int32_t
+engine_test(
+        ttc_datatype_e  type,
+        ttc_engine_e    engine
+        );
+
+
+/**
+ * @brief Multi-pass engine test.
+ *
+ * @details A 6-D transposition scattering every dimension is executed in
+ * passes and compared with a reference, with and without leading dimensions
+ * and beta.
+ *
+ * @param[in] type      Tensor data type to be tested.
+ *
+ * @return The status, 0 if succeed, non-zero if failed.
+ */
+int32_t
+multipass_test(
+        ttc_datatype_e  type
+        );
+
+
+/**
+ * @brief Concurrent execution test.
+ *
+ * @details A multi-pass plan and a generic plan probing the recursive
+ * kernel are executed by several threads at once, each with its own result,
+ * and compared with a reference. The probe must finish.
+ *
+ * @return The status, 0 if succeed, non-zero if failed.
+ */
+int32_t
+concurrent_test(
+        );
+
+
+/**
+ * @brief Cache conflict test.
+ *
+ * @details A transposition of power-of-two sizes, whose output rows conflict
+ * in the caches, is executed by the generic engine with and without beta,
+ * then with the leading dimensions of ttc_suggest_ld, and compared with a
+ * reference.
+ *
+ * @param[in] type      Tensor data type to be tested.
+ *
+ * @return The status, 0 if succeed, non-zero if failed.
+ */
+int32_t
+conflict_test(
+        ttc_datatype_e  type
+        );
+
+
+/**
+ * @brief Store hint test.
+ *
+ * @details A transposition with long contiguous rows is executed by the
+ * generic engine with the store hints TTC_STORE_AUTO, TTC_STORE_CACHED and
+ * TTC_STORE_STREAM on the same plan, and compared with a reference.
+ *
+ * @param[in] type      Tensor data type to be tested.
+ *
+ * @return The status, 0 if succeed, non-zero if failed.
+ */
+int32_t
+store_test(
+        ttc_datatype_e  type
+        );
+
+
+/**
+ * @brief In-place test.
+ *
+ * @details Transpositions whose result is their input (in place for the
+ * same precision, otherwise from a copy), and one whose result is shifted
+ * into the input, are compared with a reference.
+ *
+ * @param[in] type      Tensor data type to be tested.
+ *
+ * @return The status, 0 if succeed, non-zero if failed.
+ */
+int32_t
+inplace_test(
+        ttc_datatype_e  type
+        );
+
+
+/**
+ * @brief 64-bit parameter test.
+ *
+ * @details A transposition given by 64-bit parameters is compared with a
+ * reference, once narrowed to a plan, once with a leading dimension beyond
+ * `INT32_MAX` (on the generic engine, as is the last one, which is not
+ * allocated) and once more with the output shifted into the input. A
+ * tensor of 2^32 elements must not be predicted on a kernel of TTC.
+ *
+ * @param[in] type      Tensor data type to be tested.
+ *
+ * @return The status, 0 if succeed, non-zero if failed.
+ */
+int32_t
+wide_test(
+        ttc_datatype_e  type
+        );
+
+
+/**
+ * @brief Tuning database test.
+ *
+ * @details Records written by ttc_tune_save, a line without the optional
+ * `max_impl` column and a malformed line are loaded back with
+ * ttc_tune_load, the faster record of a signature is kept with all its
+ * fields.
+ *
+ * @return The status, 0 if succeed, non-zero if failed.
+ */
+int32_t
+tune_db_test(
+        );
+
+
+/**
+ * @brief Tuning record transfer test.
+ *
+ * @details ttc_tune_transfer must return the nearest record of the same
+ * data type and permutation, and none for a size too far away or a search
+ * worth its cost.
+ *
+ * @return The status, 0 if succeed, non-zero if failed.
+ */
+int32_t
+transfer_test(
+        );
+
+
+/**
+ * @brief Performance model test.
+ *
+ * @details ttc_estimate must predict the engine the model chooses for
+ * copies, rows, scattering permutations and transpositions with and
+ * without a tuning record, and the engine of an existing plan.
+ *
+ * @return The status, 0 if succeed, non-zero if failed.
+ */
+int32_t
+model_test(
+        );
+
+
 /**
  * @brief No transpose test
  *
@@ -0,0 +1,491 @@
+/**
+ * @file ttc-tune.c
+ *
+ * @brief Offline tuning tool for TTC C API.
+ *
+ * @details It reads a manifest of transpositions, one per line:
+ *
+ * @code
+ * # datatype perm size
+ * s 0,2,1 256,128,64
+ * d 1,0 4096,4096
+ * @endcode
+ *
+ * and measures every combination of the swept options (maximum number of
+ * implementations, blockings, prefetch distances, thread numbers and
+ * streaming stores) for each of them. The bandwidth of every configuration is
+ * written as a tuning database (CSV, loaded by ttc_init, which keeps the best
+ * configuration per shape) or as JSON.
+ *
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <unistd.h>
+
+#include "ttc_c.h"
+#include "ttc_c_util.h"
+#include "ttc_c_tune.h"
+
+
+
+/* ======== Macro ======== */
+
+#define TUNE_BUF_SIZE       1024
+#define TUNE_MAX_DIM        32
+#define TUNE_MAX_VALUES     32
+
+#define TUNE_USAGE                                                          \
+    "Usage: %s [options] <manifest>\n"                                      \
+    "  -o <file>     Output file (default: " TTC_TUNE_DB_DEFAULT ").\n"     \
+    "  -f csv|json   Output format (default: csv).\n"                       \
+    "  -m <list>     Maximum implementations, 0 for all (default: 1).\n"    \
+    "  -b <list>     Blockings, 0x0 for TTC's choice (default: "            \
+    "0x0,8x8,16x16).\n"                                                     \
+    "  -p <list>     Prefetch distances, - for TTC's choice (default: "     \
+    "-,5).\n"                                                               \
+    "  -t <list>     Thread numbers (default: all cores).\n"                \
+    "  -S            Don't try streaming stores.\n"                         \
+    "  -a <arch>     Architecture: avx, avx512 or knc (default: avx).\n"    \
+    "  -c <cmp>      Compiler: g++ or icpc (default: icpc).\n"
+
+
+
+/* ======== Struct definition ======== */
+
+/**
+ * @brief Struct for the swept values.
+ *
+ */
+typedef struct {
+    uint32_t    max_impl[TUNE_MAX_VALUES];
+    uint32_t    max_impl_len;
+
+    uint32_t    blocking[TUNE_MAX_VALUES][2];
+    uint32_t    blocking_len;
+
+    int32_t     pref_dist[TUNE_MAX_VALUES];
+    uint32_t    pref_dist_len;
+
+    uint32_t    num_threads[TUNE_MAX_VALUES];
+    uint32_t    num_threads_len;
+
+    uint32_t    status[2];
+    uint32_t    status_len;
+} tune_sweep_s;
+
+
+
+/* ======== Function declaration ======== */
+
+int32_t
+parse_uint_list(
+        const char  *str,
+        uint32_t    *arr,
+        uint32_t    *length
+        );
+
+
+int32_t
+parse_blocking_list(
+        const char  *str,
+        uint32_t    (*arr)[2],
+        uint32_t    *length
+        );
+
+
+int32_t
+parse_pref_dist_list(
+        const char  *str,
+        int32_t     *arr,
+        uint32_t    *length
+        );
+
+
+int32_t
+parse_datatype(
+        const char      *str,
+        ttc_datatype_e  *datatype
+        );
+
+
+int32_t
+tune_shape(
+        ttc_handler_s       *handler,
+        const ttc_param_s   *param,
+        const tune_sweep_s  *sweep,
+        FILE                *json_file,
+        const char          *csv_path,
+        uint32_t            *num_rows
+        );
+
+
+void
+write_json_row(
+        FILE                *json_file,
+        const ttc_tune_s    *tune,
+        bool                first
+        );
+
+
+
+/* ======== Function definition ======== */
+
+int32_t
+main(
+        int     argc,
+        char    **argv
+        ) {
+    const char *output = TTC_TUNE_DB_DEFAULT;
+    bool json = false;
+    ttc_arch_e arch = TTC_ARCH_AVX;
+    ttc_compiler_e compiler = TTC_CMP_DEFAULT;
+
+    long num_cores = sysconf(_SC_NPROCESSORS_ONLN);
+    tune_sweep_s sweep = {
+        .max_impl = { 1 }, .max_impl_len = 1,
+        .blocking = { { 0, 0 }, { 8, 8 }, { 16, 16 } }, .blocking_len = 3,
+        .pref_dist = { -1, 5 }, .pref_dist_len = 2,
+        .num_threads = { num_cores > 0 ? (uint32_t)num_cores : 0 },
+        .num_threads_len = 1,
+        .status = { 0, TTC_USE_STM_STORE }, .status_len = 2
+    };
+
+    // Parse command line
+    int opt;
+    int32_t ret = 0;
+    while (-1 != (opt = getopt(argc, argv, "o:f:m:b:p:t:Sa:c:h"))) {
+        switch (opt) {
+        case 'o':
+            output = optarg;
+            break;
+        case 'f':
+            json = 0 == strcmp(optarg, "json");
+            if (!json && 0 != strcmp(optarg, "csv"))
+                ret = -1;
+            break;
+        case 'm':
+            ret = parse_uint_list(optarg, sweep.max_impl, &sweep.max_impl_len);
+            break;
+        case 'b':
+            ret = parse_blocking_list(optarg, sweep.blocking,
+                    &sweep.blocking_len);
+            break;
+        case 'p':
+            ret = parse_pref_dist_list(optarg, sweep.pref_dist,
+                    &sweep.pref_dist_len);
+            break;
+        case 't':
+            ret = parse_uint_list(optarg, sweep.num_threads,
+                    &sweep.num_threads_len);
+            break;
+        case 'S':
+            sweep.status_len = 1;
+            break;
+        case 'a':
+            if (0 == strcmp(optarg, "avx"))
+                arch = TTC_ARCH_AVX;
+            else if (0 == strcmp(optarg, "avx512"))
+                arch = TTC_ARCH_AVX512;
+            else if (0 == strcmp(optarg, "knc"))
+                arch = TTC_ARCH_KNC;
+            else
+                ret = -1;
+            break;
+        case 'c':
+            if (0 == strcmp(optarg, "g++"))
+                compiler = TTC_CMP_GXX;
+            else if (0 == strcmp(optarg, "icpc"))
+                compiler = TTC_CMP_ICPC;
+            else
+                ret = -1;
+            break;
+        default:
+            ret = -1;
+            break;
+        }
+
+        if (0 != ret) {
+            fprintf(stderr, TUNE_USAGE, argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (optind + 1 != argc) {
+        fprintf(stderr, TUNE_USAGE, argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE *manifest = fopen(argv[optind], "r");
+    if (NULL == manifest) {
+        fprintf(stderr, "Cannot open manifest %s.\n", argv[optind]);
+        return EXIT_FAILURE;
+    }
+
+    FILE *json_file = NULL;
+    if (json) {
+        json_file = fopen(output, "w");
+        if (NULL == json_file) {
+            fprintf(stderr, "Cannot open output %s.\n", output);
+            fclose(manifest);
+            return EXIT_FAILURE;
+        }
+        fprintf(json_file, "[");
+    }
+
+    ttc_handler_s *handler = ttc_init();
+    if (NULL == handler) {
+        fprintf(stderr, "Cannot initialize TTC handler.\n");
+        fclose(manifest);
+        if (NULL != json_file)
+            fclose(json_file);
+        return EXIT_FAILURE;
+    }
+    ttc_set_opt(handler, TTC_OPT_ARCH, &arch, 1);
+    ttc_set_opt(handler, TTC_OPT_COMPILER, &compiler, 1);
+
+    // Tune every shape in the manifest
+    char line[TUNE_BUF_SIZE];
+    uint32_t line_num = 0, num_rows = 0;
+    while (NULL != fgets(line, TUNE_BUF_SIZE, manifest)) {
+        ++line_num;
+
+        char type_str[TUNE_BUF_SIZE], perm_str[TUNE_BUF_SIZE],
+             size_str[TUNE_BUF_SIZE];
+        if ('#' == line[0]
+            || 3 != sscanf(line, "%s %s %s", type_str, perm_str, size_str))
+            continue;
+
+        uint32_t perm[TUNE_MAX_DIM], size[TUNE_MAX_DIM];
+        uint32_t perm_len = TUNE_MAX_DIM, size_len = TUNE_MAX_DIM;
+        ttc_param_s param = ttc_default_param();
+        if (0 != parse_datatype(type_str, &param.datatype)
+            || 0 != parse_uint_list(perm_str, perm, &perm_len)
+            || 0 != parse_uint_list(size_str, size, &size_len)
+            || perm_len != size_len) {
+            fprintf(stderr, "Skipping malformed line %u.\n", line_num);
+            continue;
+        }
+        param.perm = perm;
+        param.size = size;
+        param.dim = perm_len;
+
+        fprintf(stderr, "Tuning line %u: %s %s %s\n", line_num, type_str,
+                perm_str, size_str);
+        if (0 != tune_shape(handler, &param, &sweep, json_file, output,
+                    &num_rows))
+            fprintf(stderr, "Cannot tune line %u.\n", line_num);
+    }
+
+    if (NULL != json_file) {
+        fprintf(json_file, "\n]\n");
+        fclose(json_file);
+    }
+    fclose(manifest);
+    ttc_release(handler);
+
+    fprintf(stderr, "%u configurations written to %s.\n", num_rows, output);
+
+    return EXIT_SUCCESS;
+}
+
+
+int32_t
+tune_shape(
+        ttc_handler_s       *handler,
+        const ttc_param_s   *param,
+        const tune_sweep_s  *sweep,
+        FILE                *json_file,
+        const char          *csv_path,
+        uint32_t            *num_rows
+        ) {
+    size_t num_elem = 1;
+    uint32_t idx;
+    for (idx = 0; idx < param->dim; ++idx)
+        num_elem *= param->size[idx];
+
+    char *input = (char *)malloc(num_elem
+            * ttc_type_size(param->datatype, false));
+    char *result = (char *)malloc(num_elem
+            * ttc_type_size(param->datatype, true));
+    char *flush = (char *)malloc(TTC_TUNE_FLUSH_SIZE);
+    if (NULL == input || NULL == result || NULL == flush) {
+        free(input);
+        free(result);
+        free(flush);
+        return -1;
+    }
+    memset(input, 0, num_elem * ttc_type_size(param->datatype, false));
+
+    ttc_tune_s tune = {
+        .datatype = param->datatype, .dim = param->dim, .perm = param->perm,
+        .size = param->size, .loop_perm = NULL, .next = NULL
+    };
+
+    uint32_t impl_idx, blk_idx, dist_idx, thread_idx, status_idx;
+    for (impl_idx = 0; impl_idx < sweep->max_impl_len; ++impl_idx)
+    for (blk_idx = 0; blk_idx < sweep->blocking_len; ++blk_idx)
+    for (dist_idx = 0; dist_idx < sweep->pref_dist_len; ++dist_idx)
+    for (thread_idx = 0; thread_idx < sweep->num_threads_len; ++thread_idx)
+    for (status_idx = 0; status_idx < sweep->status_len; ++status_idx) {
+        tune.max_impl = sweep->max_impl[impl_idx];
+        tune.blocking[0] = sweep->blocking[blk_idx][0];
+        tune.blocking[1] = sweep->blocking[blk_idx][1];
+        tune.pref_dist = sweep->pref_dist[dist_idx];
+        tune.num_threads = sweep->num_threads[thread_idx];
+        tune.status = sweep->status[status_idx];
+
+        double time = ttc_tune_eval(&handler->options, param, &tune, input,
+                result, flush);
+        if (time <= 0.0) {
+            fprintf(stderr, "  Configuration failed.\n");
+            continue;
+        }
+        tune.bandwidth = ttc_param_bytes(param) / time * 1e-9;
+        fprintf(stderr, "  max_impl %u, blocking %ux%u, pref_dist %d, "
+                "threads %u, status %u: %.2f GB/s\n", tune.max_impl,
+                tune.blocking[0], tune.blocking[1], tune.pref_dist,
+                tune.num_threads, tune.status, tune.bandwidth);
+
+        if (NULL != json_file)
+            write_json_row(json_file, &tune, 0 == *num_rows);
+        else if (0 != ttc_tune_save(csv_path, &tune)) {
+            fprintf(stderr, "Cannot write %s.\n", csv_path);
+            continue;
+        }
+        ++*num_rows;
+    }
+
+    free(input);
+    free(result);
+    free(flush);
+
+    return 0;
+}
+
+
+void
+write_json_row(
+        FILE                *json_file,
+        const ttc_tune_s    *tune,
+        bool                first
+        ) {
+    uint32_t idx;
+    fprintf(json_file, "%s\n  { \"datatype\": %d, \"perm\": [",
+            first ? "" : ",", tune->datatype);
+    for (idx = 0; idx < tune->dim; ++idx)
+        fprintf(json_file, 0 == idx ? "%u" : ", %u", tune->perm[idx]);
+    fprintf(json_file, "], \"size\": [");
+    for (idx = 0; idx < tune->dim; ++idx)
+        fprintf(json_file, 0 == idx ? "%u" : ", %u", tune->size[idx]);
+    fprintf(json_file, "], \"max_impl\": %u, \"blocking\": [%u, %u], "
+            "\"pref_dist\": %d, \"num_threads\": %u, \"status\": %u, "
+            "\"bandwidth\": %f }", tune->max_impl, tune->blocking[0],
+            tune->blocking[1], tune->pref_dist, tune->num_threads,
+            tune->status, tune->bandwidth);
+}
+
+
+int32_t
+parse_uint_list(
+        const char  *str,
+        uint32_t    *arr,
+        uint32_t    *length
+        ) {
+    uint32_t count = 0;
+    char *end_ptr;
+    while (count < TUNE_MAX_VALUES) {
+        arr[count++] = strtoul(str, &end_ptr, 10);
+        if (end_ptr == str)
+            return -1;
+        if (',' != *end_ptr)
+            break;
+        str = end_ptr + 1;
+    }
+    if ('\0' != *end_ptr)
+        return -1;
+
+    *length = count;
+    return 0;
+}
+
+
+int32_t
+parse_blocking_list(
+        const char  *str,
+        uint32_t    (*arr)[2],
+        uint32_t    *length
+        ) {
+    uint32_t count = 0;
+    while (count < TUNE_MAX_VALUES) {
+        int read_len = 0;
+        if (2 != sscanf(str, "%ux%u%n", &arr[count][0], &arr[count][1],
+                    &read_len))
+            return -1;
+        ++count;
+        str += read_len;
+        if (',' != *str)
+            break;
+        ++str;
+    }
+    if ('\0' != *str)
+        return -1;
+
+    *length = count;
+    return 0;
+}
+
+
+int32_t
+parse_pref_dist_list(
+        const char  *str,
+        int32_t     *arr,
+        uint32_t    *length
+        ) {
+    uint32_t count = 0;
+    char *end_ptr = (char *)str;
+    while (count < TUNE_MAX_VALUES) {
+        if ('-' == *str) {
+            arr[count++] = -1;
+            end_ptr = (char *)str + 1;
+        }
+        else {
+            arr[count++] = strtol(str, &end_ptr, 10);
+            if (end_ptr == str)
+                return -1;
+        }
+        if (',' != *end_ptr)
+            break;
+        str = end_ptr + 1;
+    }
+    if ('\0' != *end_ptr)
+        return -1;
+
+    *length = count;
+    return 0;
+}
+
+
+int32_t
+parse_datatype(
+        const char      *str,
+        ttc_datatype_e  *datatype
+        ) {
+    const char *names[] = { "s", "d", "c", "z", "sd", "ds", "cz", "zc" };
+    const ttc_datatype_e types[] = { TTC_TYPE_S, TTC_TYPE_D, TTC_TYPE_C,
+        TTC_TYPE_Z, TTC_TYPE_SD, TTC_TYPE_DS, TTC_TYPE_CZ, TTC_TYPE_ZC };
+
+    uint32_t idx;
+    for (idx = 0; idx < sizeof(names) / sizeof(names[0]); ++idx)
+        if (0 == strcmp(str, names[idx])) {
+            *datatype = types[idx];
+            return 0;
+        }
+
+    return -1;
+}